@@ -24,7 +24,8 @@
 
 #include <stdint.h>
 #define COLOR_PALETTE_ROTATIONS (10)
-#define COLOR_PALETTES (3)
+#define COLOR_PALETTES (7)  // one colour per tetrimino piece
+#define COLOR_GARBAGE_INDEX (COLOR_PALETTES)  // palette index of garbage rows, after the tetrimino colours
 
 typedef struct {
     uint8_t red;
@@ -33,6 +34,7 @@ typedef struct {
 } color_t;
 
 extern const color_t color_lookup_table[COLOR_PALETTE_ROTATIONS][COLOR_PALETTES];  // Declare but don't define
+extern const color_t color_garbage;
 
 color_t get_color_palette(int current_level, int shape_id);
 
@@ -0,0 +1,44 @@
+/**
+ ******************************************************************************
+ * @file           : game_clock.h
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Pausable game clock, wall time minus the time spent paused
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+
+#ifndef INC_GAME_CLOCK_H_
+#define INC_GAME_CLOCK_H_
+
+#include <stdint.h>
+
+typedef enum {
+    GAME_CLOCK_OK = 0, GAME_CLOCK_ERROR
+} game_clock_status_t;
+
+typedef struct {
+    uint64_t offset; // wall time not counted, the start plus every pause (microseconds)
+    uint64_t pause_time; // wall time of the pause, the game time stays there while paused
+    uint8_t paused;
+} game_clock_t;
+
+void game_clock_init(game_clock_t *clock, uint64_t now);
+uint64_t game_clock_now(game_clock_t *clock, uint64_t now);
+game_clock_status_t game_clock_pause(game_clock_t *clock, uint64_t now);
+game_clock_status_t game_clock_resume(game_clock_t *clock, uint64_t now);
+uint8_t game_clock_paused(game_clock_t *clock);
+
+#endif /* INC_GAME_CLOCK_H_ */
@@ -24,7 +24,10 @@
 
 #include <stdio.h>
 
+// Host builds pass -DDEBUG_OUTPUT=0 to keep printf out of timing runs
+#ifndef DEBUG_OUTPUT
 #define DEBUG_OUTPUT 1
+#endif
 
 int _write(int file, char *ptr, int len);
 
@@ -21,6 +21,7 @@
 #define INC_LED_INDICATOR_H_
 
 #include "main.h"
+#include "timer_wheel.h"
 
 #define LED_MAX_DUTY 1000
 
@@ -59,14 +60,17 @@ typedef struct {
     uint32_t blink_off_delay;
     uint16_t blink_counter;
     led_fade_t fade_direction;
-    uint32_t start_time;
-    uint32_t end_time;
+    uint32_t start_time; // start of the current fade ramp
+    uint32_t end_time; // end of the current fade ramp
+    timer_wheel_timer_t blink_timer; // toggles the blink or reverses the fade
+    timer_wheel_t *timer_wheel; // runs on the htim_delay counter
 } led_indicator_t;
 
 // Function prototypes
-led_status_t led_init(led_indicator_t *led, GPIO_TypeDef *port, uint16_t pin, TIM_HandleTypeDef *htim_delay);
+led_status_t led_init(led_indicator_t *led, GPIO_TypeDef *port, uint16_t pin, TIM_HandleTypeDef *htim_delay,
+        timer_wheel_t *timer_wheel);
 led_status_t led_init_pwm(led_indicator_t *led, TIM_HandleTypeDef *htim, uint32_t channel,
-        TIM_HandleTypeDef *htim_delay);
+        TIM_HandleTypeDef *htim_delay, timer_wheel_t *timer_wheel);
 led_status_t led_set_mode(led_indicator_t *led, led_mode_t mode);
 led_status_t led_set_pwm_max_duty(led_indicator_t *led, uint32_t max_duty);
 led_status_t led_set_delay(led_indicator_t *led, uint16_t delay);
@@ -36,7 +36,16 @@ typedef enum {
     MATRIX_REACHED_BOTTOM
 } matrix_status_t;
 
+/*
+ * Board geometry
+ *
+ * The LED panel size and playfield width are the only parameters, every mask, shift and loop bound
+ * below is derived from them at compile time. Build the 16x16 panel variant (10x15 playfield) with
+ * -DMATRIX_HEIGHT=16 and a wider practice board with e.g. -DPLAYING_FIELD_WIDTH=12.
+ */
+#ifndef MATRIX_HEIGHT
 #define MATRIX_HEIGHT (32)
+#endif
 #define MATRIX_WIDTH (16)
 
 #if (MATRIX_HEIGHT < 32)
@@ -44,31 +53,65 @@ typedef enum {
 #else
 #define PLAYING_FIELD_HEIGHT (20)
 #endif
+#ifndef PLAYING_FIELD_WIDTH
 #define PLAYING_FIELD_WIDTH (10)
-#define PLAYING_FIELD_BOUNDARY_BITMAP (0xE007E007)  // boundary bitmap for boundary check
-#define PLAYING_FIELD_MASK (0x1FF81FF8)  // playfield mask for rendering without boundary
-#define PLAYING_FIELD_MASK_BOUNDARY (0x3FFC3FFC)  // playfield mask for rendering with boundary
-#define PLAYING_FIELD_ODD_MASK (0x1FF80000)  // playfield mask for odd rows
-#define PLAYING_FIELD_EVEN_MASK (0x00001FF8)  // playfield mask for even rows
-#define PLAYING_FIELD_FILLED_ROW_MASK (0x1FF8)  // playfield filled row mask for checking line clear
-#define MATRIX_DATA_SIZE (PLAYING_FIELD_HEIGHT >> 1)  // divide by 2 as each uint32_t holds 2 rows
-#define CLEAR_LINE_NUM_FRAMES (5)   // number of frames for line clear animation
-#define CLEAR_LINE_DELAY (100000)   // delay between line clear frames in microseconds
+#endif
+#define PLAYING_FIELD_BOUNDARY_WIDTH (3)  // boundary bits to the right of the playfield in each row
+
+// Smallest row type holding the playfield and a boundary on both sides
+#if (PLAYING_FIELD_WIDTH + 2 * PLAYING_FIELD_BOUNDARY_WIDTH <= 16)
+typedef uint16_t matrix_row_t;
+#else
+typedef uint32_t matrix_row_t;
+#endif
+
+#define PLAYING_FIELD_MASK ((matrix_row_t) (((1UL << PLAYING_FIELD_WIDTH) - 1) << PLAYING_FIELD_BOUNDARY_WIDTH))  // playfield mask for rendering without boundary
+#define PLAYING_FIELD_BOUNDARY_BITMAP ((matrix_row_t) ~PLAYING_FIELD_MASK)  // boundary bitmap for boundary check
+#define PLAYING_FIELD_MASK_BOUNDARY ((matrix_row_t) (((1UL << (PLAYING_FIELD_WIDTH + 2)) - 1) << (PLAYING_FIELD_BOUNDARY_WIDTH - 1)))  // playfield mask for rendering with boundary
+#define PLAYING_FIELD_FILLED_ROW_MASK (PLAYING_FIELD_MASK)  // playfield filled row mask for checking line clear
+#define PLAYING_FIELD_EDGE_MASK(n) ((matrix_row_t) ((((1UL << (n)) - 1) << PLAYING_FIELD_BOUNDARY_WIDTH) \
+        | (((1UL << (n)) - 1) << (PLAYING_FIELD_BOUNDARY_WIDTH + PLAYING_FIELD_WIDTH - (n)))))  // n columns on each side
+#define MATRIX_DATA_SIZE (PLAYING_FIELD_HEIGHT)  // one matrix_row_t per row, row 0 is the bottom row
+#define PLAYING_FIELD_COLUMN_BIT(c) ((matrix_row_t) 1 << (PLAYING_FIELD_BOUNDARY_WIDTH + PLAYING_FIELD_WIDTH - 1 - (c)))  // column 0 is the leftmost column
+#define MATRIX_PALETTE_PLANES (3)  // bit planes holding the 3-bit piece index of each stack cell
+#define CLEAR_LINE_NUM_FRAMES (PLAYING_FIELD_WIDTH / 2)   // number of frames for line clear animation
+#define CLEAR_LINE_DELAY_FRAMES (6)   // game frames between line clear animation frames, 0.1 seconds
+
+// Serialized stack: row count byte, then per row an empty flag bit or the cell bits and a color index per block
+#define MATRIX_SERIALIZED_MAX_SIZE (1 + (PLAYING_FIELD_HEIGHT * (1 + PLAYING_FIELD_WIDTH * (1 + MATRIX_PALETTE_PLANES)) + 7) / 8)
+#define MATRIX_TEXT_MAX_SIZE (PLAYING_FIELD_HEIGHT * (PLAYING_FIELD_WIDTH + 1) + 1)  // rows, separators and terminator
+#define MATRIX_TEXT_EMPTY '.'
+#define MATRIX_TEXT_ROW_SEPARATOR '/'
+
+_Static_assert(PLAYING_FIELD_WIDTH >= 4, "playfield must fit a horizontal I tetrimino");
+_Static_assert(PLAYING_FIELD_WIDTH + 2 <= MATRIX_WIDTH, "playfield and its side boundaries must fit the LED panel");
+_Static_assert(PLAYING_FIELD_HEIGHT + 1 <= MATRIX_HEIGHT, "playfield and its bottom boundary must fit the LED panel");
+_Static_assert(PLAYING_FIELD_HEIGHT <= 32, "line clear bitmaps hold one bit per row in a uint32_t");
+_Static_assert(PLAYING_FIELD_WIDTH + 2 * PLAYING_FIELD_BOUNDARY_WIDTH <= 8 * sizeof(matrix_row_t),
+        "matrix_row_t is too narrow for the playfield and its boundary");
 
 typedef struct {
     uint8_t frame_nbr;
-    uint32_t animation_timer_start;
-    uint32_t animation_timer_delay; // in microseonds
+    uint32_t animation_frame_count; // game frames since the last animation frame
+    uint8_t animation_frame_delay; // in game frames
 } matrix_animation_t;
 
+typedef struct {
+    uint8_t column_height[PLAYING_FIELD_WIDTH]; // row above the highest block in each column, 0 if empty
+    uint8_t max_height; // height of the tallest column
+    uint16_t block_count; // number of blocks in the stack
+    uint16_t hole_count; // empty cells below the top of their column
+} matrix_surface_t;
+
 typedef struct {
     uint8_t height;
     uint8_t width;
-    uint32_t playfield[MATRIX_DATA_SIZE];
-    uint32_t stack[MATRIX_DATA_SIZE];
-    uint32_t palette1[MATRIX_DATA_SIZE];
-    uint32_t palette2[MATRIX_DATA_SIZE];
+    matrix_row_t playfield[MATRIX_DATA_SIZE];
+    matrix_row_t stack[MATRIX_DATA_SIZE];
+    matrix_row_t palette[MATRIX_PALETTE_PLANES][MATRIX_DATA_SIZE];  // plane n holds bit n of the piece index
     matrix_animation_t animation;
+    matrix_surface_t surface; // kept up to date by merge_with_stack and matrix_reposition_blocks
+    uint32_t stack_hash; // XOR of the keys of all stack rows, kept up to date whenever the stack changes
     uint8_t tetris_flag;
     uint8_t flash_counter;
     uint8_t flash_flag;
@@ -79,16 +122,34 @@ typedef struct {
 matrix_status_t matrix_init();
 matrix_status_t matrix_clear(matrix_t *matrix);
 matrix_status_t matrix_reset_playfield(matrix_t *matrix);
+matrix_status_t matrix_piece_fits(matrix_t *matrix, tetrimino_piece_t piece, tetrimino_rotation_t rotation,
+        uint8_t x, uint8_t y);
 matrix_status_t matrix_add_tetrimino(matrix_t *matrix, tetrimino_t *tetrimino);
 matrix_status_t matrix_move_tetrimino(matrix_t *matrix, tetrimino_t *tetrimino,
         tetrimino_move_direction_t direction);
+matrix_status_t matrix_rotate_tetrimino(matrix_t *matrix, tetrimino_t *tetrimino, rotation_direction_t direction,
+        tetrimino_rotation_system_t rotation_system);
 matrix_status_t matrix_check_collision(matrix_t *matrix, tetrimino_t *tetrimino);
+uint8_t matrix_drop_distance(matrix_t *matrix, tetrimino_t *tetrimino);
 void matrix_debug_print(matrix_t *matrix);
 uint32_t matrix_check_line_clear(matrix_t *matrix);
-void matrix_line_clear_start(matrix_t *matrix, uint32_t delay);
-uint8_t matrix_line_clear_animate(matrix_t *matrix, uint32_t line_clear);
+uint32_t matrix_check_tetrimino_line_clear(matrix_t *matrix, tetrimino_t *tetrimino, uint8_t *lines);
+void matrix_line_clear_start(matrix_t *matrix, uint8_t delay_frames);
+uint8_t matrix_line_clear_animate(matrix_t *matrix, uint32_t line_clear, uint8_t frames);
 matrix_status_t merge_with_stack(matrix_t *matrix, tetrimino_t *tetrimino);
 matrix_status_t matrix_reposition_blocks(matrix_t *matrix, uint32_t line_clear);
 void matrix_copy(matrix_t *dest, matrix_t *src);
+void matrix_surface_recompute(matrix_t *matrix);
+uint8_t matrix_column_height(matrix_t *matrix, uint8_t column);
+uint8_t matrix_max_height(matrix_t *matrix);
+uint16_t matrix_hole_count(matrix_t *matrix);
+uint8_t matrix_well_depth(matrix_t *matrix, uint8_t column);
+void matrix_hash_recompute(matrix_t *matrix);
+uint32_t matrix_position_hash(matrix_t *matrix, tetrimino_t *tetrimino);
+matrix_status_t matrix_add_garbage(matrix_t *matrix, tetrimino_t *tetrimino, uint8_t rows, uint8_t hole_column);
+uint16_t matrix_serialize(matrix_t *matrix, uint8_t *buffer, uint16_t size);
+matrix_status_t matrix_deserialize(matrix_t *matrix, const uint8_t *buffer, uint16_t size);
+uint16_t matrix_serialize_text(matrix_t *matrix, char *buffer, uint16_t size);
+matrix_status_t matrix_deserialize_text(matrix_t *matrix, const char *text);
 
 #endif /* INC_MATRIX_H_ */
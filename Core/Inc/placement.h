@@ -0,0 +1,60 @@
+/**
+ ******************************************************************************
+ * @file           : placement.h
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Generator of every reachable final tetrimino placement
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef INC_PLACEMENT_H_
+#define INC_PLACEMENT_H_
+
+#include <stdint.h>
+#include "matrix.h"
+#include "tetrimino.h"
+#include "tetrimino_shape.h"
+
+#define PLACEMENT_Y_COUNT (PLAYING_FIELD_HEIGHT + TETRIMINO_CENTER_Y)  // tetrimino y positions that can fit
+// A resting y has a blocked y below it, so a column holds at most every other y position
+#define PLACEMENT_MAX_COUNT (TETRIMINO_ROTATION_COUNT * PLAYING_FIELD_WIDTH * ((PLACEMENT_Y_COUNT + 1) / 2))
+#define PLACEMENT_PERFT_MAX_DEPTH (4)  // placement lists kept for placement_perft, one per level
+
+_Static_assert(PLACEMENT_Y_COUNT <= 32, "one uint32_t bitmask holds every y position of a column");
+
+typedef enum {
+    PLACEMENT_OK = 0, PLACEMENT_ERROR, PLACEMENT_NO_SPAWN
+} placement_status_t;
+
+// Final resting pose of a tetrimino, the same coordinates as tetrimino_t
+typedef struct {
+    uint8_t rotation; // tetrimino_rotation_t, stored in one byte to keep the list small
+    uint8_t x;
+    uint8_t y;
+} placement_t;
+
+typedef struct {
+    tetrimino_piece_t piece;
+    uint16_t count;
+    placement_t placement[PLACEMENT_MAX_COUNT];
+} placement_list_t;
+
+placement_status_t placement_generate(matrix_t *matrix, tetrimino_t *tetrimino,
+        tetrimino_rotation_system_t rotation_system, placement_list_t *list);
+void placement_lock(matrix_t *matrix, tetrimino_piece_t piece, placement_t *placement);
+uint64_t placement_perft(matrix_t *matrix, const tetrimino_piece_t *pieces, uint8_t depth,
+        tetrimino_rotation_system_t rotation_system);
+
+#endif /* INC_PLACEMENT_H_ */
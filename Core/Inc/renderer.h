@@ -28,10 +28,22 @@
 #include "color_palette.h"
 #include "game_loop.h"
 #include "tetrimino.h"
-#define MAX_PLAYFIELD_HEIGHT (20)
-#define MAX_PLAYFIELD_WIDTH (MATRIX_WIDTH - 5)
+#include "timer_wheel.h"
 #define RENDERER_OFFSET_X (1)
 #define RENDERER_OFFSET_Y (1)
+#define MAX_PLAYFIELD_HEIGHT (PLAYING_FIELD_HEIGHT)
+#define MAX_PLAYFIELD_WIDTH (PLAYING_FIELD_WIDTH + RENDERER_OFFSET_X)  // column of the right boundary line
+
+// Next tetrimino preview in the rightmost 4 columns, only drawn if the playfield leaves room for it
+#define RENDERER_PREVIEW_X (MATRIX_WIDTH - 1)
+#define RENDERER_PREVIEW_Y (14)
+#define RENDERER_SHOW_PREVIEW (MAX_PLAYFIELD_WIDTH < RENDERER_PREVIEW_X - 3)
+
+// Set to true to draw a dimmed ghost of the tetrimino at its landing position
+#define RENDERER_GHOST_PIECE 1
+#define RENDERER_GHOST_DIM_SHIFT (3)  // ghost color is the piece color divided by 2^shift
+
+#define RENDERER_TOP_OUT_DELAY (100000) // microseconds between rows of the top out animation
 
 extern uint16_t lookup_table[MATRIX_HEIGHT][MATRIX_WIDTH];
 
@@ -49,13 +61,14 @@ typedef enum {
 typedef struct {
     uint8_t data_sent_flag;
     uint8_t brightness;
-    uint32_t time_last_sent;
-    uint32_t next_update_time;
+    uint64_t time_last_sent; // in microseconds (timebase_now)
+    uint64_t next_update_time; // in microseconds (timebase_now)
     uint32_t delay_length; // in microseconds (determines refresh rate)
     uint32_t rendering_time; // in microseconds (measures actual rendering time)
     uint8_t top_out_flag;  // flag for top out animation
     uint8_t top_out_frame; // frame for top out animation
-    uint32_t top_out_timer; // timer for top out animation
+    timer_wheel_timer_t top_out_timer; // timer for top out animation
+    timer_wheel_t *timer_wheel;
     uint16_t led_position;
     uint16_t num_leds;
     matrix_t *matrix;
@@ -70,7 +83,8 @@ renderer_status_t renderer_create_boundary(renderer_t *renderer);
 // Function prototypes for matrix rendering functions (e.g. matrix_rendering_init, matrix_rendering_render)
 
 renderer_status_t renderer_init(renderer_t *renderer, uint16_t lookup_table[MATRIX_HEIGHT][MATRIX_WIDTH],
-        matrix_t *matrix, led_t *led, TIM_HandleTypeDef *htim, const uint32_t channel, uint32_t delay_length);
+        matrix_t *matrix, led_t *led, TIM_HandleTypeDef *htim, const uint32_t channel, uint32_t delay_length,
+        timer_wheel_t *timer_wheel);
 renderer_status_t renderer_render(renderer_t *renderer, matrix_t *matrix, tetrimino_t *tetrimino,
         game_t *game);
 void renderer_clear(renderer_t *renderer);
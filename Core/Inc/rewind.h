@@ -0,0 +1,66 @@
+/**
+ ******************************************************************************
+ * @file           : rewind.h
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Rewind buffer of recent stack snapshots for practice mode
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef INC_REWIND_H_
+#define INC_REWIND_H_
+
+#include <stdint.h>
+#include "matrix.h"
+#include "tetrimino.h"
+
+#define REWIND_MAX_PIECES (64)  // locked pieces that can be stepped back
+#define REWIND_MAX_ROWS (256)   // delta rows shared by all pieces, the oldest pieces are dropped when full
+
+typedef enum {
+    REWIND_OK = 0, REWIND_ERROR, REWIND_EMPTY
+} rewind_status_t;
+
+// Change of one stack row, XOR of the row before and after a piece locked
+typedef struct {
+    uint8_t row;
+    matrix_row_t stack;
+    matrix_row_t palette[MATRIX_PALETTE_PLANES];
+} rewind_row_t;
+
+typedef struct {
+    uint16_t first_row; // index of the first delta row in the row pool
+    uint8_t row_count;
+    uint8_t piece; // tetrimino that locked, it is played again after stepping back
+} rewind_entry_t;
+
+// RAM use is sizeof(rewind_t), fixed at build time by the two limits above
+typedef struct {
+    rewind_entry_t entry[REWIND_MAX_PIECES];
+    rewind_row_t row[REWIND_MAX_ROWS];
+    matrix_row_t stack[MATRIX_DATA_SIZE]; // stack at the newest snapshot, the next delta is taken against it
+    matrix_row_t palette[MATRIX_PALETTE_PLANES][MATRIX_DATA_SIZE];
+    uint16_t entry_head; // next entry to write
+    uint16_t entry_count;
+    uint16_t row_head; // next delta row to write
+    uint16_t row_count; // delta rows used by the stored entries
+} rewind_t;
+
+rewind_status_t rewind_init(rewind_t *rewind, matrix_t *matrix);
+rewind_status_t rewind_push(rewind_t *rewind, matrix_t *matrix, tetrimino_piece_t piece);
+rewind_status_t rewind_restore(rewind_t *rewind, matrix_t *matrix, uint8_t pieces, tetrimino_piece_t *piece);
+uint16_t rewind_count(rewind_t *rewind);
+
+#endif /* INC_REWIND_H_ */
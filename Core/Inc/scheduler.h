@@ -0,0 +1,87 @@
+/**
+ ******************************************************************************
+ * @file           : scheduler.h
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Cooperative task scheduler with per-task timing statistics
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef INC_SCHEDULER_H_
+#define INC_SCHEDULER_H_
+
+#include <stdint.h>
+
+typedef enum {
+    SCHEDULER_OK = 0, SCHEDULER_ERROR
+} scheduler_status_t;
+
+// Microsecond clock read by the dispatcher, the low half of the timebase on the board or a fake clock on a host
+typedef uint32_t (*scheduler_clock_t)(void);
+
+typedef void (*scheduler_task_run_t)(void *context);
+
+// Sleeps until the wake time or until any interrupt, whichever comes first (WFI on the board), returns the
+// microseconds of the sleep spent in the interrupt handlers that woke it, they are counted as busy
+typedef uint32_t (*scheduler_sleep_t)(uint32_t wake_time);
+
+typedef struct {
+    uint32_t runs;
+    uint32_t run_time_worst; // in microseconds
+    uint64_t run_time_total; // in microseconds, for the average
+    uint32_t deadline_misses; // runs that finished later than the deadline after their release
+    uint32_t releases_skipped; // releases dropped because the task fell a whole period behind
+} scheduler_task_stats_t;
+
+typedef struct {
+    // Set in the task table
+    const char *name;
+    scheduler_task_run_t run;
+    void *context; // passed to run
+    uint32_t period; // in microseconds, 0 runs the task on every dispatch
+    uint32_t phase; // in microseconds, offset of the first release from scheduler_init
+    uint8_t priority; // 0 is the highest, due tasks run in priority order
+    uint32_t deadline; // in microseconds after the release, 0 uses the period
+    // Kept by the scheduler
+    uint32_t release_time; // time the next run is due
+    scheduler_task_stats_t stats;
+} scheduler_task_t;
+
+typedef struct {
+    uint32_t wake_time; // end of the last sleep, the time since is busy
+    uint64_t busy_time; // in microseconds since the stats were reset
+    uint64_t idle_time; // in microseconds slept since the stats were reset
+    uint64_t window_busy_time; // in microseconds since the last scheduler_load
+    uint64_t window_idle_time;
+} scheduler_load_t;
+
+typedef struct {
+    scheduler_task_t *tasks;
+    uint8_t task_count;
+    scheduler_clock_t clock;
+    scheduler_load_t load;
+} scheduler_t;
+
+scheduler_status_t scheduler_init(scheduler_t *scheduler, scheduler_task_t *tasks, uint8_t task_count,
+        scheduler_clock_t clock);
+uint8_t scheduler_dispatch(scheduler_t *scheduler);
+scheduler_status_t scheduler_next_release(scheduler_t *scheduler, uint32_t *time);
+void scheduler_idle(scheduler_t *scheduler, uint32_t wake_time, scheduler_sleep_t sleep);
+uint16_t scheduler_load(scheduler_t *scheduler);
+uint32_t scheduler_task_average(scheduler_task_t *task);
+void scheduler_reset_stats(scheduler_t *scheduler);
+void scheduler_debug_print(scheduler_t *scheduler);
+
+#endif /* INC_SCHEDULER_H_ */
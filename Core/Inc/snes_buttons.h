@@ -0,0 +1,39 @@
+/**
+ ******************************************************************************
+ * @file           : snes_buttons.h
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : SNES controller button masks, shared with code that does not use the HAL
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef INC_SNES_BUTTONS_H_
+#define INC_SNES_BUTTONS_H_
+
+// Defines for shift register bit order and button mapping (B, Y, Select, Start, Up, Down, Left, Right, A, X, L, R)
+#define SNES_BUTTON_B	(1 << 15)
+#define SNES_BUTTON_Y	(1 << 14)
+#define SNES_BUTTON_SELECT	(1 << 13)
+#define SNES_BUTTON_START	(1 << 12)
+#define SNES_BUTTON_UP	(1 << 11)
+#define SNES_BUTTON_DOWN	(1 << 10)
+#define SNES_BUTTON_LEFT	(1 << 9)
+#define SNES_BUTTON_RIGHT	(1 << 8)
+#define SNES_BUTTON_A	(1 << 7)
+#define SNES_BUTTON_X	(1 << 6)
+#define SNES_BUTTON_L	(1 << 5)
+#define SNES_BUTTON_R	(1 << 4)
+
+#endif /* INC_SNES_BUTTONS_H_ */
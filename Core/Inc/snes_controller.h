@@ -23,6 +23,7 @@
 #define INC_SNES_CONTROLLER_H_
 
 #include "main.h"
+#include "snes_buttons.h"
 
 typedef enum {
     SNES_CONTROLLER_OK = 0,
@@ -42,21 +43,8 @@ typedef enum {
     SNES_CONTROLLER_DAS_ACTIVE_ENQUEUE,
 } snes_controller_das_status_t;
 
-// Defines for shift register bit order and button mapping (B, Y, Select, Start, Up, Down, Left, Right, A, X, L, R)
-#define SNES_BUTTON_B	(1 << 15)
-#define SNES_BUTTON_Y	(1 << 14)
-#define SNES_BUTTON_SELECT	(1 << 13)
-#define SNES_BUTTON_START	(1 << 12)
-#define SNES_BUTTON_UP	(1 << 11)
-#define SNES_BUTTON_DOWN	(1 << 10)
-#define SNES_BUTTON_LEFT	(1 << 9)
-#define SNES_BUTTON_RIGHT	(1 << 8)
-#define SNES_BUTTON_A	(1 << 7)
-#define SNES_BUTTON_X	(1 << 6)
-#define SNES_BUTTON_L	(1 << 5)
-#define SNES_BUTTON_R	(1 << 4)
-
-#define SNES_DAS_DELAY (100000) // 10Hz default repeat rate (Classic NES Tetris)
+#define SNES_DAS_START_FRAMES (16) // frames before a held button starts repeating (Classic NES Tetris)
+#define SNES_DAS_REPEAT_FRAMES (6) // frames between repeats, 10Hz (Classic NES Tetris)
 
 typedef struct {
     GPIO_TypeDef *latch_port;
@@ -68,9 +56,9 @@ typedef struct {
     uint16_t buttons_state;
     uint16_t previous_buttons_state;
     uint8_t read_rate; // in Hz
-    uint32_t time_last_read;
+    uint64_t time_last_read; // in microseconds (timebase_now)
     uint32_t delay_length;
-    uint32_t time_expire;
+    uint64_t time_expire; // in microseconds (timebase_now)
     uint8_t led_state;
 } snes_controller_t;
 
@@ -80,9 +68,9 @@ typedef struct {
     uint16_t buttons_state;
     uint16_t previous_buttons_state;
     uint8_t repeat_rate; // in Hz
-    uint32_t repeat_start_time;
-    uint32_t repeat_start_delay; // delay before repeat starts (in microseconds)
-    uint32_t repeat_delay; // in microseconds (based on repeat rate)
+    uint32_t repeat_frame_count; // game frames since the press or the last repeat
+    uint8_t repeat_start_delay; // delay before repeat starts (in game frames)
+    uint8_t repeat_delay; // in game frames (based on repeat rate)
 } snes_controller_das_t;
 
 snes_controller_status_t snes_controller_init(snes_controller_t *controller, GPIO_TypeDef *latch_port,
@@ -93,7 +81,9 @@ snes_controller_das_status_t snes_controller_delayed_auto_shift_init(snes_contro
 snes_controller_status_t snes_controller_latch(snes_controller_t *controller);
 snes_controller_status_t snes_controller_clock(snes_controller_t *controller, GPIO_PinState state);
 snes_controller_status_t snes_controller_read(snes_controller_t *controller);
-void snes_controller_delayed_auto_shift(snes_controller_das_t *repeater, snes_controller_t *controller);
+snes_controller_status_t snes_controller_poll(snes_controller_t *controller);
+void snes_controller_delayed_auto_shift(snes_controller_das_t *repeater, snes_controller_t *controller,
+        uint8_t frames);
 void snes_controller_print(snes_controller_t *controller);
 
 #endif /* INC_SNES_CONTROLLER_H_ */
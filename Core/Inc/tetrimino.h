@@ -48,9 +48,14 @@ typedef enum {
 } tetrimino_rotation_t;
 
 typedef enum {
-    ROTATE_CCW = 0, ROTATE_CW
+    ROTATE_CCW = 0, ROTATE_CW, ROTATE_DIRECTION_COUNT
 } rotation_direction_t;
 
+// Rotation systems, NES has no wall kicks, SRS tries up to 5 kick offsets per rotation
+typedef enum {
+    TETRIMINO_ROTATION_SYSTEM_NES = 0, TETRIMINO_ROTATION_SYSTEM_SRS
+} tetrimino_rotation_system_t;
+
 // For the tetrimino direction movement
 typedef enum {
     MOVE_RIGHT, MOVE_LEFT, MOVE_DOWN, MOVE_UP
@@ -70,8 +75,9 @@ typedef struct {
 tetrimino_status_t tetrimino_init(tetrimino_t *tetrimino);
 tetrimino_status_t tetrimino_rotate(tetrimino_t *tetrimino, rotation_direction_t direction);
 tetrimino_status_t tetrimino_next(tetrimino_t *tetrimino);
+tetrimino_status_t tetrimino_spawn_piece(tetrimino_t *tetrimino, tetrimino_piece_t piece);
 tetrimino_status_t tetrimino_copy(tetrimino_t *dst, tetrimino_t *src);
-uint32_t tetrimino_drop_speed(uint8_t level);
+uint8_t tetrimino_drop_frames(uint8_t level);
 void tetrimino_debug_print(tetrimino_t *tetrimino);
 
 #endif /* INC_TETRIMINO_H_ */
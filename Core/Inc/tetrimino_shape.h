@@ -10,14 +10,24 @@
 
 #include <stdint.h>
 #include "tetrimino.h"
+#include "matrix.h"
 
 #define TETRIMINO_BLOCK_SIZE  (5)  // 5x5 block
 #define TETRIMINO_CENTER_X    (2)
 #define TETRIMINO_CENTER_Y    (2)
 #define TETRIMINO_MASK        (0x1F)
+#define TETRIMINO_SHAPE_COUNT (19) // number of distinct shapes in tetrimino_shape
+#define TETRIMINO_KICK_COUNT  (5)  // kick offsets tried per rotation, the first one is no kick
+
+typedef struct {
+    int8_t x;  // columns to the right
+    int8_t y;  // rows up
+} tetrimino_kick_t;
 
 extern const uint8_t tetrimino_shape[];
+extern const matrix_row_t tetrimino_row_mask[PLAYING_FIELD_WIDTH][TETRIMINO_SHAPE_COUNT * TETRIMINO_BLOCK_SIZE];
 extern const uint8_t tetrimino_shape_offset_lut[TETRIMINO_COUNT][TETRIMINO_ROTATION_COUNT];
+extern const tetrimino_kick_t tetrimino_srs_kick[TETRIMINO_COUNT][TETRIMINO_ROTATION_COUNT][ROTATE_DIRECTION_COUNT][TETRIMINO_KICK_COUNT];
 extern const uint8_t tetrimino_spawn[TETRIMINO_COUNT];
 extern const uint8_t tetrimino_preview[TETRIMINO_COUNT];
 
@@ -0,0 +1,181 @@
+/**
+ ******************************************************************************
+ * @file           : tetris_engine.h
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Gameplay engine for Classic Tetris on LED Grid, free of HAL and peripheral calls
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef INC_TETRIS_ENGINE_H_
+#define INC_TETRIS_ENGINE_H_
+
+#include <stdint.h>
+#include "matrix.h"
+#include "tetrimino.h"
+#include "rewind.h"
+#include "ring_buffer.h"
+
+// Set to true to allow L/R button to change tetrimino piece
+#define TEST_TETRIMINO_CHANGE 0
+
+// Set to true to allow Y/X to change levels
+#define TEST_LEVEL_CHANGE 0
+
+// Set to true to allow Y/X to rotate tetrimino pieces like B/A buttons
+#define YX_ROTATE_TETRIMINO 1
+
+// Set to true to push a garbage row in from the bottom with the SELECT button
+#define TEST_GARBAGE_RISE 0
+
+// Set to true to step back one locked piece with the L button (practice mode)
+#define PRACTICE_REWIND 0
+
+#if PRACTICE_REWIND && TEST_TETRIMINO_CHANGE
+#error "PRACTICE_REWIND and TEST_TETRIMINO_CHANGE both use the L button"
+#endif
+
+// Set to true to hard drop and lock the tetrimino with the UP button
+#define HARD_DROP_ON_UP 1
+
+// Rotation system of a new game, TETRIMINO_ROTATION_SYSTEM_NES (no wall kicks) or TETRIMINO_ROTATION_SYSTEM_SRS
+#define ROTATION_SYSTEM_DEFAULT TETRIMINO_ROTATION_SYSTEM_NES
+
+// Gameplay timing counts NES frames (60.0988 Hz), the frame clock is checked once per loop
+#define TETRIS_ENGINE_FRAME_PERIOD (16639)   // microseconds per frame, 16639.27 us at 60.0988 Hz rounded down
+#define TETRIS_ENGINE_MAX_FRAME_TICKS (60)   // frames caught up at most after a stall, the rest is dropped
+#define TETRIS_ENGINE_LOCK_FRAMES (30)       // frames on the stack before the tetrimino locks, half a second
+#define TETRIS_ENGINE_SOFT_DROP_FRAMES (2)   // frames per row while DOWN is held, unless gravity is faster
+
+typedef enum {
+    TETRIS_ENGINE_OK = 0, TETRIS_ENGINE_ERROR
+} tetris_engine_status_t;
+
+// Events returned by tetris_engine_step, several can be set by one step
+typedef enum {
+    TETRIS_ENGINE_EVENT_NONE = 0,
+    TETRIS_ENGINE_EVENT_LOCK = (1 << 0), // tetrimino merged into the stack
+    TETRIS_ENGINE_EVENT_LINE_CLEAR_START = (1 << 1), // completed lines found, animation started
+    TETRIS_ENGINE_EVENT_LINE_CLEAR = (1 << 2), // animation done, lines removed and scored
+    TETRIS_ENGINE_EVENT_LEVEL_UP = (1 << 3),
+    TETRIS_ENGINE_EVENT_SPAWN = (1 << 4), // next tetrimino taken, also set when it tops out
+    TETRIS_ENGINE_EVENT_TOP_OUT = (1 << 5),
+    TETRIS_ENGINE_EVENT_REWIND = (1 << 6), // stack stepped back one piece (PRACTICE_REWIND)
+    TETRIS_ENGINE_EVENT_PAUSE = (1 << 7) // START pressed, the caller pauses after the rest of the step
+} tetris_engine_event_t;
+
+typedef enum {
+    GAME_STATE_SPLASH = 0,
+    GAME_STATE_SPLASH_WAIT,
+    GAME_STATE_MENU,
+    GAME_STATE_PLAY_MENU,
+    GAME_STATE_PREPARE_GAME,
+    GAME_STATE_GAME_IN_PROGRESS,
+    GAME_STATE_PAUSE,
+    GAME_STATE_GAME_ENDED,
+    GAME_STATE_GAME_OVER_WAIT,
+    GAME_STATE_HIGH_SCORE,
+    GAME_STATE_SETTINGS,
+    GAME_STATE_TEST_FEATURE,
+    GAME_STATE_CREDITS
+} game_state_t;
+
+typedef enum {
+    PLAY_STATE_NOT_STARTED = 0,
+    PLAY_STATE_NORMAL,
+    PLAY_STATE_HALF_SECOND_B4_LOCK,
+    PLAY_STATE_LOCKED,
+    PLAY_STATE_LINE_CLEAR,
+    PLAY_STATE_TRANSITION_LEVEL,
+    PLAY_STATE_NEXT_TETRIMINO,
+    PLAY_STATE_TOP_OUT,
+    PLAY_STATE_GAME_OVER,
+    PLAY_STATE_HIGH_SCORE,
+    PLAY_STATE_PAUSE
+} play_state_t;
+
+typedef struct {
+    uint16_t singles;
+    uint16_t doubles;
+    uint16_t triples;
+    uint16_t tetrises;
+    uint16_t tetrimino_count[TETRIMINO_COUNT];
+} game_stats_t;
+
+typedef struct {
+    game_state_t state;
+    play_state_t play_state;
+    uint32_t score;
+    uint32_t level;
+    uint32_t lines;
+    game_stats_t stats;
+    tetrimino_rotation_system_t rotation_system; // wall kicks used when rotating
+    uint8_t soft_drop_flag; // 1 if soft drop is active
+    uint8_t soft_drop_lines; // Number of lines soft dropped
+    int16_t lines_to_next_level; // Number of lines to clear to move to the next level
+    uint8_t drop_frames_normal; // in frames (determines drop speed)
+    uint8_t drop_frames_soft_drop; // in frames (determines drop speed if DOWN is pressed)
+    uint8_t drop_frames; // in frames (current delay for normal or soft drop)
+    uint32_t drop_frame_count; // frames since the tetrimino last moved down
+    uint8_t lock_frames; // in frames (determines lock length)
+    uint32_t lock_frame_count; // frames since the tetrimino landed
+    uint32_t frame_count; // frames since the game started
+    uint64_t game_start_time; // game clock time when the game started, to calculate elapsed time
+} game_t;
+
+// Controller reading queued for the game, by the input task or by DAS
+typedef struct {
+    uint16_t buttons; // SNES_BUTTON_* reading, or the button of a DAS repeat
+    uint8_t repeat; // 1 if a DAS repeat, the held buttons do not change
+    uint32_t time; // microseconds when read, for the input latency
+} tetris_engine_reading_t;
+
+// Controller input of one frame, every reading queued since the previous frame merged in order
+typedef struct {
+    uint16_t held; // SNES_BUTTON_* mask down after the last reading
+    uint16_t pressed; // went down during the frame, kept if released again in the same frame
+    uint16_t released; // went up during the frame
+    int8_t shift; // LEFT presses and repeats count -1, RIGHT +1, net columns to move
+} tetris_engine_input_t;
+
+typedef struct {
+    uint32_t readings; // controller readings drained, DAS repeats not counted
+    uint32_t coalesced; // readings merged into a frame that already had one
+    uint32_t latency_worst; // microseconds from a reading to the frame that used it
+    uint64_t latency_total; // in microseconds, for the average
+    uint32_t late; // readings more than a frame old when drained
+} tetris_engine_input_stats_t;
+
+typedef struct {
+    game_t *game;
+    matrix_t *matrix;
+    tetrimino_t *tetrimino;
+#if PRACTICE_REWIND
+    rewind_t rewind;
+#endif
+    uint32_t lines_to_be_cleared; // bitmap of the lines being animated
+    uint8_t lines_cleared_count;
+} tetris_engine_t;
+
+tetris_engine_status_t tetris_engine_init(tetris_engine_t *engine, game_t *game, matrix_t *matrix,
+        tetrimino_t *tetrimino);
+tetris_engine_status_t tetris_engine_start(tetris_engine_t *engine);
+uint16_t tetris_engine_step(tetris_engine_t *engine, tetris_engine_input_t *input, uint8_t frames);
+uint8_t tetris_engine_frame_ticks(uint32_t *frame_time, uint32_t now);
+void tetris_engine_input_reset(tetris_engine_input_t *input, uint16_t held);
+uint8_t tetris_engine_input_drain(tetris_engine_input_t *input, RingBuffer *queue, uint32_t now,
+        tetris_engine_input_stats_t *stats);
+
+#endif /* INC_TETRIS_ENGINE_H_ */
@@ -0,0 +1,39 @@
+/**
+ ******************************************************************************
+ * @file           : timebase.h
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : 64-bit microsecond timebase extended from a wrapping 32-bit counter
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+
+#ifndef INC_TIMEBASE_H_
+#define INC_TIMEBASE_H_
+
+#include <stdint.h>
+
+// Free-running 32-bit microsecond counter, TIM2 on the board or a fake counter on a host
+typedef struct {
+    uint32_t (*counter)(void); // current count
+    uint8_t (*overflow_pending)(void); // 1 if the counter wrapped and timebase_overflow has not run yet
+} timebase_clock_t;
+
+void timebase_init(const timebase_clock_t *clock);
+void timebase_overflow(void);
+uint64_t timebase_now(void);
+uint32_t timebase_now32(void);
+
+#endif /* INC_TIMEBASE_H_ */
@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ * @file           : timer_wheel.h
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Hashed timer wheel for one-shot deadlines with callbacks
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef INC_TIMER_WHEEL_H_
+#define INC_TIMER_WHEEL_H_
+
+#include <stdint.h>
+
+#define TIMER_WHEEL_TICK_SHIFT (10)  // 1024 us per tick, a timer fires at most one tick late
+#define TIMER_WHEEL_SLOTS (256)      // power of 2, timers further out than 262 ms go around more than once
+#define TIMER_WHEEL_SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+typedef enum {
+    TIMER_WHEEL_OK = 0, TIMER_WHEEL_ERROR, TIMER_WHEEL_EMPTY
+} timer_wheel_status_t;
+
+typedef enum {
+    TIMER_WHEEL_TIMER_IDLE = 0, TIMER_WHEEL_TIMER_ARMED, TIMER_WHEEL_TIMER_EXPIRED // expired, callback not run yet
+} timer_wheel_timer_state_t;
+
+typedef void (*timer_wheel_callback_t)(void *context);
+
+// Owned by the caller (usually inside the struct of the module using it), the wheel only links it
+typedef struct timer_wheel_timer_s {
+    struct timer_wheel_timer_s *next;
+    struct timer_wheel_timer_s *prev;
+    uint32_t expiry; // in microseconds
+    uint16_t slot;
+    timer_wheel_timer_state_t state;
+    timer_wheel_callback_t callback;
+    void *context; // passed to callback
+} timer_wheel_timer_t;
+
+typedef struct {
+    timer_wheel_timer_t *slot[TIMER_WHEEL_SLOTS];
+    uint32_t occupied[TIMER_WHEEL_SLOTS / 32]; // bit per non-empty slot
+    timer_wheel_timer_t *expired; // timers taken off the wheel whose callbacks are running
+    uint32_t tick; // last tick walked
+    uint32_t next_expiry; // end of the first tick with a timer, in microseconds
+    uint16_t count; // armed timers
+} timer_wheel_t;
+
+timer_wheel_status_t timer_wheel_init(timer_wheel_t *wheel, uint32_t now);
+void timer_wheel_timer_init(timer_wheel_timer_t *timer, timer_wheel_callback_t callback, void *context);
+timer_wheel_status_t timer_wheel_arm(timer_wheel_t *wheel, timer_wheel_timer_t *timer, uint32_t now,
+        uint32_t delay);
+timer_wheel_status_t timer_wheel_cancel(timer_wheel_t *wheel, timer_wheel_timer_t *timer);
+uint8_t timer_wheel_armed(timer_wheel_timer_t *timer);
+timer_wheel_status_t timer_wheel_next_expiry(timer_wheel_t *wheel, uint32_t *time);
+uint16_t timer_wheel_advance(timer_wheel_t *wheel, uint32_t now);
+
+#endif /* INC_TIMER_WHEEL_H_ */
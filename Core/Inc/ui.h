@@ -26,6 +26,7 @@
 #include "snes_controller.h"
 #include "eeprom.h"
 #include "tetris.h"
+#include "timer_wheel.h"
 
 #define UI_STATS_NUM_FRAMES (3) // Number of frames for statistics animation
 #define UI_STATS_DELAY (1500000) // Delay between statistics frames in microseconds
@@ -48,21 +49,21 @@ typedef struct {
     ui_state_t ui_status;
     uint8_t ui_menu_list_size;
     uint8_t offset_num;
-    uint32_t cursor_start_time;
+    timer_wheel_timer_t cursor_timer; // blinks the cursor every cursor_timeout
 } ui_menu_t;
 
 // TODO: Typedef constants in enum for menu selection (e.g. MAIN_MENU, GAME_PROGRESS, GAME_OVER)
 
 // Typedef for displaying statistics (e.g. game_t)
 typedef struct {
-    uint32_t animate_start_time;
-    uint32_t animate_delay;
+    timer_wheel_timer_t animate_timer;
+    uint8_t animate_due; // set by animate_timer, the next frame is drawn on the next update
     uint8_t animate_frame;
     tetris_statistics_t *stats;
 } ui_stats_t;
 
 // TODO: Function prototypes for UI functions (e.g. ui_init, ui_main_menu_selection, ui_game_progress, ui_game_over_screen)
-void ui_init();
+void ui_init(tetris_statistics_t *stats, timer_wheel_t *timer_wheel);
 void ui_menu_init(ui_menu_t *menu);
 void ui_menu_id_set(ui_menu_t *menu, int menuID);
 void ui_reset_ui_stats();
@@ -84,6 +85,7 @@ void ui_display_high_scores(game_high_score_t *high_scores[], game_t *game);
 void frame_maker();
 
 void ui_display_fps(uint32_t start_count, uint32_t end_count, uint32_t time_us);
+void ui_display_cpu_load(uint16_t load);
 void ui_display_game_progress(game_t *game);
 void ui_display_game_info(game_t *game);
 void ui_display_top_out();
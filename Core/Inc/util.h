@@ -32,5 +32,6 @@ void util_to_binary32(uint32_t num, char *binary);
 void util_to_binary16(uint16_t num, char *binary);
 void util_to_binary8(uint8_t num, char *binary);
 uint8_t util_bit_count(uint32_t num);
+uint32_t util_hash32(uint32_t num);
 
 #endif /* INC_UTIL_H_ */
@@ -23,17 +23,18 @@
 
 //@formatter:off
 
+// Piece order: T, J, Z, O, S, L, I. T/O/I, J/S and Z/L share the classic NES colour groups
 const color_t color_lookup_table[COLOR_PALETTE_ROTATIONS][COLOR_PALETTES] = {
-    {{150, 150, 150}, {0, 50, 150}, {150, 50, 0}},         // level 0: white, medium blue, vivid orange
-    {{150, 150, 150}, {200, 0, 0}, {0, 50, 150}},         // level 1: white, amber, bright blue
-    {{150, 150, 150}, {150, 0, 150}, {0, 150, 100}},        // level 2: white, magenta, teal fix
-    {{150, 150, 150}, {50, 50, 150}, {150, 0, 150}},        // level 3: white, cyan, purple fix
-    {{150, 150, 150}, {150, 0, 150}, {0, 150, 50}},         // level 4: white, purple, bright green ok
-    {{150, 150, 150}, {150, 75, 0}, {0, 75, 150}},        // level 5: white, orange, sky blue ok
-    {{150, 150, 150}, {0, 100, 0}, {0, 0, 100}},      // level 6: white, olive, rose ok
-    {{150, 150, 150}, {150, 50, 0}, {0, 50, 150}},          // level 7: white, brown, navy ok
-    {{150, 150, 150}, {0, 50, 150}, {150, 50, 0}},          // level 8: white, sky blue, brown ok
-    {{150, 150, 150}, {150, 0, 50}, {50, 150, 0}}           // level 9: white, rose, bright green
+    {{150, 150, 150}, {0, 50, 150}, {150, 50, 0}, {150, 150, 150}, {0, 50, 150}, {150, 50, 0}, {150, 150, 150}}, // level 0: white, medium blue, vivid orange
+    {{150, 150, 150}, {200, 0, 0}, {0, 50, 150}, {150, 150, 150}, {200, 0, 0}, {0, 50, 150}, {150, 150, 150}}, // level 1: white, amber, bright blue
+    {{150, 150, 150}, {150, 0, 150}, {0, 150, 100}, {150, 150, 150}, {150, 0, 150}, {0, 150, 100}, {150, 150, 150}}, // level 2: white, magenta, teal fix
+    {{150, 150, 150}, {50, 50, 150}, {150, 0, 150}, {150, 150, 150}, {50, 50, 150}, {150, 0, 150}, {150, 150, 150}}, // level 3: white, cyan, purple fix
+    {{150, 150, 150}, {150, 0, 150}, {0, 150, 50}, {150, 150, 150}, {150, 0, 150}, {0, 150, 50}, {150, 150, 150}}, // level 4: white, purple, bright green ok
+    {{150, 150, 150}, {150, 75, 0}, {0, 75, 150}, {150, 150, 150}, {150, 75, 0}, {0, 75, 150}, {150, 150, 150}}, // level 5: white, orange, sky blue ok
+    {{150, 150, 150}, {0, 100, 0}, {0, 0, 100}, {150, 150, 150}, {0, 100, 0}, {0, 0, 100}, {150, 150, 150}}, // level 6: white, olive, rose ok
+    {{150, 150, 150}, {150, 50, 0}, {0, 50, 150}, {150, 150, 150}, {150, 50, 0}, {0, 50, 150}, {150, 150, 150}}, // level 7: white, brown, navy ok
+    {{150, 150, 150}, {0, 50, 150}, {150, 50, 0}, {150, 150, 150}, {0, 50, 150}, {150, 50, 0}, {150, 150, 150}}, // level 8: white, sky blue, brown ok
+    {{150, 150, 150}, {150, 0, 50}, {50, 150, 0}, {150, 150, 150}, {150, 0, 50}, {50, 150, 0}, {150, 150, 150}}  // level 9: white, rose, bright green
 };
 
 //const color_t color_lookup_table[COLOR_PALETTE_ROTATIONS][COLOR_PALETTES] = {
@@ -49,9 +50,15 @@ const color_t color_lookup_table[COLOR_PALETTE_ROTATIONS][COLOR_PALETTES] = {
 //    {{160, 160, 160}, {255, 180, 64}, {220, 32, 32}}       // level 9: soft white, warm orange, strong red
 //};
 
+// Garbage rows keep the same dim grey on every level
+const color_t color_garbage = {40, 40, 40};
 
 //@formatter:on
 color_t get_color_palette(int current_level, int shape_id) {
+    if (shape_id == COLOR_GARBAGE_INDEX) {
+        return color_garbage;
+    }
+
     int rotation_index = current_level % COLOR_PALETTE_ROTATIONS;
     int shape_id_index = shape_id % COLOR_PALETTES;
 
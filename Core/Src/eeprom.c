@@ -31,6 +31,7 @@
  */
 
 #include "eeprom.h"
+#include "matrix.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -221,7 +222,7 @@ eeprom_status_t eeprom_write_settings(eeprom_t *eeprom, saved_settings_t *settin
 
 void eeprom_get_default_settings(saved_settings_t *settings) {
     // Initialize settings
-    settings->grid_size = 16;
+    settings->grid_size = MATRIX_HEIGHT;
     settings->brightness = 50;
 }
 
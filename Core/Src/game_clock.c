@@ -0,0 +1,93 @@
+/**
+ ******************************************************************************
+ * @file           : game_clock.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Pausable game clock, wall time minus the time spent paused
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+
+#include <stdint.h>
+#include "game_clock.h"
+
+/*
+ * Everything that times gameplay (gravity, lock delay, line clear animation, DAS and the elapsed game
+ * time) counts frames or microseconds of the game clock instead of the timebase. Pausing freezes the
+ * game clock, so those timers stop where they are without being touched, and resuming moves the
+ * offset once whatever number of timers is running.
+ */
+
+/**
+ * @brief  Start the game clock at 0, running
+ * @param  clock, wall time in microseconds (timebase_now)
+ * @retval None
+ */
+void game_clock_init(game_clock_t *clock, uint64_t now) {
+    clock->offset = now;
+    clock->pause_time = now;
+    clock->paused = 0;
+}
+
+/**
+ * @brief  Read the game time
+ * @param  clock, wall time in microseconds (timebase_now)
+ * @retval Game time in microseconds, frozen while paused
+ */
+uint64_t game_clock_now(game_clock_t *clock, uint64_t now) {
+    if (clock->paused) {
+        now = clock->pause_time;
+    }
+    return now - clock->offset;
+}
+
+/**
+ * @brief  Freeze the game time
+ * @param  clock, wall time in microseconds (timebase_now)
+ * @retval GAME_CLOCK_OK, GAME_CLOCK_ERROR if already paused
+ */
+game_clock_status_t game_clock_pause(game_clock_t *clock, uint64_t now) {
+    if (clock->paused) {
+        return GAME_CLOCK_ERROR;
+    }
+    clock->pause_time = now;
+    clock->paused = 1;
+
+    return GAME_CLOCK_OK;
+}
+
+/**
+ * @brief  Let the game time run again from where it was paused
+ * @param  clock, wall time in microseconds (timebase_now)
+ * @retval GAME_CLOCK_OK, GAME_CLOCK_ERROR if not paused
+ */
+game_clock_status_t game_clock_resume(game_clock_t *clock, uint64_t now) {
+    if (!clock->paused) {
+        return GAME_CLOCK_ERROR;
+    }
+    clock->offset += now - clock->pause_time;
+    clock->paused = 0;
+
+    return GAME_CLOCK_OK;
+}
+
+/**
+ * @brief  Check if the game clock is paused
+ * @param  clock
+ * @retval 1 if paused, 0 if running
+ */
+uint8_t game_clock_paused(game_clock_t *clock) {
+    return clock->paused;
+}
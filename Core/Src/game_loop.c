@@ -39,6 +39,13 @@
 #include "ui.h"
 #include "eeprom.h"
 #include "led_indicator.h"
+#include "rng.h"
+#include "rewind.h"
+#include "tetris_engine.h"
+#include "scheduler.h"
+#include "timer_wheel.h"
+#include "timebase.h"
+#include "game_clock.h"
 
 // Extern Variables
 extern TIM_HandleTypeDef htim2;
@@ -54,11 +61,14 @@ uint32_t game_loop_count = 0;
 // Matrix Variables
 matrix_t matrix;
 
+// Gameplay engine, runs the GAME_IN_PROGRESS state
+tetris_engine_t engine;
+
 // Render Variables
 uint8_t update_screen_flag;
 led_t led;
 uint8_t *brightness_lookup = NULL;
-uint32_t render_delay = (1000000 / 35); // 30 FPS
+uint32_t render_delay = GAME_LOOP_RENDER_PERIOD;
 renderer_t renderer;
 uint16_t lookup_table[MATRIX_HEIGHT][MATRIX_WIDTH];
 
@@ -88,6 +98,38 @@ eeprom_id_t signature;
 led_indicator_t hb_led;
 led_indicator_t rj45_led;
 
+// Game loop state shared by the scheduler tasks
+static snes_controller_das_t controller_repeat_left;
+static snes_controller_das_t controller_repeat_right;
+static snes_controller_das_t controller_repeat_up;
+static snes_controller_das_t controller_repeat_down;
+static tetrimino_t tetrimino;
+static uint16_t controller_current_buttons;
+static uint16_t controller_previous_buttons; // reading before the current one in a game or the pause menu
+static RingBuffer controller_buffer; // tetris_engine_reading_t, from the input task and DAS
+static tetris_engine_input_t engine_input; // readings of the current game frame
+static tetris_engine_input_stats_t input_stats;
+static uint32_t press_start_state = 0;
+static uint32_t fps_start_count = 0;
+static uint32_t fps_end_count = 0;
+static uint32_t fps_time_last_update = 0;
+static uint32_t fps_time_diff = 0;
+static uint32_t elapsed_time = 0;
+static tetris_statistics_t tetris_statistics;
+static uint32_t frame_time;
+static uint8_t frames;
+static uint64_t loop_time; // timebase_now, read once by the game task and once before the timers run
+static game_clock_t game_clock; // stops while paused, gameplay timing and the elapsed time follow it
+static uint64_t game_time; // game_clock_now at loop_time of the game task
+static uint32_t game_start_level; // level the game was started at, for restart
+
+// Scheduler Variables
+scheduler_t scheduler;
+
+// Timer Variables
+timer_wheel_t timer_wheel;
+static timer_wheel_timer_t press_start_timer;
+
 /**
  * @brief  Splash screen
  * @param  None
@@ -114,12 +156,675 @@ game_status_t game_init(void) {
     // Set game states to default values
     game.state = GAME_STATE_SPLASH;
     game.play_state = PLAY_STATE_NOT_STARTED;
-    game.drop_time_delay = 1000000;
-    game.lock_time_delay = 500000; // 0.5 seconds
+    game.drop_frames = 60;
+    game.lock_frames = TETRIS_ENGINE_LOCK_FRAMES; // 0.5 seconds
+    game.rotation_system = ROTATION_SYSTEM_DEFAULT;
 
     return GAME_OK;
 }
 
+/**
+ * @brief  Press start timer expired, blink the prompt while waiting for START
+ * @param  context (unused)
+ * @retval None
+ */
+static void game_loop_press_start_blink(void *context) {
+    if (game.state != GAME_STATE_SPLASH_WAIT && game.state != GAME_STATE_GAME_OVER_WAIT) {
+        return; // left the wait state, the next wait arms the timer again
+    }
+    press_start_state = !press_start_state;
+    ssd1306_SetCursor(30, 55);
+    if (press_start_state) {
+        ssd1306_WriteString("                ", Font_6x8, White); // erase line
+    } else {
+        ssd1306_WriteString("Press start", Font_6x8, White);
+    }
+    ssd1306_UpdateScreen();
+    redraw_screen_count++;
+    timer_wheel_arm(&timer_wheel, &press_start_timer, (uint32_t) loop_time, GAME_LOOP_BLINK_PERIOD);
+}
+
+/**
+ * @brief  Cursor timer expired, blink the menu cursor or the level selection
+ * @param  context (unused)
+ * @retval None
+ */
+static void game_loop_cursor_blink(void *context) {
+    switch (game.state) {
+    case GAME_STATE_MENU:
+    case GAME_STATE_SETTINGS:
+    case GAME_STATE_PAUSE:
+        ui_menu_cursor_blink(&menu);
+        break;
+    case GAME_STATE_PLAY_MENU:
+        ui_level_selection_mode = UI_LEVEL_SELECTION_DRAW;
+        ui_level_selection(&game.level, &ui_level_selection_mode, &ui_is_cursor_on);
+        break;
+    default:
+        return; // left the menus, the next menu arms the timer again
+    }
+    timer_wheel_arm(&timer_wheel, &menu.cursor_timer, (uint32_t) loop_time, menu.cursor_timeout);
+}
+
+/**
+ * @brief  Pause the game, the game clock stops and the pause menu is shown
+ * @param  None
+ * @retval None
+ */
+static void game_loop_pause(void) {
+    game_clock_pause(&game_clock, loop_time);
+    controller_previous_buttons = engine_input.held; // START that paused is still held
+    game.state = GAME_STATE_PAUSE;
+    ui_menu_id_set(&menu, 2); // Pause menu
+    menu.ui_status = UI_MENU_DRAW;
+}
+
+/**
+ * @brief  Resume the game where it was paused, the game clock runs again
+ * @param  None
+ * @retval None
+ */
+static void game_loop_resume(void) {
+    game_clock_resume(&game_clock, loop_time);
+    game_time = game_clock_now(&game_clock, loop_time);
+    tetris_engine_input_reset(&engine_input, controller_previous_buttons);
+    game.state = GAME_STATE_GAME_IN_PROGRESS;
+
+    // Redraw the game screen and restart the frame rate count
+    ssd1306_Fill(Black);
+    ssd1306_UpdateScreen();
+    ui_reset_ui_stats();
+    fps_end_count = render_count;
+    fps_time_last_update = (uint32_t) loop_time;
+}
+
+/**
+ * @brief  Microsecond clock of the scheduler
+ * @param  None
+ * @retval Low 32 bits of the timebase
+ */
+static uint32_t game_loop_clock(void) {
+    return timebase_now32();
+}
+
+/**
+ * @brief  Sleep until a wake time, the TIM2 channel 1 compare wakes the core if no other interrupt does
+ * @param  wake_time in microseconds (low 32 bits of the timebase)
+ * @retval Microseconds spent in the interrupt handlers that ended the sleep
+ */
+static uint32_t game_loop_sleep(uint32_t wake_time) {
+#if GAME_LOOP_IDLE_SLEEP
+    uint32_t woken;
+
+    // Channel 1 is left in its reset (frozen) mode, it only compares and never drives a pin
+    __HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_1, wake_time);
+    __HAL_TIM_CLEAR_FLAG(&htim2, TIM_FLAG_CC1);
+    __HAL_TIM_ENABLE_IT(&htim2, TIM_IT_CC1);
+
+    // The compare can pass between the check and WFI, with interrupts masked it stays pending and WFI
+    // returns at once. The pending handlers run when interrupts are enabled again, timed for the load.
+    __disable_irq();
+    if ((int32_t) (timebase_now32() - wake_time) < 0) {
+        __WFI();
+    }
+    woken = timebase_now32();
+    __enable_irq();
+    woken = timebase_now32() - woken;
+
+    __HAL_TIM_DISABLE_IT(&htim2, TIM_IT_CC1);
+    return woken;
+#else
+    (void) wake_time; // poll the clock, the time until the wake time still counts as idle
+    return 0;
+#endif
+}
+
+/**
+ * @brief  Queue a controller reading or a DAS repeat for the game task, stamped with the time
+ * @param  buttons, 1 if a DAS repeat
+ * @retval None
+ */
+static void game_loop_enqueue(uint16_t buttons, uint8_t repeat) {
+    tetris_engine_reading_t reading;
+
+    reading.buttons = buttons;
+    reading.repeat = repeat;
+    reading.time = timebase_now32();
+    if (ring_buffer_enqueue(&controller_buffer, &reading) == false) {
+#if DEBUG_OUTPUT
+        printf("Controller buffer is full. Dropping.\n");
+#endif
+    }
+}
+
+/**
+ * @brief  Take the oldest queued reading for the menus, one per frame
+ * @param  buttons (output)
+ * @retval true if a reading was taken, false if the queue is empty
+ */
+static bool game_loop_dequeue(uint16_t *buttons) {
+    tetris_engine_reading_t reading;
+
+    if (ring_buffer_dequeue(&controller_buffer, &reading) == false) {
+        return false;
+    }
+    *buttons = reading.buttons;
+
+    return true;
+}
+
+/**
+ * @brief  Input task, read the SNES controller and queue state changes for the game task
+ * @param  context (unused)
+ * @retval None
+ */
+static void game_loop_input_task(void *context) {
+    snes_controller_status_t controller_status;
+
+    (void) context;
+
+    // Poll SNES controller before any other processing in the state machine, the task period paces the reads
+    controller_status = snes_controller_poll(&snes_controller);
+    controller_reading = snes_controller.buttons_state;
+    if (controller_status == SNES_CONTROLLER_DISCONNECTED && snes_controller.led_state == 1) {
+        snes_controller.led_state = 0;
+        HAL_GPIO_WritePin(LED_SNES0_GPIO_Port, LED_SNES0_Pin, GPIO_PIN_RESET);
+#if DEBUG_OUTPUT
+        printf("Controller disconnected\n");
+#endif
+    } else if (controller_status != SNES_CONTROLLER_DISCONNECTED
+            && controller_status != SNES_CONTROLLER_NOT_READY && snes_controller.led_state == 0) {
+        snes_controller.led_state = 1;
+        HAL_GPIO_WritePin(LED_SNES0_GPIO_Port, LED_SNES0_Pin, GPIO_PIN_SET);
+    }
+    if (controller_status == SNES_CONTROLLER_STATE_CHANGE) {
+        game_loop_enqueue(snes_controller.buttons_state, 0);
+        if (snes_controller.buttons_state) {
+            controller_count++;
+        }
+    }
+}
+
+/**
+ * @brief  Game task, one frame of the game state machine
+ * @param  context (unused)
+ * @retval None
+ */
+static void game_loop_state_task(void *context) {
+    uint16_t engine_events;
+    uint16_t pressed_buttons;
+
+    (void) context;
+
+    loop_time = timebase_now();
+    game_time = game_clock_now(&game_clock, loop_time);
+
+    // Frames of game time passed since the last run, the gameplay and DAS timers count these, none pass
+    // while paused
+    frames = tetris_engine_frame_ticks(&frame_time, (uint32_t) game_time);
+
+    // Check for Delayed Auto Shift (DAS) events and enqueue them at predefined intervals
+
+    snes_controller_delayed_auto_shift(&controller_repeat_left, &snes_controller, frames);
+    if (controller_repeat_left.repeat_status == SNES_CONTROLLER_DAS_ACTIVE_ENQUEUE) {
+        game_loop_enqueue(controller_repeat_left.target_button, 1);
+    }
+    snes_controller_delayed_auto_shift(&controller_repeat_right, &snes_controller, frames);
+    if (controller_repeat_right.repeat_status == SNES_CONTROLLER_DAS_ACTIVE_ENQUEUE) {
+        game_loop_enqueue(controller_repeat_right.target_button, 1);
+    }
+
+    if (game.state == GAME_STATE_PLAY_MENU) {
+        snes_controller_delayed_auto_shift(&controller_repeat_up, &snes_controller, frames);
+        if (controller_repeat_up.repeat_status == SNES_CONTROLLER_DAS_ACTIVE_ENQUEUE) {
+            game_loop_enqueue(controller_repeat_up.target_button, 1);
+        }
+
+        snes_controller_delayed_auto_shift(&controller_repeat_down, &snes_controller, frames);
+        if (controller_repeat_down.repeat_status == SNES_CONTROLLER_DAS_ACTIVE_ENQUEUE) {
+            game_loop_enqueue(controller_repeat_down.target_button, 1);
+        }
+    }
+    //game.state = GAME_STATE_TEST_FEATURE;
+
+    switch (game.state) {
+
+    /* ---------------------- SPLASH SCREEN ---------------------- */
+    case GAME_STATE_SPLASH:
+        ui_splash_screen();
+        game.state = GAME_STATE_SPLASH_WAIT;
+
+        break;
+
+        /* ------------------------- SPLASH WAIT ------------------------ */
+    case GAME_STATE_SPLASH_WAIT:
+        if (game_loop_dequeue(&controller_current_buttons) == true) {
+            if (controller_current_buttons & SNES_BUTTON_START) {
+                game.state = GAME_STATE_MENU;
+                ui_menu_id_set(&menu, 0);
+                menu.ui_status = UI_MENU_DRAW;
+                ssd1306_Fill(Black);
+                ssd1306_UpdateScreen();
+                break;
+            }
+        }
+        if (!timer_wheel_armed(&press_start_timer)) {
+            timer_wheel_arm(&timer_wheel, &press_start_timer, (uint32_t) loop_time, 0);
+        }
+        break;
+
+        /* ------------------------- MAIN MENU -------------------------- */
+    case GAME_STATE_MENU:
+        ui_main_menu_selection(&menu);
+        if (!timer_wheel_armed(&menu.cursor_timer)) {
+            timer_wheel_arm(&timer_wheel, &menu.cursor_timer, (uint32_t) loop_time, 0);
+        }
+        if (game_loop_dequeue(&controller_current_buttons) == true) {
+            if (controller_current_buttons & SNES_BUTTON_UP) {
+                ui_menu_controller_move_up(&menu);
+            }
+            if (controller_current_buttons & SNES_BUTTON_DOWN) {
+                ui_menu_controller_move_down(&menu);
+            }
+
+            if (controller_current_buttons & SNES_BUTTON_A) {
+                switch (menu.current_selection_id) {
+                case 0:
+                    game.state = GAME_STATE_PLAY_MENU;
+                    ssd1306_Fill(Black);
+                    break;
+                case 1:
+                    game.state = GAME_STATE_HIGH_SCORE;
+                    ui_reset_ui_stats(); // Needed to initialize values for switching frames
+                    ssd1306_Fill(Black);
+                    break;
+                case 2:
+//                        game.state = GAME_STATE_PREPARE_GAME;
+                    game.state = GAME_STATE_SETTINGS;
+                    ui_menu_id_set(&menu, 3);
+                    menu.ui_status = UI_MENU_DRAW;
+                    break;
+                case 3:
+                    game.state = GAME_STATE_PREPARE_GAME;
+//                            game.state = GAME_STATE_CREDITS;
+                    ssd1306_Fill(Black);
+                    break;
+                }
+            }
+        }
+        break;
+
+        /* ------------------------ PLAYING MENU ------------------------ */
+    case GAME_STATE_PLAY_MENU:
+        if (!timer_wheel_armed(&menu.cursor_timer)) {
+            timer_wheel_arm(&timer_wheel, &menu.cursor_timer, (uint32_t) loop_time, 0);
+        }
+        ui_level_selection(&game.level, &ui_level_selection_mode, &ui_is_cursor_on);
+        if (game_loop_dequeue(&controller_current_buttons) == true) {
+            if (controller_current_buttons & SNES_BUTTON_DOWN) {
+                if (game.level == 0) {
+                    game.level = 255;
+                } else {
+                    game.level--;
+                }
+                ui_level_selection_mode = UI_LEVEL_SELECTION_DRAW;
+            }
+            if (controller_current_buttons & SNES_BUTTON_UP) {
+                if (game.level == 255) {
+                    game.level = 0;
+                } else {
+                    game.level++;
+                }
+                ui_level_selection_mode = UI_LEVEL_SELECTION_DRAW;
+            }
+
+            if (controller_current_buttons & SNES_BUTTON_START) {
+                game.state = GAME_STATE_PREPARE_GAME;
+                ssd1306_Fill(Black);
+            }
+
+            if (controller_current_buttons & SNES_BUTTON_B) {
+                menu.ui_status = UI_MENU_DRAW;
+                game.state = GAME_STATE_MENU;
+                ssd1306_Fill(Black);
+            }
+        }
+        break;
+
+        /* -------------------- PREPARE GAME STATE ---------------------- */
+    case GAME_STATE_PREPARE_GAME:
+        // Initialize game variables
+        game_start_level = game.level;
+        tetris_engine_start(&engine);
+        game.game_start_time = game_time;
+        tetris_engine_input_reset(&engine_input, controller_current_buttons); // START that began it may be held
+        memset(&input_stats, 0, sizeof(input_stats));
+        elapsed_time = 0;
+        scheduler_reset_stats(&scheduler);
+
+        game.state = GAME_STATE_GAME_IN_PROGRESS;
+
+        renderer_clear(&renderer);
+        renderer_create_boundary(&renderer);
+
+        // reset game statistics and timer
+        tetris_statistics_reset(&tetris_statistics);
+        ui_reset_ui_stats();
+        tetris_statistics.tetriminos_frequency[tetrimino.piece]++;
+        break;
+
+        /* ---------------------- GAME IN PROGRESS ---------------------- */
+    case GAME_STATE_GAME_IN_PROGRESS:
+        // Every reading queued since the last frame is merged into one input, START pressed in it pauses
+        // after the step so the frames already counted and the moves merged with it are not lost
+        tetris_engine_input_drain(&engine_input, &controller_buffer, (uint32_t) loop_time, &input_stats);
+        engine_events = tetris_engine_step(&engine, &engine_input, frames);
+
+        if (engine_events & TETRIS_ENGINE_EVENT_SPAWN) {
+            tetris_statistics.tetriminos_frequency[tetrimino.piece]++;
+            tetris_statistics.tetriminos_spawned++;
+        }
+
+        if (engine_events & TETRIS_ENGINE_EVENT_TOP_OUT) {
+            ui_display_top_out();
+            renderer_top_out_start(&renderer);
+            game.state = GAME_STATE_GAME_ENDED;
+        } else if (engine_events & TETRIS_ENGINE_EVENT_PAUSE) {
+            game_loop_pause();
+        }
+        break;
+
+        /* ------------------------- PAUSE MENU ------------------------ */
+    case GAME_STATE_PAUSE:
+        ui_main_menu_selection(&menu);
+        if (!timer_wheel_armed(&menu.cursor_timer)) {
+            timer_wheel_arm(&timer_wheel, &menu.cursor_timer, (uint32_t) loop_time, 0);
+        }
+        if (game_loop_dequeue(&controller_current_buttons) == true) {
+            pressed_buttons = controller_current_buttons & ~controller_previous_buttons;
+            controller_previous_buttons = controller_current_buttons;
+            if (controller_current_buttons & SNES_BUTTON_UP) {
+                ui_menu_controller_move_up(&menu);
+            }
+            if (controller_current_buttons & SNES_BUTTON_DOWN) {
+                ui_menu_controller_move_down(&menu);
+            }
+
+            if (pressed_buttons & SNES_BUTTON_START) {
+                game_loop_resume();
+                break;
+            }
+
+            if (controller_current_buttons & SNES_BUTTON_A) {
+                switch (menu.current_selection_id) {
+                case 0:
+                    // Continue
+                    game_loop_resume();
+                    break;
+                case 1:
+                    // Restart at the starting level
+                    game_clock_resume(&game_clock, loop_time);
+                    game.level = game_start_level;
+                    game.state = GAME_STATE_PREPARE_GAME;
+                    ssd1306_Fill(Black);
+                    break;
+                case 2:
+                    // Quit to the main menu
+                    game_clock_resume(&game_clock, loop_time);
+                    game.level = game_start_level;
+                    ui_menu_id_set(&menu, 0);
+                    menu.ui_status = UI_MENU_DRAW;
+                    game.state = GAME_STATE_MENU;
+                    renderer_clear(&renderer);
+                    break;
+                }
+            }
+        }
+        break;
+
+        /* -------------------------- GAME OVER ------------------------ */
+    case GAME_STATE_GAME_ENDED:
+        if (renderer_top_out_animate(&renderer) == RENDERER_ANIMATION_DONE) {
+
+            // Save score if is better than a high score
+
+            game.state = GAME_STATE_GAME_OVER_WAIT;
+#if DEBUG_OUTPUT
+            scheduler_debug_print(&scheduler);
+            printf("Input readings %lu, latency avg %lu us worst %lu us, coalesced %lu, late %lu\n",
+                    (unsigned long) input_stats.readings,
+                    (unsigned long) (input_stats.readings ? input_stats.latency_total / input_stats.readings : 0),
+                    (unsigned long) input_stats.latency_worst, (unsigned long) input_stats.coalesced,
+                    (unsigned long) input_stats.late);
+#endif
+
+            // Flush the buffer
+            ring_buffer_flush(&controller_buffer);
+            // Persist settings and high scores by writing them to EEPROM
+//                eeprom_write_settings(&eeprom, &settings);
+//                eeprom_write_high_scores(&eeprom, high_score_ptrs);
+        }
+        break;
+
+        /* ---------------------- GAME OVER WAIT ---------------------- */
+    case GAME_STATE_GAME_OVER_WAIT:
+
+        if (game_loop_dequeue(&controller_current_buttons) == true) {
+            if (controller_current_buttons & SNES_BUTTON_START) {
+                game.state = GAME_STATE_MENU;
+                menu.ui_status = UI_MENU_DRAW;
+//                    game.state = GAME_STATE_PREPARE_GAME;
+                ssd1306_Fill(Black);
+                ssd1306_UpdateScreen();
+                break;
+            }
+        }
+        if (!timer_wheel_armed(&press_start_timer)) {
+            timer_wheel_arm(&timer_wheel, &press_start_timer, (uint32_t) loop_time, 0);
+        }
+        break;
+
+        /* ------------------------ HIGH SCORES ------------------------ */
+    case GAME_STATE_HIGH_SCORE:
+        // TODO: Display high scores
+        if (game_loop_dequeue(&controller_current_buttons) == true) {
+            if (controller_current_buttons & (SNES_BUTTON_START | SNES_BUTTON_B | SNES_BUTTON_Y)) {
+                game.state = GAME_STATE_MENU;
+                menu.ui_status = UI_MENU_DRAW;
+                ssd1306_Fill(Black);
+                ssd1306_UpdateScreen();
+                break;
+            }
+        }
+        ui_display_high_scores(high_score_ptrs, NULL);
+        break;
+
+        /* ------------------------ SETTINGS MENU ---------------------- */
+    case GAME_STATE_SETTINGS:
+        // TODO: Display settings menu
+        ui_main_menu_selection(&menu);
+        if (!timer_wheel_armed(&menu.cursor_timer)) {
+            timer_wheel_arm(&timer_wheel, &menu.cursor_timer, (uint32_t) loop_time, 0);
+        }
+        if (game_loop_dequeue(&controller_current_buttons) == true) {
+            if (controller_current_buttons & SNES_BUTTON_UP) {
+                ui_menu_controller_move_up(&menu);
+            }
+            if (controller_current_buttons & SNES_BUTTON_DOWN) {
+                ui_menu_controller_move_down(&menu);
+            }
+
+            if (controller_current_buttons & SNES_BUTTON_A) {
+                switch (menu.current_selection_id) {
+                case 0:
+                    // Modify brightness
+                    renderer_brightness_test(&renderer);
+                    break;
+                case 1:
+                    // Debug 1 or 0 (true or false)
+                    ui_display_not_implemented(&snes_controller);
+                    menu.ui_status = UI_MENU_DRAW;
+                    break;
+                case 2:
+                    // Reset high score (summons that function?)
+                    ui_display_not_implemented(&snes_controller);
+                    menu.ui_status = UI_MENU_DRAW;
+                    break;
+                case 3:
+                    // Display scoreboard ID
+                    ui_display_not_implemented(&snes_controller);
+                    menu.ui_status = UI_MENU_DRAW;
+                    break;
+                }
+            }
+
+            if (controller_current_buttons & SNES_BUTTON_B) {
+                ui_menu_id_set(&menu, 0);
+                menu.ui_status = UI_MENU_DRAW;
+                game.state = GAME_STATE_MENU;
+                renderer_clear(&renderer);
+            }
+        }
+        break;
+
+        /* ------------------------ TEST FEATURE ------------------------ */
+    case GAME_STATE_TEST_FEATURE:
+        /* Developer test code START */
+//            ui_display_high_scores(high_score_ptrs, NULL);
+//            rendering_status = renderer_test_render(&renderer);
+//#if DEBUG_OUTPUT
+//            if (rendering_status == RENDERER_UPDATED) {
+//                render_count++;
+//            }
+//#endif
+//            if(main_menu == 0)
+//            {
+//                ui_main_menu_selection();
+//                main_menu = 1;
+//            }
+//            if (ring_buffer_dequeue(&controller_buffer, &controller_current_buttons) == true) {
+//                if (controller_current_buttons & SNES_BUTTON_DOWN) {
+//                    if (array_position > 1) {
+//                        array_position = 1;
+//                    } else {
+//                        array_position++;
+//                    }
+//
+//                    if (cursor_position < 2) {
+//                        cursor_position++;
+//                    } else {
+//                        cursor_position = 2;
+//                    }
+//                }
+//                if (controller_current_buttons & SNES_BUTTON_UP) {
+//                    if (array_position < 0) {
+//                        array_position = 0;
+//                    } else {
+//                        array_position--;
+//                    }
+//
+//                    if (cursor_position > 0) {
+//                        cursor_position--;
+//                    } else {
+//                        cursor_position = 0;
+//                    }
+//                }
+//            ssd1306_SetCursor(32, 14);
+//            ssd1306_WriteString(main_menu_list[array_position], Font_7x10, White);
+//
+//            ssd1306_SetCursor(32, 30);
+//            ssd1306_WriteString(main_menu_list[array_position + 1], Font_7x10, White);
+//
+//            ssd1306_SetCursor(32, 48);
+//            ssd1306_WriteString(main_menu_list[array_position + 2], Font_7x10, White);
+//
+//
+//            ssd1306_SetCursor(10, select_arrow_locations[cursor_position]);
+//            ssd1306_WriteString(">", Font_6x8, White);
+//
+//            ssd1306_UpdateScreen();
+//            }
+        /* Developer test code END */
+        break;
+
+        /* ----------------------- UNKNOWN STATES ---------------------- */
+    default:
+        // TODO: Handle unknown states (fail-safe)
+        break;
+    } // end switch
+
+    game_loop_count++;
+}
+
+/**
+ * @brief  Render task, send the matrix to the LED grid while a game is in progress
+ * @param  context (unused)
+ * @retval None
+ */
+static void game_loop_render_task(void *context) {
+    (void) context;
+
+    if (game.state != GAME_STATE_GAME_IN_PROGRESS) {
+        return;
+    }
+    if (renderer_render(&renderer, &matrix, &tetrimino, &game) == RENDERER_UPDATED) {
+        render_count++;
+    }
+}
+
+/**
+ * @brief  OLED task, refresh the frame rate, elapsed time and progress while a game is in progress
+ * @param  context (unused)
+ * @retval None
+ */
+static void game_loop_oled_task(void *context) {
+    uint64_t now;
+
+    (void) context;
+
+    if (game.state != GAME_STATE_GAME_IN_PROGRESS || game.play_state == PLAY_STATE_TOP_OUT) {
+        return;
+    }
+    now = timebase_now();
+    fps_time_diff = util_time_diff_us(fps_time_last_update, (uint32_t) now);
+    fps_start_count = fps_end_count;
+    fps_end_count = render_count;
+    fps_time_last_update = (uint32_t) now;
+    ui_display_fps(fps_start_count, fps_end_count, fps_time_diff);
+    ui_display_cpu_load(scheduler_load(&scheduler));
+    elapsed_time = (game_clock_now(&game_clock, now) - game.game_start_time) / 1000000; // seconds
+    ui_elapsed_time(elapsed_time);
+//    ui_display_game_info(&game);
+    ui_display_game_progress(&game);
+}
+
+/**
+ * @brief  LED task, update the heartbeat and RJ45 indicators
+ * @param  context (unused)
+ * @retval None
+ */
+static void game_loop_led_task(void *context) {
+    (void) context;
+
+    led_indicator(&hb_led);
+    led_indicator(&rj45_led);
+}
+
+// Task table, due tasks run in priority order. Input and game share the game frame period so each
+// frame reads the controller before it steps the game.
+static scheduler_task_t game_loop_tasks[] = {
+    { .name = "input", .run = game_loop_input_task, .period = TETRIS_ENGINE_FRAME_PERIOD, .phase = 0,
+            .priority = 0, .deadline = GAME_LOOP_INPUT_DEADLINE },
+    { .name = "game", .run = game_loop_state_task, .period = TETRIS_ENGINE_FRAME_PERIOD, .phase = 0,
+            .priority = 1, .deadline = 0 },
+    { .name = "render", .run = game_loop_render_task, .period = GAME_LOOP_RENDER_PERIOD, .phase = 0,
+            .priority = 2, .deadline = 0 },
+    { .name = "oled", .run = game_loop_oled_task, .period = GAME_LOOP_OLED_PERIOD, .phase = 0,
+            .priority = 3, .deadline = 0 },
+    { .name = "leds", .run = game_loop_led_task, .period = GAME_LOOP_LED_PERIOD, .phase = 0,
+            .priority = 4, .deadline = 0 }
+};
+
 /**
  * @brief  Main game loop for Classic Tetris on LED Grid
  * @param  None
@@ -127,37 +832,22 @@ game_status_t game_init(void) {
  */
 void game_loop(void) {
     snes_controller_status_t controller_status;
-    snes_controller_das_t controller_repeat_left;
-    snes_controller_das_t controller_repeat_right;
-    snes_controller_das_t controller_repeat_up;
-    snes_controller_das_t controller_repeat_down;
     matrix_status_t matrix_status;
     renderer_status_t rendering_status;
 //    char output_buffer[80];
-    tetrimino_t tetrimino;
     tetrimino_status_t tetrimino_status;
-    uint16_t controller_current_buttons;
-    uint16_t controller_previous_buttons = 0;
-    RingBuffer controller_buffer;
-    uint32_t press_start_timer_start = 0;
-    uint32_t press_start_state = 0;
-    uint32_t fps_start_count = 0;
-    uint32_t fps_end_count = 0;
-    uint32_t fps_time_last_update = 0;
-    uint32_t fps_time_diff = 0;
-    uint32_t lines_to_be_cleared = 0;
-    uint32_t elapsed_time = 0;
-    matrix_t temp_matrix;
-    matrix_t rotate_check_matrix;
-    tetrimino_t temp_tetrimino;
-    tetris_statistics_t tetris_statistics;
-
-    if (ring_buffer_init(&controller_buffer, 16, sizeof(uint16_t)) != RING_BUFFER_OK) {
+    uint32_t wake_time;
+    uint32_t timer_expiry;
+
+    if (ring_buffer_init(&controller_buffer, 16, sizeof(tetris_engine_reading_t)) != RING_BUFFER_OK) {
 #if DEBUG_OUTPUT
         printf("Failed to initialize ring buffer\n");
 #endif
         Error_Handler();
     }
+#if PRACTICE_REWIND && DEBUG_OUTPUT
+    printf("Rewind buffer: %u bytes for %d pieces\n", (unsigned int) sizeof(rewind_t), REWIND_MAX_PIECES);
+#endif
 
     // Init EEPROM
     eeprom_init(&eeprom, &hi2c1, EEPROM_GPIO_Port, EEPROM_Pin);
@@ -201,11 +891,25 @@ void game_loop(void) {
 
         // Load high scores from EEPROM
         eeprom_get_high_scores(&eeprom, high_score_ptrs);
+
+        // The board geometry is fixed at build time, a save from another panel size is rejected and its
+        // high scores with it, they were made on a different playfield
+        if (settings.grid_size != MATRIX_HEIGHT) {
+#if DEBUG_OUTPUT
+            printf("Saved grid size %d rejected, firmware built for a %dx%d LED panel\n", settings.grid_size,
+            MATRIX_WIDTH, MATRIX_HEIGHT);
+#endif
+            eeprom_get_default_high_scores(high_score_ptrs);
+            eeprom_get_default_settings(&settings);
+            eeprom_write_settings(&eeprom, &settings);
+            eeprom_write_high_scores(&eeprom, high_score_ptrs);
+        }
     }
 
     // Initialize OLED display driver
     memset(&tetris_statistics, 0, sizeof(tetris_statistics_t));
-    ui_init(&tetris_statistics);
+    timer_wheel_init(&timer_wheel, timebase_now32());
+    ui_init(&tetris_statistics, &timer_wheel);
 
     controller_status = snes_controller_init(&snes_controller,
     SNES_LATCH_GPIO_Port, SNES_LATCH_Pin,
@@ -249,6 +953,8 @@ void game_loop(void) {
     if (tetrimino_status == TETRIMINO_OK) {
         tetrimino_debug_print(&tetrimino);
     }
+#else
+    (void) tetrimino_status;
 #endif
 
     /* Generate and initialize the brightness lookup table */
@@ -275,8 +981,14 @@ void game_loop(void) {
 #endif
     }
 
+    if (tetris_engine_init(&engine, &game, &matrix, &tetrimino) != TETRIS_ENGINE_OK) {
+#if DEBUG_OUTPUT
+        printf("Tetris engine initialization failed\n");
+#endif
+    }
+
     rendering_status = renderer_init(&renderer, lookup_table, &matrix, &led, &htim3, TIM_CHANNEL_1,
-            render_delay);
+            render_delay, &timer_wheel);
 
     if (rendering_status == RENDERER_OK) {
 #if DEBUG_OUTPUT
@@ -286,6 +998,8 @@ void game_loop(void) {
 
     // Initialize menu system
     ui_menu_init(&menu);
+    timer_wheel_timer_init(&menu.cursor_timer, game_loop_cursor_blink, NULL);
+    timer_wheel_timer_init(&press_start_timer, game_loop_press_start_blink, NULL);
 
     rendering_status = renderer_create_boundary(&renderer);
 
@@ -296,8 +1010,8 @@ void game_loop(void) {
     }
 
     // Initialize LED Indicators
-    led_init(&hb_led, LED_HB_GPIO_Port, LED_HB_Pin, &htim2);
-    led_init(&rj45_led, I2C_LED_GPIO_Port, I2C_LED_Pin, &htim2);
+    led_init(&hb_led, LED_HB_GPIO_Port, LED_HB_Pin, &htim2, &timer_wheel);
+    led_init(&rj45_led, I2C_LED_GPIO_Port, I2C_LED_Pin, &htim2, &timer_wheel);
     led_set_mode(&hb_led, LED_BLINK_CONTINUOUS);
     led_set_blink_delay(&hb_led, 500, 500);
     led_set_mode(&rj45_led, LED_N_BLINK);
@@ -312,772 +1026,38 @@ void game_loop(void) {
 //    game.state = GAME_STATE_TEST_FEATURE;
 //    game.state = GAME_STATE_GAME_IN_PROGRESS;
 
-    // Test rendering, define tetrimino stack
-//    matrix.stack[0] = 0xff80ff8;
-//    matrix.stack[1] = 0xff80ff8;
-//    matrix.stack[2] = 0xff80ff8;
-//    matrix.stack[3] = 0xff80ff8;
-//    matrix.stack[4] = 0xff80ff8;
-//    matrix.stack[5] = 0xff80fb8;
-//    matrix.stack[6] = 0xff80df8;
-//    matrix.stack[7] = 0x0;
-//    matrix.stack[8] = 0;
-//    matrix.stack[9] = 0x0;
-//    matrix.palette1[0] = 0;
-//    matrix.palette1[1] = 23069152;
-//    matrix.palette1[2] = 33554496;
-//    matrix.palette1[3] = 251661824;
-//    matrix.palette1[4] = 33557248;
-//    matrix.palette1[5] = 100663808;
-//    matrix.palette1[6] = 1024;
-//    matrix.palette1[7] = 0;
-//    matrix.palette1[8] = 0;
-//    matrix.palette1[9] = 0;
-//    matrix.palette2[0] = 201328160;
-//    matrix.palette2[1] = 234884096;
-//    matrix.palette2[2] = 16777728;
-//    matrix.palette2[3] = 12583360;
-//    matrix.palette2[4] = 6291696;
-//    matrix.palette2[5] = 25165824;
-//    matrix.palette2[6] = 31457664;
-//    matrix.palette2[7] = 0;
-//    matrix.palette2[8] = 0;
-//    matrix.palette2[9] = 0;
+    // Test rendering, load a tetrimino stack in the text form printed by matrix_debug_print
+//    matrix_deserialize_text(&matrix, ".TTTZZZZTT/.TJ.ZZTTTT/.TJJZZTTTT/.TTJTT.TTT/.TTJTTZZTT/"
+//            ".JTJJZZZZT/.JJJJZZTTT/.JJJZZZTTT/.TTJZTTTTT/.TTZTTJTTT/"
+//            ".ZZZJTJJTT/.ZZTJJJJTT/.ZZTTTTTTT/.TZZTTTZTT");
     ui_reset_ui_stats();
 
-    for (;;) {
-        // Future: Respond to scoreboard requests
-
-        // Poll SNES controller before any other processing in the state machine
-        controller_status = snes_controller_read(&snes_controller);
-        controller_reading = snes_controller.buttons_state;
-        if (controller_status == SNES_CONTROLLER_DISCONNECTED && snes_controller.led_state == 1) {
-            snes_controller.led_state = 0;
-            HAL_GPIO_WritePin(LED_SNES0_GPIO_Port, LED_SNES0_Pin, GPIO_PIN_RESET);
-#if DEBUG_OUTPUT
-            printf("Controller disconnected\n");
-#endif
-        } else if (controller_status != SNES_CONTROLLER_DISCONNECTED
-                && controller_status != SNES_CONTROLLER_NOT_READY && snes_controller.led_state == 0) {
-            snes_controller.led_state = 1;
-            HAL_GPIO_WritePin(LED_SNES0_GPIO_Port, LED_SNES0_Pin, GPIO_PIN_SET);
-        }
-        if (controller_status == SNES_CONTROLLER_STATE_CHANGE) {
-            if (ring_buffer_enqueue(&controller_buffer, &snes_controller.buttons_state) == false) {
-#if DEBUG_OUTPUT
-                printf("Controller buffer is full. Dropping.\n");
-#endif
-
-            }
-            if (snes_controller.buttons_state) {
-                controller_count++;
-            }
-        }
-
-        // Check for Delayed Auto Shift (DAS) events and enqueue them at predefined intervals
-
-        snes_controller_delayed_auto_shift(&controller_repeat_left, &snes_controller);
-        if (controller_repeat_left.repeat_status == SNES_CONTROLLER_DAS_ACTIVE_ENQUEUE) {
-            if (ring_buffer_enqueue(&controller_buffer, &controller_repeat_left.target_button) == false) {
-#if DEBUG_OUTPUT
-                printf("Controller buffer is full. Dropping.\n");
-#endif
-            }
-        }
-        snes_controller_delayed_auto_shift(&controller_repeat_right, &snes_controller);
-        if (controller_repeat_right.repeat_status == SNES_CONTROLLER_DAS_ACTIVE_ENQUEUE) {
-            if (ring_buffer_enqueue(&controller_buffer, &controller_repeat_right.target_button) == false) {
+    game_clock_init(&game_clock, timebase_now());
+    frame_time = 0; // the game clock starts at 0
+    if (scheduler_init(&scheduler, game_loop_tasks, sizeof(game_loop_tasks) / sizeof(game_loop_tasks[0]),
+            game_loop_clock) != SCHEDULER_OK) {
 #if DEBUG_OUTPUT
-                printf("Controller buffer is full. Dropping.\n");
+        printf("Scheduler initialization failed\n");
 #endif
-            }
-        }
+        Error_Handler();
+    }
 
-        if (game.state == GAME_STATE_PLAY_MENU) {
-            snes_controller_delayed_auto_shift(&controller_repeat_up, &snes_controller);
-            if (controller_repeat_up.repeat_status == SNES_CONTROLLER_DAS_ACTIVE_ENQUEUE) {
-                if (ring_buffer_enqueue(&controller_buffer, &controller_repeat_up.target_button) == false) {
-#if DEBUG_OUTPUT
-                    printf("Controller buffer is full. Dropping.\n");
+#if GAME_LOOP_IDLE_SLEEP && DEBUG_OUTPUT
+    HAL_DBGMCU_EnableDBGSleepMode(); // keep the debugger and ITM output alive during WFI
 #endif
-                }
-            }
 
-            snes_controller_delayed_auto_shift(&controller_repeat_down, &snes_controller);
-            if (controller_repeat_down.repeat_status == SNES_CONTROLLER_DAS_ACTIVE_ENQUEUE) {
-                if (ring_buffer_enqueue(&controller_buffer, &controller_repeat_down.target_button) == false) {
-#if DEBUG_OUTPUT
-                    printf("Controller buffer is full. Dropping.\n");
-#endif
-                }
-            }
+    for (;;) {
+        // Future: Respond to scoreboard requests
+        scheduler_dispatch(&scheduler);
+        loop_time = timebase_now();
+        timer_wheel_advance(&timer_wheel, (uint32_t) loop_time); // one compare until the next timer is due
+
+        // Nothing is due before the next task release or timer, sleep until the earlier of the two
+        scheduler_next_release(&scheduler, &wake_time);
+        if (timer_wheel_next_expiry(&timer_wheel, &timer_expiry) == TIMER_WHEEL_OK
+                && (int32_t) (timer_expiry - wake_time) < 0) {
+            wake_time = timer_expiry;
         }
-        //game.state = GAME_STATE_TEST_FEATURE;
-
-        switch (game.state) {
-
-        /* ---------------------- SPLASH SCREEN ---------------------- */
-        case GAME_STATE_SPLASH:
-            ui_splash_screen();
-            game.state = GAME_STATE_SPLASH_WAIT;
-
-            break;
-
-            /* ------------------------- SPLASH WAIT ------------------------ */
-        case GAME_STATE_SPLASH_WAIT:
-            if (ring_buffer_dequeue(&controller_buffer, &controller_current_buttons) == true) {
-                if (controller_current_buttons & SNES_BUTTON_START) {
-                    game.state = GAME_STATE_MENU;
-                    ui_menu_id_set(&menu, 0);
-                    menu.ui_status = UI_MENU_DRAW;
-                    ssd1306_Fill(Black);
-                    ssd1306_UpdateScreen();
-                    break;
-                }
-            }
-            if (util_time_expired_delay(press_start_timer_start, 500000)) { // 500ms
-                press_start_timer_start = TIM2->CNT;
-                press_start_state = !press_start_state;
-                ssd1306_SetCursor(30, 55);
-                if (press_start_state) {
-                    ssd1306_WriteString("                ", Font_6x8, White); // erase line
-                } else {
-                    ssd1306_WriteString("Press start", Font_6x8, White);
-                }
-                ssd1306_UpdateScreen();
-                redraw_screen_count++;
-            }
-            break;
-
-            /* ------------------------- MAIN MENU -------------------------- */
-        case GAME_STATE_MENU:
-            ui_main_menu_selection(&menu);
-            if (util_time_expired_delay(menu.cursor_start_time, 500000)) {
-                menu.cursor_start_time = TIM2->CNT;
-                ui_menu_cursor_blink(&menu);
-            }
-            if (ring_buffer_dequeue(&controller_buffer, &controller_current_buttons) == true) {
-                if (controller_current_buttons & SNES_BUTTON_UP) {
-                    ui_menu_controller_move_up(&menu);
-                }
-                if (controller_current_buttons & SNES_BUTTON_DOWN) {
-                    ui_menu_controller_move_down(&menu);
-                }
-
-                if (controller_current_buttons & SNES_BUTTON_A) {
-                    switch (menu.current_selection_id) {
-                    case 0:
-                        game.state = GAME_STATE_PLAY_MENU;
-                        ssd1306_Fill(Black);
-                        break;
-                    case 1:
-                        game.state = GAME_STATE_HIGH_SCORE;
-                        ui_reset_ui_stats(); // Needed to initialize values for switching frames
-                        ssd1306_Fill(Black);
-                        break;
-                    case 2:
-//                        game.state = GAME_STATE_PREPARE_GAME;
-                        game.state = GAME_STATE_SETTINGS;
-                        ui_menu_id_set(&menu, 3);
-                        menu.ui_status = UI_MENU_DRAW;
-                        break;
-                    case 3:
-                        game.state = GAME_STATE_PREPARE_GAME;
-//                            game.state = GAME_STATE_CREDITS;
-                        ssd1306_Fill(Black);
-                        break;
-                    }
-                }
-            }
-            break;
-
-            /* ------------------------ PLAYING MENU ------------------------ */
-        case GAME_STATE_PLAY_MENU:
-            if (util_time_expired_delay(menu.cursor_start_time, 500000)) {
-                menu.cursor_start_time = TIM2->CNT;
-                ui_level_selection_mode = UI_LEVEL_SELECTION_DRAW;
-                ui_level_selection(&game.level, &ui_level_selection_mode, &ui_is_cursor_on);
-            }
-            ui_level_selection(&game.level, &ui_level_selection_mode, &ui_is_cursor_on);
-            if (ring_buffer_dequeue(&controller_buffer, &controller_current_buttons) == true) {
-                if (controller_current_buttons & SNES_BUTTON_DOWN) {
-                    if (game.level == 0) {
-                        game.level = 255;
-                    } else {
-                        game.level--;
-                    }
-                    ui_level_selection_mode = UI_LEVEL_SELECTION_DRAW;
-                }
-                if (controller_current_buttons & SNES_BUTTON_UP) {
-                    if (game.level == 255) {
-                        game.level = 0;
-                    } else {
-                        game.level++;
-                    }
-                    ui_level_selection_mode = UI_LEVEL_SELECTION_DRAW;
-                }
-
-                if (controller_current_buttons & SNES_BUTTON_START) {
-                    game.state = GAME_STATE_PREPARE_GAME;
-                    ssd1306_Fill(Black);
-                }
-
-                if (controller_current_buttons & SNES_BUTTON_B) {
-                    menu.ui_status = UI_MENU_DRAW;
-                    game.state = GAME_STATE_MENU;
-                    ssd1306_Fill(Black);
-                }
-            }
-            break;
-
-            /* -------------------- PREPARE GAME STATE ---------------------- */
-        case GAME_STATE_PREPARE_GAME:
-            // Initialize game variables
-
-            matrix_clear(&matrix);
-            game.score = 0;
-//            game.level = 0;
-            game.lines = 0;
-            game.lines_to_next_level = 10 * (game.level + 1);
-            game.drop_time_normal_delay = tetrimino_drop_speed(game.level);
-            game.drop_time_soft_drop_delay = game.drop_time_normal_delay / 20;
-            game.drop_time_delay = game.drop_time_normal_delay;
-            game.drop_time_start = TIM2->CNT;
-            game.game_start_time = TIM2->CNT;
-            elapsed_time = 0;
-
-            game.state = GAME_STATE_GAME_IN_PROGRESS;
-            game.play_state = PLAY_STATE_NORMAL;
-
-            renderer_clear(&renderer);
-            renderer_create_boundary(&renderer);
-
-            memset(&game.stats, 0, sizeof(game_stats_t));
-
-            // Reinitialize tetrimino piece
-            tetrimino_init(&tetrimino);
-
-            // reset game statistics and timer
-            tetris_statistics_reset(&tetris_statistics);
-            ui_reset_ui_stats();
-            tetris_statistics.tetriminos_frequency[tetrimino.piece]++;
-            break;
-
-            /* ---------------------- GAME IN PROGRESS ---------------------- */
-        case GAME_STATE_GAME_IN_PROGRESS:
-            if (ring_buffer_dequeue(&controller_buffer, &controller_current_buttons) == true) {
-                controller_status = SNES_CONTROLLER_STATE_CHANGE;
-            } else {
-                controller_status = SNES_CONTROLLER_NO_STATE_CHANGE;
-            }
-
-            // Determine if the controller button is in repeat mode (if the button is held down)
-
-            if (controller_status == SNES_CONTROLLER_STATE_CHANGE) {
-                tetrimino_copy(&temp_tetrimino, &tetrimino);
-                matrix_copy(&temp_matrix, &matrix);
-                matrix_copy(&rotate_check_matrix, &matrix);
-#if YX_ROTATE_TETRIMINO
-                if (controller_current_buttons & (SNES_BUTTON_A | SNES_BUTTON_X)
-                        && !(controller_previous_buttons & (SNES_BUTTON_A | SNES_BUTTON_X))) {
-#else
-                if (controller_current_buttons & SNES_BUTTON_A
-                        && !(controller_previous_buttons & SNES_BUTTON_A)) {
-#endif
-                    tetrimino_status = tetrimino_rotate(&tetrimino, ROTATE_CW);
-                    matrix_status = matrix_add_tetrimino(&rotate_check_matrix, &tetrimino);
-                    if (matrix_check_collision(&rotate_check_matrix, &tetrimino) == MATRIX_STACK_COLLISION) {
-                        tetrimino_copy(&tetrimino, &temp_tetrimino); // Revert tetrimino position
-                        tetrimino_status = TETRIMINO_REFRESH;
-                    }
-#if YX_ROTATE_TETRIMINO
-                } else if (controller_current_buttons & (SNES_BUTTON_B | SNES_BUTTON_Y)
-                        && !(controller_previous_buttons & (SNES_BUTTON_B | SNES_BUTTON_Y))) {
-#else
-                    } else if (controller_current_buttons & SNES_BUTTON_B
-                            && !(controller_previous_buttons & SNES_BUTTON_B)) {
-#endif
-                    tetrimino_status = tetrimino_rotate(&tetrimino, ROTATE_CCW);
-                    matrix_status = matrix_add_tetrimino(&rotate_check_matrix, &tetrimino);
-                    if (matrix_check_collision(&rotate_check_matrix, &tetrimino) == MATRIX_STACK_COLLISION) {
-                        tetrimino_copy(&tetrimino, &temp_tetrimino); // Revert tetrimino position
-                        tetrimino_status = TETRIMINO_REFRESH;
-                    }
-                }
-
-#if TEST_TETRIMINO_CHANGE
-                else if (controller_current_buttons & SNES_BUTTON_R) {
-                    tetrimino.piece++;
-                    if (tetrimino.piece >= TETRIMINO_COUNT) {
-                        tetrimino.piece = 0;
-                    }
-                    tetrimino.shape_offset = tetrimino_shape_offset_lut[tetrimino.piece][tetrimino.rotation];
-                    tetrimino_status = TETRIMINO_REFRESH;
-
-                }
-                if (controller_current_buttons & SNES_BUTTON_L) {
-                    tetrimino.piece--;
-                    if (tetrimino.piece >= TETRIMINO_COUNT) {
-                        tetrimino.piece = TETRIMINO_COUNT - 1;
-                    }
-                    tetrimino.shape_offset = tetrimino_shape_offset_lut[tetrimino.piece][tetrimino.rotation];
-                    tetrimino_status = TETRIMINO_REFRESH;
-                }
-#endif
-//                if (controller_current_buttons & SNES_BUTTON_UP) {
-//                    if (matrix_move_tetrimino(&matrix, &tetrimino, MOVE_UP) == MATRIX_REFRESH) {
-//                    }
-//                }
-
-                // Handle down button press only if in normal play state
-                if (game.play_state == PLAY_STATE_NORMAL) {
-                    // If down button was previously pressed and is now released
-                    if (controller_previous_buttons & SNES_BUTTON_DOWN
-                            && !(controller_current_buttons & SNES_BUTTON_DOWN)) {
-                        game.drop_time_delay = game.drop_time_normal_delay;
-                        game.soft_drop_flag = 0;
-                        game.soft_drop_lines = 0;
-                        tetrimino_status = TETRIMINO_REFRESH;
-                    } else if (controller_current_buttons & SNES_BUTTON_DOWN) {
-                        game.drop_time_delay = game.drop_time_soft_drop_delay;
-                        game.soft_drop_flag = 1;
-                        tetrimino_status = TETRIMINO_REFRESH;
-                    }
-                }
-
-//                } else {
-//                    game.drop_time_delay = game.drop_time_normal_delay;
-//                    game.soft_drop_flag = 0;
-//                    game.soft_drop_lines = 0;
-//                }
-
-                if (controller_current_buttons & SNES_BUTTON_LEFT) {
-                    matrix_move_tetrimino(&matrix, &tetrimino, MOVE_LEFT);
-
-                }
-                if (controller_current_buttons & SNES_BUTTON_RIGHT) {
-                    matrix_move_tetrimino(&matrix, &tetrimino, MOVE_RIGHT);
-                }
-#if TEST_TETRIMINO_CHANGE && !YX_ROTATE_TETRIMINO
-                if (controller_current_buttons & SNES_BUTTON_Y) {
-//                    game.drop_time_delay += 25000;
-                    game.level++;
-                } else if (controller_current_buttons & SNES_BUTTON_X) {
-//                    game.drop_time_delay -= 25000;
-//                    if (game.drop_time_delay < 25000) {
-//                        game.drop_time_delay = 25000;
-//                    }
-                    if (game.level > 0) {
-                        game.level--;
-                    }
-
-#if DEBUG_OUTPUT
-                    printf("Level: %ld\n", game.level);
-#endif
-                }
-#endif
-                if (matrix_status != MATRIX_REFRESH) {
-                    // Revert tetrimino position and refresh matrix
-                    matrix_status = matrix_add_tetrimino(&matrix, &tetrimino);
-                    if (matrix_status == MATRIX_WALL_COLLISION || matrix_status == MATRIX_REACHED_BOTTOM) {
-                        tetrimino_copy(&tetrimino, &temp_tetrimino);
-                        matrix_copy(&matrix, &temp_matrix);
-                    }
-                } else if (tetrimino_status == TETRIMINO_REFRESH) {
-                    matrix_status = matrix_add_tetrimino(&matrix, &tetrimino);
-                    if (matrix_status == MATRIX_WALL_COLLISION || matrix_status == MATRIX_REACHED_BOTTOM) {
-                        tetrimino_copy(&tetrimino, &temp_tetrimino);
-                        matrix_copy(&matrix, &temp_matrix);
-                    }
-                }
-            } // end if controller_status == SNES_CONTROLLER_STATE_CHANGE
-
-            if (game.play_state == PLAY_STATE_NORMAL) {
-                // Check if tetrimino is clear to continue dropping down during half-second before lock period
-                matrix_copy(&temp_matrix, &matrix); // Save current matrix state
-                if (util_time_expired_delay(game.drop_time_start, game.drop_time_delay)) {
-                    if (tetrimino.y > 0) {
-                        tetrimino.y--;
-                    }
-
-                    matrix_status = matrix_add_tetrimino(&matrix, &tetrimino);
-                    if (matrix_status == MATRIX_WALL_COLLISION) {
-                        matrix_copy(&matrix, &temp_matrix);
-                    } else if (matrix_status == MATRIX_OUT_OF_BOUNDS) {
-                        matrix_copy(&matrix, &temp_matrix);
-                    } else if (matrix_status == MATRIX_REACHED_BOTTOM) {
-                        matrix_copy(&matrix, &temp_matrix);
-//                        matrix_status = matrix_add_tetrimino(&matrix, &tetrimino);
-                        game.play_state = PLAY_STATE_HALF_SECOND_B4_LOCK;
-                        game.lock_time_start = TIM2->CNT;
-                    } else {
-                        // Check for collision with the current stack
-                        matrix_status = matrix_check_collision(&matrix, &tetrimino);
-                        if (matrix_status == MATRIX_STACK_COLLISION) {
-                            // Restore previous matrix state
-                            matrix_copy(&matrix, &temp_matrix);
-                            game.play_state = PLAY_STATE_HALF_SECOND_B4_LOCK;
-                            game.lock_time_start = TIM2->CNT;
-                            tetrimino.y++; // Revert tetrimino y position
-                        }
-                        // Edge case handling: Long bar reached to bottom of matrix, transition to lock state
-                        if (tetrimino.y == 0) {
-                            game.play_state = PLAY_STATE_HALF_SECOND_B4_LOCK;
-                            game.lock_time_start = TIM2->CNT;
-                        }
-                        game.drop_time_start = TIM2->CNT;
-                        if (game.soft_drop_flag) {
-                            game.soft_drop_lines++;
-                        }
-                    }
-                }
-            } else {
-                if (game.play_state == PLAY_STATE_HALF_SECOND_B4_LOCK) {
-                    // Check if tetrimino still can fall down unobstructed, if so, revert to normal play state
-                    tetrimino_copy(&temp_tetrimino, &tetrimino);
-                    matrix_copy(&temp_matrix, &matrix);
-                    if (temp_tetrimino.y > 0) {
-                        temp_tetrimino.y--;
-                    }
-                    matrix_status = matrix_add_tetrimino(&temp_matrix, &temp_tetrimino);
-                    if (matrix_status != MATRIX_REACHED_BOTTOM && temp_tetrimino.y > 0
-                            && matrix_check_collision(&temp_matrix, &temp_tetrimino) == MATRIX_OK) {
-                        // No collision detected, revert to normal play state
-                        game.play_state = PLAY_STATE_NORMAL;
-                        game.drop_time_start = TIM2->CNT;
-                    } else {
-                        if (util_time_expired_delay(game.lock_time_start, game.lock_time_delay)) {
-                            game.play_state = PLAY_STATE_LOCKED;
-                        }
-                    }
-                }
-            }
-
-            if (game.play_state == PLAY_STATE_LOCKED) {
-                // Merge playfield with stack & palette
-                matrix_status = merge_with_stack(&matrix, &tetrimino);
-                matrix_reset_playfield(&matrix);
-                // Check for line clear
-                lines_to_be_cleared = matrix_check_line_clear(&matrix);
-#if DEBUG_OUTPUT
-                if (lines_to_be_cleared) {
-                    printf("Lines to be cleared: ");
-                    for (int i = 0; i < PLAYING_FIELD_HEIGHT; i++) {
-                        if (lines_to_be_cleared & (1 << i)) {
-                            printf("%d ", i);
-                        }
-                    }
-                    printf("\n");
-                    printf("stack values:\n");
-                    for (int i = 0; i < MATRIX_DATA_SIZE; i++) {
-                        printf("matrix.stack[%d] = \"0x%08lX\";\n", i, matrix.stack[i]);
-                    }
-                    printf("palette1 values:\n");
-                    for (int i = 0; i < MATRIX_DATA_SIZE; i++) {
-                        printf("matrix.palette1[%d] = \"0x%08lX\";\n", i, matrix.palette1[i]);
-                    }
-                    printf("palette2 values:\n");
-                    for (int i = 0; i < MATRIX_DATA_SIZE; i++) {
-                        printf("matrix.palette2[%d] = \"0x%08lX\";\n", i, matrix.palette2[i]);
-                    }
-                }
-#endif
-                if (lines_to_be_cleared) {
-                    game.play_state = PLAY_STATE_LINE_CLEAR;
-                    matrix.line_clear_bitmap = lines_to_be_cleared;
-                    matrix_line_clear_start(&matrix, CLEAR_LINE_DELAY);
-                    if (util_bit_count(lines_to_be_cleared) == 4) {
-                        matrix.tetris_flag = 1;
-                    }
-                } else {
-                    if (game.soft_drop_flag) {
-                        game.score += game.soft_drop_lines;
-                        game.soft_drop_lines = 0;
-                        game.soft_drop_flag = 0;
-                        game.drop_time_delay = game.drop_time_normal_delay;
-                    }
-                    game.play_state = PLAY_STATE_NEXT_TETRIMINO;
-                }
-            }
-
-            if (game.play_state == PLAY_STATE_LINE_CLEAR) {
-                if (matrix_line_clear_animate(&matrix, lines_to_be_cleared)) { // Is line clear complete?
-                    if (game.soft_drop_flag) {
-                        game.score += game.soft_drop_lines;
-                        game.soft_drop_lines = 0;
-                    }
-                    // Update the score based on the number of lines cleared and game level
-                    game.score += tetris_calculate_score(util_bit_count(lines_to_be_cleared), game.level);
-
-                    // Update game statistics
-                    if (util_bit_count(lines_to_be_cleared) == 1) {
-                        game.stats.singles++;
-                    } else if (util_bit_count(lines_to_be_cleared) == 2) {
-                        game.stats.doubles++;
-                    } else if (util_bit_count(lines_to_be_cleared) == 3) {
-                        game.stats.triples++;
-                    } else if (util_bit_count(lines_to_be_cleared) == 4) {
-                        game.stats.tetrises++;
-                    }
-
-                    // Reposition blocks after clearing lines
-                    matrix_reposition_blocks(&matrix, lines_to_be_cleared);
-                    game.play_state = PLAY_STATE_NEXT_TETRIMINO;  // Move to next tetrimino
-                    game.drop_time_start = TIM2->CNT;
-                    game.lines += util_bit_count(lines_to_be_cleared);
-                    lines_to_be_cleared = 0;
-                    matrix.tetris_flag = 0;
-                    game.soft_drop_flag = 0;
-                    game.drop_time_delay = game.drop_time_normal_delay;
-                    if (game.lines >= game.lines_to_next_level) {
-                        game.play_state = PLAY_STATE_TRANSITION_LEVEL;
-                    }
-                }
-            }
-
-            // Transition to the next level if line clear count is met
-            if (game.play_state == PLAY_STATE_TRANSITION_LEVEL) {
-                game.level++;
-                game.lines_to_next_level = 10 * (game.level + 1);
-                game.drop_time_normal_delay = tetrimino_drop_speed(game.level);
-                game.drop_time_soft_drop_delay = game.drop_time_normal_delay / 20;
-                game.drop_time_delay = game.drop_time_normal_delay;
-                game.play_state = PLAY_STATE_NEXT_TETRIMINO;
-                game.drop_time_start = TIM2->CNT;
-            }
-
-            if (game.play_state == PLAY_STATE_NEXT_TETRIMINO) {
-                matrix_copy(&temp_matrix, &matrix); // Save current matrix state
-                tetrimino_status = tetrimino_next(&tetrimino);
-                if (tetrimino_status == TETRIMINO_OK) {
-                    tetris_statistics.tetriminos_frequency[tetrimino.piece]++;
-                    tetris_statistics.tetriminos_spawned++;
-                    matrix_status = matrix_add_tetrimino(&matrix, &tetrimino);
-                    if (matrix_status == MATRIX_COLLISION_DETECTED) { // Collision detected on boundary
-                        game.play_state = PLAY_STATE_TOP_OUT;
-
-                    } else {
-                        matrix_status = matrix_check_collision(&matrix, &tetrimino);
-                        if (matrix_status == MATRIX_STACK_COLLISION) { // Topped out
-                            // Restore previous matrix state
-                            matrix_copy(&matrix, &temp_matrix);
-                            game.play_state = PLAY_STATE_TOP_OUT;
-                        } else {
-                            game.play_state = PLAY_STATE_NORMAL;
-                            game.drop_time_start = TIM2->CNT;
-                        }
-                    }
-                }
-            }
-
-            rendering_status = renderer_render(&renderer, &matrix, &tetrimino, &game);
-            if (rendering_status == RENDERER_UPDATED) {
-                render_count++;
-            }
-
-            if (game.play_state == PLAY_STATE_TOP_OUT) {
-                ui_display_top_out();
-                renderer_top_out_start(&renderer);
-                game.state = GAME_STATE_GAME_ENDED;
-            }
-
-            // Save previous controller button state
-            controller_previous_buttons = controller_current_buttons;
-
-            // TODO: Update UI
-            fps_time_diff = util_time_diff_us(fps_time_last_update, TIM2->CNT);
-            if (fps_time_diff >= 500000 && game.play_state != PLAY_STATE_TOP_OUT) {
-                fps_start_count = fps_end_count;
-                fps_end_count = render_count;
-                fps_time_last_update = TIM2->CNT;
-                ui_display_fps(fps_start_count, fps_end_count, fps_time_diff);
-                elapsed_time = util_time_diff_us(game.game_start_time, TIM2->CNT) / 1000000; // seconds
-                ui_elapsed_time(elapsed_time);
-//                ui_display_game_info(&game);
-                ui_display_game_progress(&game);
-            }
-            break;
-
-            /* ------------------------- PAUSE MENU ------------------------ */
-        case GAME_STATE_PAUSE:
-            // TODO: Display pause menu
-            break;
-
-            /* -------------------------- GAME OVER ------------------------ */
-        case GAME_STATE_GAME_ENDED:
-            if (renderer_top_out_animate(&renderer) == RENDERER_ANIMATION_DONE) {
-
-                // Save score if is better than a high score
-
-                game.state = GAME_STATE_GAME_OVER_WAIT;
-
-                // Flush the buffer
-                ring_buffer_flush(&controller_buffer);
-                // Persist settings and high scores by writing them to EEPROM
-//                eeprom_write_settings(&eeprom, &settings);
-//                eeprom_write_high_scores(&eeprom, high_score_ptrs);
-            }
-            break;
-
-            /* ---------------------- GAME OVER WAIT ---------------------- */
-        case GAME_STATE_GAME_OVER_WAIT:
-
-            if (ring_buffer_dequeue(&controller_buffer, &controller_current_buttons) == true) {
-                if (controller_current_buttons & SNES_BUTTON_START) {
-                    game.state = GAME_STATE_MENU;
-                    menu.ui_status = UI_MENU_DRAW;
-//                    game.state = GAME_STATE_PREPARE_GAME;
-                    ssd1306_Fill(Black);
-                    ssd1306_UpdateScreen();
-                    break;
-                }
-            }
-            if (util_time_expired_delay(press_start_timer_start, 500000)) { // 500ms
-                press_start_timer_start = TIM2->CNT;
-                press_start_state = !press_start_state;
-                ssd1306_SetCursor(30, 55);
-                if (press_start_state) {
-                    ssd1306_WriteString("                ", Font_6x8, White); // erase line
-                } else {
-                    ssd1306_WriteString("Press start", Font_6x8, White);
-                }
-                ssd1306_UpdateScreen();
-                redraw_screen_count++;
-            }
-            break;
-
-            /* ------------------------ HIGH SCORES ------------------------ */
-        case GAME_STATE_HIGH_SCORE:
-            // TODO: Display high scores
-            if (ring_buffer_dequeue(&controller_buffer, &controller_current_buttons) == true) {
-                if (controller_current_buttons & (SNES_BUTTON_START | SNES_BUTTON_B | SNES_BUTTON_Y)) {
-                    game.state = GAME_STATE_MENU;
-                    menu.ui_status = UI_MENU_DRAW;
-                    ssd1306_Fill(Black);
-                    ssd1306_UpdateScreen();
-                    break;
-                }
-            }
-            ui_display_high_scores(high_score_ptrs, NULL);
-            break;
-
-            /* ------------------------ SETTINGS MENU ---------------------- */
-        case GAME_STATE_SETTINGS:
-            // TODO: Display settings menu
-            ui_main_menu_selection(&menu);
-            if (util_time_expired_delay(menu.cursor_start_time, 500000)) {
-                menu.cursor_start_time = TIM2->CNT;
-                ui_menu_cursor_blink(&menu);
-            }
-            if (ring_buffer_dequeue(&controller_buffer, &controller_current_buttons) == true) {
-                if (controller_current_buttons & SNES_BUTTON_UP) {
-                    ui_menu_controller_move_up(&menu);
-                }
-                if (controller_current_buttons & SNES_BUTTON_DOWN) {
-                    ui_menu_controller_move_down(&menu);
-                }
-
-                if (controller_current_buttons & SNES_BUTTON_A) {
-                    switch (menu.current_selection_id) {
-                    case 0:
-                        // Modify brightness
-                        renderer_brightness_test(&renderer);
-                        break;
-                    case 1:
-                        // Debug 1 or 0 (true or false)
-                        ui_display_not_implemented(&snes_controller);
-                        menu.ui_status = UI_MENU_DRAW;
-                        break;
-                    case 2:
-                        // Reset high score (summons that function?)
-                        ui_display_not_implemented(&snes_controller);
-                        menu.ui_status = UI_MENU_DRAW;
-                        break;
-                    case 3:
-                        // Display scoreboard ID
-                        ui_display_not_implemented(&snes_controller);
-                        menu.ui_status = UI_MENU_DRAW;
-                        break;
-                    }
-                }
-
-                if (controller_current_buttons & SNES_BUTTON_B) {
-                    ui_menu_id_set(&menu, 0);
-                    menu.ui_status = UI_MENU_DRAW;
-                    game.state = GAME_STATE_MENU;
-                    renderer_clear(&renderer);
-                }
-            }
-            break;
-
-            /* ------------------------ TEST FEATURE ------------------------ */
-        case GAME_STATE_TEST_FEATURE:
-            /* Developer test code START */
-//            ui_display_high_scores(high_score_ptrs, NULL);
-//            rendering_status = renderer_test_render(&renderer);
-//#if DEBUG_OUTPUT
-//            if (rendering_status == RENDERER_UPDATED) {
-//                render_count++;
-//            }
-//#endif
-//            if(main_menu == 0)
-//            {
-//                ui_main_menu_selection();
-//                main_menu = 1;
-//            }
-//            if (ring_buffer_dequeue(&controller_buffer, &controller_current_buttons) == true) {
-//                if (controller_current_buttons & SNES_BUTTON_DOWN) {
-//                    if (array_position > 1) {
-//                        array_position = 1;
-//                    } else {
-//                        array_position++;
-//                    }
-//
-//                    if (cursor_position < 2) {
-//                        cursor_position++;
-//                    } else {
-//                        cursor_position = 2;
-//                    }
-//                }
-//                if (controller_current_buttons & SNES_BUTTON_UP) {
-//                    if (array_position < 0) {
-//                        array_position = 0;
-//                    } else {
-//                        array_position--;
-//                    }
-//
-//                    if (cursor_position > 0) {
-//                        cursor_position--;
-//                    } else {
-//                        cursor_position = 0;
-//                    }
-//                }
-//            ssd1306_SetCursor(32, 14);
-//            ssd1306_WriteString(main_menu_list[array_position], Font_7x10, White);
-//
-//            ssd1306_SetCursor(32, 30);
-//            ssd1306_WriteString(main_menu_list[array_position + 1], Font_7x10, White);
-//
-//            ssd1306_SetCursor(32, 48);
-//            ssd1306_WriteString(main_menu_list[array_position + 2], Font_7x10, White);
-//
-//
-//            ssd1306_SetCursor(10, select_arrow_locations[cursor_position]);
-//            ssd1306_WriteString(">", Font_6x8, White);
-//
-//            ssd1306_UpdateScreen();
-//            }
-            /* Developer test code END */
-            break;
-
-            /* ----------------------- UNKNOWN STATES ---------------------- */
-        default:
-            // TODO: Handle unknown states (fail-safe)
-            break;
-        } // end switch
-
-        game_loop_count++;
-        led_indicator(&hb_led);
-        led_indicator(&rj45_led);
+        scheduler_idle(&scheduler, wake_time, game_loop_sleep);
     } // end for loop
 } // end game_loop
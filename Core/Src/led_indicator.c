@@ -32,16 +32,22 @@ uint32_t led_timer_frequency_to_ms(uint32_t delay) {
     return (delay * LED_INDICATOR_TIMER_FREQUENCY) / 1000;
 }
 
+static void led_timer_expired(void *context);
+
 /**
  * @brief Initialize the LED
  * @param led: Pointer to the LED structure
  * @param port: GPIO port
  * @param pin: GPIO pin
  * @param delay: Delay in ms
+ * @param timer_wheel: Timer wheel for the blink timer, on the same 1 MHz count as htim_delay
  * @return LED_OK if successful, LED_ERROR if not
  */
-led_status_t led_init(led_indicator_t *led, GPIO_TypeDef *port, uint16_t pin, TIM_HandleTypeDef *htim_delay) {
+led_status_t led_init(led_indicator_t *led, GPIO_TypeDef *port, uint16_t pin, TIM_HandleTypeDef *htim_delay,
+        timer_wheel_t *timer_wheel) {
     memset(led, 0, sizeof(led_indicator_t));
+    led->timer_wheel = timer_wheel;
+    timer_wheel_timer_init(&led->blink_timer, led_timer_expired, led);
     led->port = port;
     led->pin = pin;
     led->uses_pull_up = 1;
@@ -64,11 +70,14 @@ led_status_t led_init(led_indicator_t *led, GPIO_TypeDef *port, uint16_t pin, TI
  * @param hitm: Timer handle
  * @param channel: Timer channel
  * @param delay: Delay in ms
+ * @param timer_wheel: Timer wheel for the blink timer, on the same 1 MHz count as htim_delay
  * @return LED_OK if successful, LED_ERROR if not
  */
 led_status_t led_init_pwm(led_indicator_t *led, TIM_HandleTypeDef *htim_pwm, uint32_t channel,
-        TIM_HandleTypeDef *htim_delay) {
+        TIM_HandleTypeDef *htim_delay, timer_wheel_t *timer_wheel) {
     memset(led, 0, sizeof(led_indicator_t));
+    led->timer_wheel = timer_wheel;
+    timer_wheel_timer_init(&led->blink_timer, led_timer_expired, led);
     led->htim_pwm = htim_pwm;
     led->channel = channel;
     led->uses_pwm = 1;
@@ -84,33 +93,6 @@ led_status_t led_init_pwm(led_indicator_t *led, TIM_HandleTypeDef *htim_pwm, uin
     return LED_OK;
 }
 
-/**
- * @brief Check if the LED time has elapsed with rollover handling
- * @param led: Pointer to the LED structure
- * @return 1 if time has expired, 0 if not
- */
-uint8_t led_time_expired(led_indicator_t *led) {
-    uint32_t current_time = __HAL_TIM_GET_COUNTER(led->htim_delay);
-    if (led->start_time <= led->end_time) {
-        // Normal case: no rollover
-        if (current_time >= led->end_time) {
-            return 1;
-        } else if (!(current_time >= led->start_time && current_time < led->end_time)) {
-            // Reset the LED state if the current time is outside the start and end time
-            return 1;
-        }
-    } else {
-        // Rollover case: end_time < start_time
-        if (current_time >= led->end_time && current_time < led->start_time) {
-            return 1;
-        } else if (current_time > led->end_time && current_time < led->start_time) {
-            // Reset the LED state if the current time is outside the start and end time
-            return 1;
-        }
-    }
-    return 0;
-}
-
 /**
  * @brief Set the state of the LED
  * @param led: Pointer to the LED structure
@@ -290,7 +272,61 @@ void led_serial_indicator(led_indicator_t *led, led_state_t state) {
 }
 
 /**
- * @brief Control the LED
+ * @brief Blink timer expired, step the blink or reverse the fade
+ * @param context: Pointer to the LED structure
+ */
+static void led_timer_expired(void *context) {
+    led_indicator_t *led = context;
+    uint32_t current_time = __HAL_TIM_GET_COUNTER(led->htim_delay);
+    uint32_t delay = (led->blink_state == LED_POWER_ON ? led->blink_on_delay : led->blink_off_delay);
+
+    if (!led->active || !led->blink_running) {
+        return;
+    }
+
+    switch (led->mode) {
+    case LED_BLINK_CONTINUOUS:
+        led->blink_state = !led->blink_state;
+        led_set_state(led, led->blink_state);
+        break;
+
+    case LED_N_BLINK:
+        if (led->blink_counter == 0 && led->blink_state == LED_POWER_ON) {
+            led->blink_state = LED_POWER_OFF;
+            led_set_state(led, led->blink_state);
+        } else if (led->blink_counter > 0) {
+            led->blink_state = !led->blink_state;
+            if (led->blink_state == LED_POWER_OFF && led->blink_counter > 0) {
+
+                if (led->blink_counter == 1) {
+                    led->blink_counter = 0;
+                } else {
+                    led->blink_counter--;
+                }
+            }
+            led_set_state(led, led->blink_state);
+        }
+        break;
+
+    case LED_FADE_CONTINUOUS:
+        if (led->fade_direction == LED_DUTY_DECREASING) {
+            led->fade_direction = LED_DUTY_INCREASING;
+        } else {
+            led->fade_direction = LED_DUTY_DECREASING;
+        }
+        led->start_time = current_time;
+        led->end_time = led->start_time + delay;
+        break;
+
+    default:
+        return; // Mode changed to one without a timer
+    }
+
+    timer_wheel_arm(led->timer_wheel, &led->blink_timer, current_time, delay);
+}
+
+/**
+ * @brief Control the LED, blink and fade steps run from the blink timer
  * @param led: Pointer to the LED structure
  * @return LED_OK if successful, LED_ERROR if not
  */
@@ -317,40 +353,12 @@ led_status_t led_indicator(led_indicator_t *led) {
         if (led->mode_changed) {
             led->mode_changed = 0;
             led->blink_state = LED_POWER_OFF;
-            led->start_time = __HAL_TIM_GET_COUNTER(led->htim_delay);
-            led->end_time = led->start_time; // Set to expire immediately
             led->blink_running = 1;
+            // Set to expire immediately
+            timer_wheel_arm(led->timer_wheel, &led->blink_timer, __HAL_TIM_GET_COUNTER(led->htim_delay), 0);
         }
         if (led->blink_running) {
-            if (led_time_expired(led)) {
-                led->start_time = __HAL_TIM_GET_COUNTER(led->htim_delay);
-                led->end_time = led->start_time
-                        + (led->blink_state == LED_POWER_ON ? led->blink_on_delay : led->blink_off_delay);
-
-                if (led->mode == LED_N_BLINK) {
-                    if (led->blink_counter == 0 && led->blink_state == LED_POWER_ON) {
-                        led->blink_state = LED_POWER_OFF;
-                        led_set_state(led, led->blink_state);
-                    } else if (led->blink_counter > 0) {
-                        led->blink_state = !led->blink_state;
-                        if (led->blink_state == LED_POWER_OFF && led->blink_counter > 0) {
-
-                            if (led->blink_counter == 1) {
-                                led->blink_counter = 0;
-                            } else {
-                                led->blink_counter--;
-                            }
-                        }
-                        led_set_state(led, led->blink_state);
-                    }
-//                    } else if (led->blink_counter == 0 && led->blink_state == LED_POWER_ON) {
-//                        led->blink_state = LED_POWER_OFF; // Stop blinking until the counter is reset
-//                    }
-                } else {
-                    led->blink_state = !led->blink_state;
-                    led_set_state(led, led->blink_state);
-                }
-            } else if (led->blink_state == LED_POWER_OFF) {
+            if (led->blink_state == LED_POWER_OFF) {
                 // Check if the LED is actually off
                 if (led->uses_pwm) {
                     pwm_duty = __HAL_TIM_GET_COMPARE(led->htim_pwm, led->channel);
@@ -380,23 +388,9 @@ led_status_t led_indicator(led_indicator_t *led) {
             led->start_time = __HAL_TIM_GET_COUNTER(led->htim_delay);
             led->end_time = led->start_time; // Set to expire immediately
             led->blink_running = 1;
+            timer_wheel_arm(led->timer_wheel, &led->blink_timer, led->start_time, 0);
         }
         if (led->blink_running) {
-            if (led_time_expired(led)) {
-                if (led->fade_direction == LED_DUTY_DECREASING) {
-                    led->fade_direction = LED_DUTY_INCREASING;
-//                    print_terminal("OK\tIncreasing Duty\n");
-                } else {
-                    led->fade_direction = LED_DUTY_DECREASING;
-//                    print_terminal("OK\tDecreasing Duty\n");
-                }
-                led->start_time = __HAL_TIM_GET_COUNTER(led->htim_delay);
-                led->end_time = led->start_time
-                        + (led->blink_state == LED_POWER_ON ? led->blink_on_delay : led->blink_off_delay);
-                if (led->end_time < led->start_time) {
-//                    print_terminal("OK\tRollover\n");
-                }
-            }
             pwm_duty = led_calculate_duty(led);
 //            ticks = __HAL_TIM_GET_COUNTER(led->htim_delay);
 //            if (ticks > 64000 || ticks < 1000) {
@@ -32,6 +32,7 @@
 #include "ws2812.h"
 #include "game_loop.h"
 #include "itm_debug.h"
+#include "timebase.h"
 
 /* USER CODE END Includes */
 
@@ -59,12 +60,14 @@ extern led_t led;
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 /* USER CODE BEGIN PFP */
-
+static uint32_t tim2_counter(void);
+static uint8_t tim2_overflow_pending(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
-
+// TIM2 counts microseconds (90 MHz / 90) over 32 bits, its overflow interrupt extends it to 64 bits
+static const timebase_clock_t tim2_clock = { .counter = tim2_counter, .overflow_pending = tim2_overflow_pending };
 /* USER CODE END 0 */
 
 /**
@@ -109,6 +112,7 @@ int main(void) {
     MX_USB_OTG_FS_HCD_Init();
     /* USER CODE BEGIN 2 */
 
+    timebase_init(&tim2_clock);
     HAL_TIM_Base_Start_IT(&htim2);
 #if DEBUG_OUTPUT
     printf("Starting default task\nInitializing game variables and states\n");
@@ -185,9 +189,30 @@ void SystemClock_Config(void) {
 }
 
 /* USER CODE BEGIN 4 */
+/**
+ * @brief  TIM2 count for the timebase
+ * @param  None
+ * @retval Count in microseconds
+ */
+static uint32_t tim2_counter(void) {
+    return TIM2->CNT;
+}
+
+/**
+ * @brief  Check if TIM2 wrapped and its overflow interrupt has not run yet
+ * @param  None
+ * @retval 1 if the update flag is set, 0 if not
+ */
+static uint8_t tim2_overflow_pending(void) {
+    return (TIM2->SR & TIM_SR_UIF) != 0;
+}
+
 void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim) {
-    HAL_TIM_PWM_Stop_DMA(&htim3, TIM_CHANNEL_1);
-    led.data_sent_flag = 1;
+    // Only the LED data DMA on TIM3 ends a frame, other timers reach here on their compare events
+    if (htim->Instance == TIM3) {
+        HAL_TIM_PWM_Stop_DMA(&htim3, TIM_CHANNEL_1);
+        led.data_sent_flag = 1;
+    }
 }
 /* USER CODE END 4 */
 
@@ -207,6 +232,9 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
         HAL_IncTick();
     }
     /* USER CODE BEGIN Callback 1 */
+    if (htim->Instance == TIM2) {
+        timebase_overflow();
+    }
 
     /* USER CODE END Callback 1 */
 }
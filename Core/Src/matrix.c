@@ -28,15 +28,8 @@
 #include <stdint.h>
 #include "color_palette.h"
 
-//@formatter:off
-const uint16_t line_clear_mask[] = {
-    0b0000000000000000,  // 0x0000
-    0b0001000000001000, // 0x1008
-    0b0001100000011000, // 0x1818
-    0b0001110000111000, // 0x1C38
-    0b0001111001111000 // 0x1E78
-};
-//@formatter:on
+_Static_assert(COLOR_GARBAGE_INDEX < (1 << MATRIX_PALETTE_PLANES), "palette planes must hold the garbage index");
+
 
 /**
  * @brief  Initialize bitboards (tetrimino, fallen blocks, palette)
@@ -61,9 +54,12 @@ matrix_status_t matrix_clear(matrix_t *matrix) {
     for (int i = 0; i < MATRIX_DATA_SIZE; i++) {
         matrix->playfield[i] = 0;
         matrix->stack[i] = 0;
-        matrix->palette1[i] = 0;
-        matrix->palette2[i] = 0;
+        for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+            matrix->palette[plane][i] = 0;
+        }
     }
+    memset(&matrix->surface, 0, sizeof(matrix_surface_t));
+    matrix->stack_hash = 0;
     matrix->tetris_flag = 0;
     return MATRIX_OK;
 }
@@ -81,133 +77,147 @@ matrix_status_t matrix_reset_playfield(matrix_t *matrix) {
 }
 
 /**
- * @brief  Add tetrimino to matrix
- * @param  bitboards, tetrimino object, tetrimino coordinates
- * @retval None
+ * @brief  Check tetrimino rows against the matrix bottom and boundaries
+ * @param  shape offset, tetrimino coordinates
+ * @retval MATRIX_OK if the tetrimino is within the boundaries, otherwise the reason it is not
  */
+static matrix_status_t matrix_check_boundaries(uint8_t shape_offset, uint8_t x, uint8_t y) {
+    const matrix_row_t *row_masks;
+    uint8_t row_index;
 
-matrix_status_t matrix_add_tetrimino(matrix_t *matrix, tetrimino_t *tetrimino) {
-    uint8_t shape_offset = 0;
-    uint16_t row_bitmap = 0;
-    uint32_t working_playfield = 0;
-    uint32_t temp_playfield[MATRIX_DATA_SIZE];
-    uint8_t row_index = 0;
-
-    // Reset playfield
-    matrix_reset_playfield(matrix);
-
-    memset(temp_playfield, 0, sizeof(temp_playfield));
-    for (int i = 0; i < MATRIX_DATA_SIZE; i++) {
-        temp_playfield[i] = matrix->playfield[i];
+    // Check if tetrimino is within visible bounds
+    if (y >= PLAYING_FIELD_HEIGHT + TETRIMINO_CENTER_Y) {
+        return MATRIX_OUT_OF_BOUNDS;
     }
 
-    // Check if tetrimino is within visible bounds
-    if (tetrimino->y >= PLAYING_FIELD_HEIGHT + TETRIMINO_CENTER_Y) {
+    if (y >= PLAYING_FIELD_HEIGHT && x > PLAYING_FIELD_WIDTH - TETRIMINO_CENTER_X) {
         return MATRIX_OUT_OF_BOUNDS;
     }
 
-    if (tetrimino->y >= PLAYING_FIELD_HEIGHT && tetrimino->x > PLAYING_FIELD_WIDTH - TETRIMINO_CENTER_X) {
+    if (y >= PLAYING_FIELD_HEIGHT && x < TETRIMINO_CENTER_X) {
         return MATRIX_OUT_OF_BOUNDS;
     }
 
-    if (tetrimino->y >= PLAYING_FIELD_HEIGHT && tetrimino->x < TETRIMINO_CENTER_X) {
+    if (x >= PLAYING_FIELD_WIDTH) {
         return MATRIX_OUT_OF_BOUNDS;
     }
 
-    shape_offset = tetrimino->shape_offset;
-    row_index = tetrimino->y + TETRIMINO_CENTER_Y;
+    // Rows of the shape already shifted to the tetrimino column
+    row_masks = &tetrimino_row_mask[x][shape_offset];
 
     // Check if tetrimino has reached beyond the bottom of the matrix
+    row_index = y + TETRIMINO_CENTER_Y;
     for (int i = 0; i < TETRIMINO_BLOCK_SIZE; i++) {
         // When row_index becomes "negative", it rolls over to 255, it will be greater than PLAYING_FIELD
-        if (tetrimino_shape[shape_offset + i] && row_index >= PLAYING_FIELD_HEIGHT + 10) {
+        if (row_masks[i] && row_index >= PLAYING_FIELD_HEIGHT + 10) {
             return MATRIX_REACHED_BOTTOM;
         }
         row_index--;
     }
 
-// Superimpose tetrimino on playfield
-    row_index = tetrimino->y + TETRIMINO_CENTER_Y;
+    // Check if tetrimino overlaps the boundary, the walls extend above the visible rows
     for (int i = 0; i < TETRIMINO_BLOCK_SIZE; i++) {
-        if (row_index >= PLAYING_FIELD_HEIGHT) { // Check if row is within visible bounds
-            row_index--;
-            continue;
+        if (row_masks[i] & PLAYING_FIELD_BOUNDARY_BITMAP) {
+            return MATRIX_WALL_COLLISION;
         }
+    }
 
-        working_playfield = temp_playfield[row_index >> 1];
+    return MATRIX_OK;
+}
 
-        // Get the row bitmap
-        row_bitmap = (uint16_t) tetrimino_shape[shape_offset + i];
-        row_bitmap = row_bitmap << 3; // shift to avoid boundary
+/**
+ * @brief  Check if a tetrimino fits at a given position without modifying the matrix
+ * @param  matrix object, tetrimino piece and rotation, tetrimino coordinates
+ * @retval MATRIX_OK if the tetrimino fits, otherwise the reason it does not
+ */
+matrix_status_t matrix_piece_fits(matrix_t *matrix, tetrimino_piece_t piece, tetrimino_rotation_t rotation,
+        uint8_t x, uint8_t y) {
+    const matrix_row_t *row_masks;
+    uint8_t shape_offset = tetrimino_shape_offset_lut[piece][rotation];
+    uint8_t row_index;
+    matrix_status_t matrix_status;
 
-        // Shift the row to the correct position
-        if (tetrimino->x >= PLAYING_FIELD_WIDTH - TETRIMINO_CENTER_X) {
-            row_bitmap = row_bitmap >> (tetrimino->x - PLAYING_FIELD_WIDTH + TETRIMINO_CENTER_X + 1);
-        } else {
-            row_bitmap = row_bitmap << (PLAYING_FIELD_WIDTH - (tetrimino->x + TETRIMINO_CENTER_X) - 1);
-        }
+    matrix_status = matrix_check_boundaries(shape_offset, x, y);
+    if (matrix_status != MATRIX_OK) {
+        return matrix_status;
+    }
 
-        // Add the row bitmap to the playfield
-        if (row_index % 2) { // If odd, store in MSB
-            if (working_playfield & (row_bitmap << 16)) {
-                return MATRIX_WALL_COLLISION;
-            }
-            working_playfield |= row_bitmap << 16;
-        } else { // If even, store in LSB
-            if (working_playfield & row_bitmap) {
-                return MATRIX_WALL_COLLISION;
-            }
-            working_playfield |= row_bitmap;
+    // Only the rows covered by the tetrimino can collide with the stack
+    row_masks = &tetrimino_row_mask[x][shape_offset];
+    row_index = y + TETRIMINO_CENTER_Y;
+    for (int i = 0; i < TETRIMINO_BLOCK_SIZE; i++) {
+        if (row_index < PLAYING_FIELD_HEIGHT && (matrix->stack[row_index] & row_masks[i])) {
+            return MATRIX_STACK_COLLISION;
         }
-        temp_playfield[row_index >> 1] = working_playfield;
         row_index--;
     }
 
-    // No collision detected, update playfield
-    for (int i = 0; i < MATRIX_DATA_SIZE; i++) {
-        matrix->playfield[i] = temp_playfield[i];
+    return MATRIX_OK;
+}
+
+/**
+ * @brief  Add tetrimino to matrix
+ * @param  bitboards, tetrimino object, tetrimino coordinates
+ * @retval None
+ */
+
+matrix_status_t matrix_add_tetrimino(matrix_t *matrix, tetrimino_t *tetrimino) {
+    const matrix_row_t *row_masks;
+    uint8_t row_index = 0;
+    matrix_status_t matrix_status;
+
+    // Reset playfield
+    matrix_reset_playfield(matrix);
+
+    matrix_status = matrix_check_boundaries(tetrimino->shape_offset, tetrimino->x, tetrimino->y);
+    if (matrix_status != MATRIX_OK) {
+        return matrix_status;
+    }
+
+    // Superimpose tetrimino on playfield
+    row_masks = &tetrimino_row_mask[tetrimino->x][tetrimino->shape_offset];
+    row_index = tetrimino->y + TETRIMINO_CENTER_Y;
+    for (int i = 0; i < TETRIMINO_BLOCK_SIZE; i++) {
+        if (row_index < PLAYING_FIELD_HEIGHT) { // Check if row is within visible bounds
+            matrix->playfield[row_index] |= row_masks[i];
+        }
+        row_index--;
     }
 
     return MATRIX_REFRESH;
 }
 
 /**
- * @brief  Move tetrimino
+ * @brief  Move tetrimino, the playfield is only updated if the move is accepted
  * @param  tetrimino object, matrix object, direction, palette object
- * @retval status
+ * @retval MATRIX_REFRESH if the tetrimino moved, MATRIX_NO_CHANGE otherwise
  */
 matrix_status_t matrix_move_tetrimino(matrix_t *matrix, tetrimino_t *tetrimino,
         tetrimino_move_direction_t direction) {
-    tetrimino_t temp_tetrimino;
-    matrix_t temp_matrix;
-    matrix_status_t matrix_status;
-
-    tetrimino_copy(&temp_tetrimino, tetrimino);
-    matrix_copy(&temp_matrix, matrix);
+    uint8_t x = tetrimino->x;
+    uint8_t y = tetrimino->y;
 
     // Move tetrimino object in specified direction
     switch (direction) {
     case MOVE_RIGHT:
-        temp_tetrimino.x++;
-        if (temp_tetrimino.x >= PLAYING_FIELD_WIDTH) {
-            temp_tetrimino.x = PLAYING_FIELD_WIDTH - 1;
+        x++;
+        if (x >= PLAYING_FIELD_WIDTH) {
+            x = PLAYING_FIELD_WIDTH - 1;
         }
         break;
     case MOVE_LEFT:
-        temp_tetrimino.x--;
-        if (temp_tetrimino.x > PLAYING_FIELD_WIDTH) {
-            temp_tetrimino.x = 0;
+        x--;
+        if (x > PLAYING_FIELD_WIDTH) {
+            x = 0;
         }
         break;
     case MOVE_DOWN:
-        temp_tetrimino.y--;
-        if (temp_tetrimino.y > 0) {
-        }
+        y--;
         break;
     case MOVE_UP:
-        temp_tetrimino.y++;
-        if (temp_tetrimino.y >= PLAYING_FIELD_HEIGHT + TETRIMINO_CENTER_Y) {
-            temp_tetrimino.y = PLAYING_FIELD_HEIGHT + TETRIMINO_CENTER_Y - 1;
+        y++;
+        if (y >= PLAYING_FIELD_HEIGHT + TETRIMINO_CENTER_Y) {
+            y = PLAYING_FIELD_HEIGHT + TETRIMINO_CENTER_Y - 1;
         }
         break;
     default:
@@ -215,23 +225,94 @@ matrix_status_t matrix_move_tetrimino(matrix_t *matrix, tetrimino_t *tetrimino,
         break;
     }
 
-    matrix_status = matrix_add_tetrimino(&temp_matrix, &temp_tetrimino);
-    if (matrix_status == MATRIX_WALL_COLLISION) {
-        return MATRIX_NO_CHANGE;
-    } else if (matrix_status == MATRIX_OUT_OF_BOUNDS) {
+    if (matrix_piece_fits(matrix, tetrimino->piece, tetrimino->rotation, x, y) != MATRIX_OK) {
         return MATRIX_NO_CHANGE;
     }
 
-    // check for collision
-    matrix_status = matrix_check_collision(&temp_matrix, &temp_tetrimino);
-    if (matrix_status == MATRIX_STACK_COLLISION) {
-        return MATRIX_NO_CHANGE;
+    // update tetrimino position and playfield
+    tetrimino->x = x;
+    tetrimino->y = y;
+
+    return matrix_add_tetrimino(matrix, tetrimino);
+}
+
+/**
+ * @brief  Rotate tetrimino, trying the wall kicks of the rotation system in order
+ * @param  matrix object, tetrimino object, rotation direction, rotation system
+ * @retval MATRIX_REFRESH if the tetrimino rotated, MATRIX_NO_CHANGE otherwise
+ */
+matrix_status_t matrix_rotate_tetrimino(matrix_t *matrix, tetrimino_t *tetrimino, rotation_direction_t direction,
+        tetrimino_rotation_system_t rotation_system) {
+    const tetrimino_kick_t *kicks;
+    tetrimino_rotation_t rotation;
+    uint8_t kick_count;
+    uint8_t x, y;
+
+    if (direction == ROTATE_CW) {
+        rotation = (tetrimino->rotation + 1) % TETRIMINO_ROTATION_COUNT;
+    } else if (direction == ROTATE_CCW) {
+        rotation = (tetrimino->rotation + TETRIMINO_ROTATION_COUNT - 1) % TETRIMINO_ROTATION_COUNT;
+    } else {
+        return MATRIX_ERROR;
     }
-    // update bitboard matrix object
-    matrix_copy(matrix, &temp_matrix);
-    tetrimino_copy(tetrimino, &temp_tetrimino);
 
-    return MATRIX_REFRESH;
+    // NES rotation is the first SRS kick only, which is no offset
+    kicks = tetrimino_srs_kick[tetrimino->piece][tetrimino->rotation][direction];
+    kick_count = rotation_system == TETRIMINO_ROTATION_SYSTEM_SRS ? TETRIMINO_KICK_COUNT : 1;
+
+    for (int i = 0; i < kick_count; i++) {
+        x = tetrimino->x + kicks[i].x;
+        y = tetrimino->y + kicks[i].y;
+        if (matrix_piece_fits(matrix, tetrimino->piece, rotation, x, y) == MATRIX_OK) {
+            tetrimino->rotation = rotation;
+            tetrimino->shape_offset = tetrimino_shape_offset_lut[tetrimino->piece][rotation];
+            tetrimino->x = x;
+            tetrimino->y = y;
+            return matrix_add_tetrimino(matrix, tetrimino);
+        }
+    }
+
+    return MATRIX_NO_CHANGE;
+}
+
+/**
+ * @brief  Find how many rows a tetrimino can fall before it lands
+ * @param  matrix object, tetrimino object
+ * @retval Number of rows between the tetrimino and its landing position
+ */
+uint8_t matrix_drop_distance(matrix_t *matrix, tetrimino_t *tetrimino) {
+    const matrix_row_t *row_masks = &tetrimino_row_mask[tetrimino->x][tetrimino->shape_offset];
+    matrix_row_t seen_columns = 0;
+    matrix_row_t bottom_blocks;
+    uint8_t distance = PLAYING_FIELD_HEIGHT + TETRIMINO_CENTER_Y;
+    uint8_t column, height;
+    int row;
+
+    // Walk the shape bottom-up, the first block found in a column is the bottom of the piece in it.
+    // The piece lands when the lowest of those blocks reaches the top of its column.
+    for (int i = TETRIMINO_BLOCK_SIZE - 1; i >= 0; i--) {
+        bottom_blocks = row_masks[i] & ~seen_columns;
+        seen_columns |= row_masks[i];
+        row = tetrimino->y + TETRIMINO_CENTER_Y - i;
+        while (bottom_blocks) {
+            column = PLAYING_FIELD_BOUNDARY_WIDTH + PLAYING_FIELD_WIDTH - 1 - __builtin_ctz(bottom_blocks);
+            bottom_blocks &= bottom_blocks - 1;
+            height = matrix->surface.column_height[column];
+            if (row < height) {
+                // Tucked under an overhang, the column top says nothing about what is below
+                distance = 0;
+                while (matrix_piece_fits(matrix, tetrimino->piece, tetrimino->rotation, tetrimino->x,
+                        tetrimino->y - distance - 1) == MATRIX_OK) {
+                    distance++;
+                }
+                return distance;
+            }
+            if (row - height < distance) {
+                distance = row - height;
+            }
+        }
+    }
+    return distance;
 }
 
 /**
@@ -240,16 +321,21 @@ matrix_status_t matrix_move_tetrimino(matrix_t *matrix, tetrimino_t *tetrimino,
  * @retval True if collision, false otherwise
  */
 matrix_status_t matrix_check_collision(matrix_t *matrix, tetrimino_t *tetrimino) {
+    const matrix_row_t *row_masks;
     uint8_t row_index;
-    uint32_t working_playfield = 0;
-    uint32_t working_stack = 0;
 
-    for (row_index = 0; row_index < PLAYING_FIELD_HEIGHT / 2; row_index++) {
-        working_stack = matrix->stack[row_index];
-        working_playfield = matrix->playfield[row_index];
-        if (working_stack & working_playfield) {
+    if (tetrimino->x >= PLAYING_FIELD_WIDTH) {
+        return MATRIX_OUT_OF_BOUNDS;
+    }
+
+    // Only the rows covered by the tetrimino can collide with the stack
+    row_masks = &tetrimino_row_mask[tetrimino->x][tetrimino->shape_offset];
+    row_index = tetrimino->y + TETRIMINO_CENTER_Y;
+    for (int i = 0; i < TETRIMINO_BLOCK_SIZE; i++) {
+        if (row_index < PLAYING_FIELD_HEIGHT && (matrix->stack[row_index] & row_masks[i])) {
             return MATRIX_STACK_COLLISION;
         }
+        row_index--;
     }
     return MATRIX_OK;
 }
@@ -260,75 +346,90 @@ matrix_status_t matrix_check_collision(matrix_t *matrix, tetrimino_t *tetrimino)
  * @retval Returns which rows are marked for line clear by bit position
  */
 uint32_t matrix_check_line_clear(matrix_t *matrix) {
-    uint32_t stack;
     uint32_t line_clear = 0; // Covers 20 rows in the playfield
 
     for (int row = 0; row < PLAYING_FIELD_HEIGHT; row++) {
-        stack = matrix->stack[row / 2]; // Get stack value for the row
-        if (row % 2 == 0) { // Even row (LSB)
-            if ((stack & PLAYING_FIELD_FILLED_ROW_MASK) == PLAYING_FIELD_FILLED_ROW_MASK) {
-                line_clear |= (1 << row);  // Mark row as full
-            }
-        } else { // Odd row (MSB)
-            stack = stack >> 16; // Shift to get MSB
-            if ((stack & PLAYING_FIELD_FILLED_ROW_MASK) == PLAYING_FIELD_FILLED_ROW_MASK) {
-                line_clear |= (1 << row); // Mark row as full
-            }
+        if ((matrix->stack[row] & PLAYING_FIELD_FILLED_ROW_MASK) == PLAYING_FIELD_FILLED_ROW_MASK) {
+            line_clear |= (1 << row);  // Mark row as full
         }
     }
     return line_clear; // Return which rows are full
 }
 
+/**
+ * @brief  Check for line clear in the rows covered by a locked tetrimino
+ * @param  matrix object, locked tetrimino object, pointer to store number of lines cleared
+ * @retval Returns which rows are marked for line clear by bit position
+ */
+uint32_t matrix_check_tetrimino_line_clear(matrix_t *matrix, tetrimino_t *tetrimino, uint8_t *lines) {
+    const matrix_row_t *row_masks = &tetrimino_row_mask[tetrimino->x][tetrimino->shape_offset];
+    uint32_t line_clear = 0;
+    uint8_t row_index = tetrimino->y + TETRIMINO_CENTER_Y;
+    uint8_t count = 0;
+
+    // Only rows the tetrimino was locked into can have become full
+    for (int i = 0; i < TETRIMINO_BLOCK_SIZE; i++) {
+        if (row_masks[i] && row_index < PLAYING_FIELD_HEIGHT
+                && (matrix->stack[row_index] & PLAYING_FIELD_FILLED_ROW_MASK) == PLAYING_FIELD_FILLED_ROW_MASK) {
+            line_clear |= (1 << row_index);  // Mark row as full
+            count++;
+        }
+        row_index--;
+    }
+
+    *lines = count;
+    return line_clear;
+}
+
+/**
+ * @brief  Hash key of one stack row, XOR-ed in and out of the stack hash as the row changes
+ * @param  row index, row bitmap
+ * @retval Key of the row contents at this height, 0 for an empty row
+ */
+static inline uint32_t matrix_row_key(int row, matrix_row_t bitmap) {
+    if (!bitmap) {
+        return 0;
+    }
+    return util_hash32(bitmap + row * 0x9E3779B9);
+}
+
 /**
  * @brief  Start line clear animation
- * @param  matrix animation object, delay
+ * @param  matrix animation object, game frames between animation frames
  * @retval None
  */
-void matrix_line_clear_start(matrix_t *matrix, uint32_t delay) {
+void matrix_line_clear_start(matrix_t *matrix, uint8_t delay_frames) {
     memset(&matrix->animation, 0, sizeof(matrix_animation_t));
     matrix->animation.frame_nbr = CLEAR_LINE_NUM_FRAMES - 1;
-    matrix->animation.animation_timer_delay = delay;
-    matrix->animation.animation_timer_start = TIM2->CNT;
+    matrix->animation.animation_frame_delay = delay_frames;
 }
 
 /**
  * @brief  Animate line clear
- * @param  matrix_t, line_clear bitmap
+ * @param  matrix_t, line_clear bitmap, game frames elapsed since the previous call
  * @retval Returns status of the operation, true if line clear is complete
  */
-uint8_t matrix_line_clear_animate(matrix_t *matrix, uint32_t line_clear) {
+uint8_t matrix_line_clear_animate(matrix_t *matrix, uint32_t line_clear, uint8_t frames) {
 
-    uint32_t working_stack_row;
-    uint32_t working_stack_mask;
-    uint32_t working_palette1_row;
-    uint32_t working_palette2_row;
+    matrix_row_t working_stack_mask;
 
     // Check if line clear is complete and return true
     if (!line_clear) {
         return 1;
     }
 
-    if (util_time_expired_delay(matrix->animation.animation_timer_start,
-            matrix->animation.animation_timer_delay)) {
+    matrix->animation.animation_frame_count += frames;
+    if (matrix->animation.animation_frame_count >= matrix->animation.animation_frame_delay) {
+        // Clear from the center outwards, frame n keeps the n outermost columns on each side
+        working_stack_mask = PLAYING_FIELD_EDGE_MASK(matrix->animation.frame_nbr);
         for (int i = 0; i < PLAYING_FIELD_HEIGHT; i++) {
-            working_stack_row = matrix->stack[i / 2];
-            working_palette1_row = matrix->palette1[i / 2];
-            working_palette2_row = matrix->palette2[i / 2];
             if (line_clear & (1 << i)) {
-                if (i % 2 == 0) { // Even row (LSB)
-                    working_stack_mask = 0xFFFF0000 | line_clear_mask[matrix->animation.frame_nbr]; // mask for even row and retain MSB
-                    working_stack_row &= working_stack_mask;
-                    working_palette1_row &= working_stack_mask;
-                    working_palette2_row &= working_stack_mask;
-                } else { // Odd row (MSB)
-                    working_stack_mask = line_clear_mask[matrix->animation.frame_nbr] << 16 | 0xFFFF; // mask for odd row and retain LSB
-                    working_stack_row &= working_stack_mask;
-                    working_palette1_row &= working_stack_mask;
-                    working_palette2_row &= working_stack_mask;
+                matrix->stack_hash ^= matrix_row_key(i, matrix->stack[i])
+                        ^ matrix_row_key(i, matrix->stack[i] & working_stack_mask);
+                matrix->stack[i] &= working_stack_mask;
+                for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+                    matrix->palette[plane][i] &= working_stack_mask;
                 }
-                matrix->stack[i / 2] = working_stack_row;
-                matrix->palette1[i / 2] = working_palette1_row;
-                matrix->palette2[i / 2] = working_palette2_row;
             }
         }
 
@@ -337,11 +438,84 @@ uint8_t matrix_line_clear_animate(matrix_t *matrix, uint32_t line_clear) {
         }
 
         matrix->animation.frame_nbr--;
-        matrix->animation.animation_timer_start = TIM2->CNT;
+        matrix->animation.animation_frame_count = 0;
     }
     return 0;
 }
 
+/**
+ * @brief  Update stack totals derived from the column heights
+ * @param  matrix_t
+ * @retval None
+ */
+static void matrix_surface_update_totals(matrix_t *matrix) {
+    uint16_t height_sum = 0;
+    uint8_t max_height = 0;
+
+    for (int column = 0; column < PLAYING_FIELD_WIDTH; column++) {
+        height_sum += matrix->surface.column_height[column];
+        if (matrix->surface.column_height[column] > max_height) {
+            max_height = matrix->surface.column_height[column];
+        }
+    }
+    matrix->surface.max_height = max_height;
+    // Every cell below the top of a column is either a block or a hole
+    matrix->surface.hole_count = height_sum - matrix->surface.block_count;
+}
+
+/**
+ * @brief  Recompute column heights, block and hole count from the stack
+ * @param  matrix_t
+ * @retval None
+ */
+void matrix_surface_recompute(matrix_t *matrix) {
+    matrix_row_t seen_columns = 0;
+    matrix_row_t top_blocks;
+
+    matrix->surface.block_count = 0;
+    for (int column = 0; column < PLAYING_FIELD_WIDTH; column++) {
+        matrix->surface.column_height[column] = 0;
+    }
+
+    // Top down, the first block found in a column is its top
+    for (int i = PLAYING_FIELD_HEIGHT - 1; i >= 0; i--) {
+        matrix->surface.block_count += util_bit_count(matrix->stack[i] & PLAYING_FIELD_MASK);
+        top_blocks = matrix->stack[i] & PLAYING_FIELD_MASK & ~seen_columns;
+        seen_columns |= top_blocks;
+        while (top_blocks) {
+            matrix->surface.column_height[PLAYING_FIELD_BOUNDARY_WIDTH + PLAYING_FIELD_WIDTH - 1
+                    - __builtin_ctz(top_blocks)] = i + 1;
+            top_blocks &= top_blocks - 1;
+        }
+    }
+    matrix_surface_update_totals(matrix);
+}
+
+/**
+ * @brief  Recompute the stack hash from scratch, needed after writing the stack directly
+ * @param  matrix_t
+ * @retval None
+ */
+void matrix_hash_recompute(matrix_t *matrix) {
+    matrix->stack_hash = 0;
+    for (int i = 0; i < PLAYING_FIELD_HEIGHT; i++) {
+        matrix->stack_hash ^= matrix_row_key(i, matrix->stack[i]);
+    }
+}
+
+/**
+ * @brief  Hash of the stack and the falling tetrimino, equal positions always hash equal
+ * @param  matrix_t, tetrimino
+ * @retval 32-bit position hash, block colors are not part of the position
+ */
+uint32_t matrix_position_hash(matrix_t *matrix, tetrimino_t *tetrimino) {
+    uint32_t piece_state = (uint32_t) tetrimino->piece | (uint32_t) tetrimino->rotation << 4
+            | (uint32_t) tetrimino->x << 8 | (uint32_t) tetrimino->y << 16;
+
+    // Salted so a piece state never cancels out a row key
+    return matrix->stack_hash ^ util_hash32(piece_state ^ 0x5BD1E995);
+}
+
 /**
  * @brief  merge tetrimino to stack
  * @param  matrix_t
@@ -349,146 +523,431 @@ uint8_t matrix_line_clear_animate(matrix_t *matrix, uint32_t line_clear) {
  */
 
 matrix_status_t merge_with_stack(matrix_t *matrix, tetrimino_t *tetrimino) {
-    uint32_t working_stack_row;
-    uint32_t working_playfield_row;
-    uint32_t working_palette1_row;
-    uint32_t working_palette2_row;
-    matrix_t temp;
+    matrix_row_t working_playfield_row;
+    matrix_row_t plane_mask[MATRIX_PALETTE_PLANES];
 
-    int shape_id_index = tetrimino->piece % COLOR_PALETTES;
+    // Each palette plane takes the whole row if its bit of the piece index is set
+    for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+        plane_mask[plane] = (tetrimino->piece >> plane & 1) ? (matrix_row_t) ~0 : 0;
+    }
 
-    matrix_copy(&temp, matrix);
-    for (int i = 0; i < PLAYING_FIELD_HEIGHT / 2; i++) {
-        working_stack_row = matrix->stack[i];
-        working_palette1_row = matrix->palette1[i];
-        working_palette2_row = matrix->palette2[i];
-        working_playfield_row = matrix->playfield[i];
-        temp.stack[i] = working_stack_row | (working_playfield_row & PLAYING_FIELD_MASK);
-        if (shape_id_index == 1) {
-            temp.palette1[i] = working_palette1_row | (working_playfield_row & PLAYING_FIELD_MASK);
+    for (int i = 0; i < MATRIX_DATA_SIZE; i++) {
+        working_playfield_row = matrix->playfield[i] & PLAYING_FIELD_MASK;
+        if (!working_playfield_row) {
+            continue;
+        }
+        matrix->stack_hash ^= matrix_row_key(i, matrix->stack[i])
+                ^ matrix_row_key(i, matrix->stack[i] | working_playfield_row);
+        matrix->stack[i] |= working_playfield_row;
+        for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+            matrix->palette[plane][i] |= working_playfield_row & plane_mask[plane];
         }
 
-        if (shape_id_index == 2) {
-            temp.palette2[i] = working_palette2_row | (working_playfield_row & PLAYING_FIELD_MASK);
+        // Raise the columns covered by this row of the tetrimino
+        matrix->surface.block_count += util_bit_count(working_playfield_row);
+        for (int column = 0; column < PLAYING_FIELD_WIDTH; column++) {
+            if ((working_playfield_row & PLAYING_FIELD_COLUMN_BIT(column))
+                    && matrix->surface.column_height[column] <= i) {
+                matrix->surface.column_height[column] = i + 1;
+            }
         }
     }
-    matrix_copy(matrix, &temp);
+    matrix_surface_update_totals(matrix);
     return MATRIX_OK;
 }
 
-uint32_t matrix_find_empty_row(matrix_t *matrix) {
-    uint32_t empty_bitmap = 0;
-    uint32_t stack_row;
+/**
+ * @brief  Reposition fallen blocks after line clear
+ * @param  matrix_t, line_clear bitmap
+ * @retval None
+ */
+matrix_status_t matrix_reposition_blocks(matrix_t *matrix, uint32_t line_clear) {
+    int dest = 0;
+    uint8_t height;
+    uint8_t top_cleared;
 
-    for (int row = 0; row < PLAYING_FIELD_HEIGHT; row++) {
-        stack_row = matrix->stack[row / 2] & PLAYING_FIELD_MASK_BOUNDARY; // Filter out boundary bits
-        if (row % 2 == 0) { // Even row (LSB)
-            if ((stack_row & 0x0000FFFF) == 0) {
-                empty_bitmap |= (1 << row);
+    // Move every surviving row straight to its final position, cleared rows are skipped
+    for (int i = 0; i < PLAYING_FIELD_HEIGHT; i++) {
+        if (line_clear & (1 << i)) {
+            continue;
+        }
+        if (dest != i) {
+            matrix->stack_hash ^= matrix_row_key(dest, matrix->stack[dest]) ^ matrix_row_key(dest, matrix->stack[i]);
+            matrix->stack[dest] = matrix->stack[i];
+            for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+                matrix->palette[plane][dest] = matrix->palette[plane][i];
             }
-        } else { // Odd row (MSB)
-            if ((stack_row & 0xFFFF0000) == 0) {
-                empty_bitmap |= (1 << row);
+        }
+        dest++;
+    }
+
+    // Rows freed at the top of the stack are empty
+    for (int i = dest; i < PLAYING_FIELD_HEIGHT; i++) {
+        matrix->stack_hash ^= matrix_row_key(i, matrix->stack[i]);
+        matrix->stack[i] = 0;
+        for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+            matrix->palette[plane][i] = 0;
+        }
+    }
+
+    // Columns drop by the number of cleared rows below their top. A column whose top block was in
+    // a cleared row is rescanned downwards, the cleared rows were full so they held no holes.
+    matrix->surface.block_count -= util_bit_count(line_clear) * PLAYING_FIELD_WIDTH;
+    for (int column = 0; column < PLAYING_FIELD_WIDTH; column++) {
+        height = matrix->surface.column_height[column];
+        if (height == 0) {
+            continue;
+        }
+        top_cleared = (line_clear & (1 << (height - 1))) != 0;
+        height -= util_bit_count(line_clear & ((1 << height) - 1));
+        if (top_cleared) {
+            while (height && !(matrix->stack[height - 1] & PLAYING_FIELD_COLUMN_BIT(column))) {
+                height--;
             }
         }
+        matrix->surface.column_height[column] = height;
     }
+    matrix_surface_update_totals(matrix);
 
-    return empty_bitmap;
+    return MATRIX_REFRESH;
 }
 
 /**
- * @brief  Reposition fallen blocks after line clear
- * @param  matrix_t, line_clear bitmap
- * @retval None
+ * @brief  Push garbage rows in from the bottom of the stack, raising everything above them
+ * @param  matrix_t, tetrimino (current piece, may be NULL), number of rows, column of the hole
+ * @retval MATRIX_REFRESH if the stack rose, MATRIX_OUT_OF_BOUNDS if blocks were pushed past the top,
+ *         MATRIX_STACK_COLLISION if the stack rose into the current piece, MATRIX_NO_CHANGE if rows is 0
  */
-matrix_status_t matrix_reposition_blocks(matrix_t *matrix, uint32_t line_clear) {
-    matrix_t temp_matrix;
-    uint32_t bitmap = line_clear;
-    uint32_t carry, lsb, msb;
-    uint8_t done = 0, occupied_bitmap = 0, skip_front_row = 0, row_index = 0;
+matrix_status_t matrix_add_garbage(matrix_t *matrix, tetrimino_t *tetrimino, uint8_t rows, uint8_t hole_column) {
+    matrix_status_t status = MATRIX_REFRESH;
+    matrix_row_t garbage_row;
+    matrix_row_t garbage_palette[MATRIX_PALETTE_PLANES];
+    uint8_t height;
 
-    matrix_copy(&temp_matrix, matrix);
+    if (hole_column >= PLAYING_FIELD_WIDTH) {
+        return MATRIX_ERROR;
+    }
+    if (rows == 0) {
+        return MATRIX_NO_CHANGE;
+    }
+    if (rows > PLAYING_FIELD_HEIGHT) {
+        rows = PLAYING_FIELD_HEIGHT;
+    }
 
-    while (!done) {
+    garbage_row = PLAYING_FIELD_MASK & ~PLAYING_FIELD_COLUMN_BIT(hole_column);
+    for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+        garbage_palette[plane] = (COLOR_GARBAGE_INDEX >> plane & 1) ? garbage_row : 0;
+    }
 
-        carry = 0;
+    // Rows that would leave the top of the playfield top the stack out
+    if (matrix->surface.max_height > PLAYING_FIELD_HEIGHT - rows) {
+        status = MATRIX_OUT_OF_BOUNDS;
+    }
 
-        // Shift all blocks in the temporary stack matrix down by one row
-        for (int i = MATRIX_DATA_SIZE - 1; i >= 0; i--) {
-            lsb = matrix->stack[i] & 0x0000FFFF;
-            msb = matrix->stack[i] & 0xFFFF0000;
-            temp_matrix.stack[i] = (msb >> 16) | carry;
-            carry = lsb << 16;
+    // Single pass from the top down, each row is written once and the hash is rebuilt on the way
+    matrix->stack_hash = 0;
+    for (int i = PLAYING_FIELD_HEIGHT - 1; i >= 0; i--) {
+        if (i >= rows) {
+            matrix->stack[i] = matrix->stack[i - rows];
+            for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+                matrix->palette[plane][i] = matrix->palette[plane][i - rows];
+            }
+        } else {
+            matrix->stack[i] = garbage_row;
+            for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+                matrix->palette[plane][i] = garbage_palette[plane];
+            }
         }
+        matrix->stack_hash ^= matrix_row_key(i, matrix->stack[i]);
+    }
 
-        // Shift all blocks in the temporary palette1 matrix down by one row
-        carry = 0;
-        for (int i = MATRIX_DATA_SIZE - 1; i >= 0; i--) {
-            lsb = matrix->palette1[i] & 0x0000FFFF;
-            msb = matrix->palette1[i] & 0xFFFF0000;
-            temp_matrix.palette1[i] = (msb >> 16) | carry;
-            carry = lsb << 16;
+    if (status == MATRIX_OUT_OF_BOUNDS) {
+        matrix_surface_recompute(matrix);
+        return status;
+    }
+
+    // Every column rises by the garbage height, the hole column only if it had blocks on top
+    matrix->surface.block_count += rows * (PLAYING_FIELD_WIDTH - 1);
+    for (int column = 0; column < PLAYING_FIELD_WIDTH; column++) {
+        height = matrix->surface.column_height[column];
+        if (column != hole_column || height) {
+            matrix->surface.column_height[column] = height + rows;
         }
+    }
+    matrix_surface_update_totals(matrix);
 
-        // Shift all blocks in the temporary palette2 matrix down by one row
-        carry = 0;
-        for (int i = MATRIX_DATA_SIZE - 1; i >= 0; i--) {
-            lsb = matrix->palette2[i] & 0x0000FFFF;
-            msb = matrix->palette2[i] & 0xFFFF0000;
-            temp_matrix.palette2[i] = (msb >> 16) | carry;
-            carry = lsb << 16;
+    if (tetrimino != NULL
+            && matrix_piece_fits(matrix, tetrimino->piece, tetrimino->rotation, tetrimino->x, tetrimino->y)
+                    == MATRIX_STACK_COLLISION) {
+        status = MATRIX_STACK_COLLISION;
+    }
+    return status;
+}
+
+// Letter of each palette index in the text form of the stack, G is garbage
+static const char matrix_text_letter[] = "TJZOSLIG";
+
+/**
+ * @brief  Find the number of rows up to the highest non-empty row of the stack
+ * @param  matrix_t
+ * @retval Number of rows, 0 for an empty stack
+ */
+static uint8_t matrix_stack_top(matrix_t *matrix) {
+    uint8_t top = PLAYING_FIELD_HEIGHT;
+
+    // Scanned rather than taken from the surface, which is stale during the line clear animation
+    while (top && !(matrix->stack[top - 1] & PLAYING_FIELD_MASK)) {
+        top--;
+    }
+    return top;
+}
+
+/**
+ * @brief  Get the palette index of a stack cell
+ * @param  matrix_t, row, column bit
+ * @retval Palette index
+ */
+static uint8_t matrix_cell_color(matrix_t *matrix, uint8_t row, matrix_row_t column_bit) {
+    uint8_t color_index = 0;
+
+    for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+        if (matrix->palette[plane][row] & column_bit) {
+            color_index |= 1 << plane;
         }
+    }
+    return color_index;
+}
 
-        // Merge the original matrix with the temporary matrix from the bottom up to the first empty row
-        // This is done to avoid overwriting the original matrix
-        skip_front_row = 1;
+/**
+ * @brief  Set a stack cell and its palette index
+ * @param  matrix_t, row, column bit, palette index
+ * @retval None
+ */
+static void matrix_set_cell(matrix_t *matrix, uint8_t row, matrix_row_t column_bit, uint8_t color_index) {
+    matrix->stack[row] |= column_bit;
+    for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+        if (color_index >> plane & 1) {
+            matrix->palette[plane][row] |= column_bit;
+        }
+    }
+}
 
-        for (int i = 0; i < PLAYING_FIELD_HEIGHT; i++) {
-            row_index = i / 2;
-            if (!(bitmap & (1 << i))) {
-                skip_front_row = 0;
-                if (i % 2 == 0) { // Even row (LSB)
-                    temp_matrix.stack[row_index] = (temp_matrix.stack[row_index] & 0xFFFF0000)
-                            | (matrix->stack[row_index] & 0x0000FFFF);
-                    temp_matrix.palette1[row_index] = (temp_matrix.palette1[row_index] & 0xFFFF0000)
-                            | (matrix->palette1[row_index] & 0x0000FFFF);
-                    temp_matrix.palette2[row_index] = (temp_matrix.palette2[row_index] & 0xFFFF0000)
-                            | (matrix->palette2[row_index] & 0x0000FFFF);
-                } else { // Odd row (MSB)
-                    temp_matrix.stack[row_index] = (temp_matrix.stack[row_index] & 0x0000FFFF)
-                            | (matrix->stack[row_index] & 0xFFFF0000);
-                    temp_matrix.palette1[row_index] = (temp_matrix.palette1[row_index] & 0x0000FFFF)
-                            | (matrix->palette1[row_index] & 0xFFFF0000);
-                    temp_matrix.palette2[row_index] = (temp_matrix.palette2[row_index] & 0x0000FFFF)
-                            | (matrix->palette2[row_index] & 0xFFFF0000);
+/**
+ * @brief  Serialize the stack and its colors into a compact bit stream
+ * @param  matrix_t, buffer, buffer size (MATRIX_SERIALIZED_MAX_SIZE always fits)
+ * @retval Number of bytes written, 0 if the buffer is too small
+ *
+ * The first byte is the number of rows stored, the run of empty rows above them is not stored.
+ * Bits follow LSB first, bottom row first. Each row is a flag bit set for an empty row, or a clear
+ * flag bit, the row bitmap without its boundary and a 3-bit palette index per block (lowest bit of
+ * the bitmap first).
+ */
+uint16_t matrix_serialize(matrix_t *matrix, uint8_t *buffer, uint16_t size) {
+    uint8_t rows = matrix_stack_top(matrix);
+    uint64_t bits = 0;
+    uint8_t bit_count = 0;
+    uint16_t length = 1;
+    matrix_row_t row_bitmap, column_bit;
+
+    if (size < 1) {
+        return 0;
+    }
+    buffer[0] = rows;
+
+    for (int i = 0; i < rows; i++) {
+        // A row is at most 1 + 4 * PLAYING_FIELD_WIDTH bits, it always fits in the bit accumulator
+        row_bitmap = (matrix->stack[i] & PLAYING_FIELD_MASK) >> PLAYING_FIELD_BOUNDARY_WIDTH;
+        if (!row_bitmap) {
+            bits |= 1ULL << bit_count++;
+        } else {
+            bit_count++;
+            bits |= (uint64_t) row_bitmap << bit_count;
+            bit_count += PLAYING_FIELD_WIDTH;
+            while (row_bitmap) {
+                column_bit = (row_bitmap & -row_bitmap) << PLAYING_FIELD_BOUNDARY_WIDTH;
+                row_bitmap &= row_bitmap - 1;
+                bits |= (uint64_t) matrix_cell_color(matrix, i, column_bit) << bit_count;
+                bit_count += MATRIX_PALETTE_PLANES;
+            }
+        }
+
+        // Flush whole bytes, and the last partial byte after the top row
+        while (bit_count >= 8 || (i == rows - 1 && bit_count)) {
+            if (length >= size) {
+                return 0;
+            }
+            buffer[length++] = bits & 0xFF;
+            bits >>= 8;
+            bit_count = bit_count > 8 ? bit_count - 8 : 0;
+        }
+    }
+
+    return length;
+}
+
+/**
+ * @brief  Load the stack and its colors from a bit stream written by matrix_serialize
+ * @param  matrix_t, buffer, buffer size
+ * @retval MATRIX_OK, MATRIX_ERROR (stack left empty) if the data is truncated or too tall
+ *
+ * The playfield is reset, the surface and hash are rebuilt.
+ */
+matrix_status_t matrix_deserialize(matrix_t *matrix, const uint8_t *buffer, uint16_t size) {
+    uint64_t bits = 0;
+    uint8_t bit_count = 0;
+    uint16_t next = 1;
+    uint8_t rows, color_index;
+    matrix_row_t row_bitmap, column_bit;
+    matrix_row_t plane_row[MATRIX_PALETTE_PLANES];
+
+    matrix_clear(matrix);
+    matrix_reset_playfield(matrix);
+
+    if (size < 1 || buffer[0] > PLAYING_FIELD_HEIGHT) {
+        return MATRIX_ERROR;
+    }
+    rows = buffer[0];
+
+    for (int i = 0; i < rows; i++) {
+        // Top up the accumulator so the whole row can be decoded from it
+        while (bit_count <= 56 && next < size) {
+            bits |= (uint64_t) buffer[next++] << bit_count;
+            bit_count += 8;
+        }
+
+        if (bit_count < 1) {
+            matrix_clear(matrix);
+            return MATRIX_ERROR;
+        }
+        bit_count--;
+        if (bits & 1) {
+            bits >>= 1;
+            continue;
+        }
+        bits >>= 1;
+
+        if (bit_count < PLAYING_FIELD_WIDTH) {
+            matrix_clear(matrix);
+            return MATRIX_ERROR;
+        }
+        row_bitmap = bits & ((1UL << PLAYING_FIELD_WIDTH) - 1);
+        bits >>= PLAYING_FIELD_WIDTH;
+        bit_count -= PLAYING_FIELD_WIDTH;
+        matrix->stack[i] = row_bitmap << PLAYING_FIELD_BOUNDARY_WIDTH;
+
+        if (bit_count < util_bit_count(row_bitmap) * MATRIX_PALETTE_PLANES) {
+            matrix_clear(matrix);
+            return MATRIX_ERROR;
+        }
+        for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+            plane_row[plane] = 0;
+        }
+        while (row_bitmap) {
+            column_bit = (row_bitmap & -row_bitmap) << PLAYING_FIELD_BOUNDARY_WIDTH;
+            row_bitmap &= row_bitmap - 1;
+            color_index = bits & ((1 << MATRIX_PALETTE_PLANES) - 1);
+            bits >>= MATRIX_PALETTE_PLANES;
+            bit_count -= MATRIX_PALETTE_PLANES;
+            for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+                if (color_index >> plane & 1) {
+                    plane_row[plane] |= column_bit;
                 }
-            } else if (skip_front_row || (!skip_front_row && (bitmap & (1 << i)))) {
-                break;
             }
         }
+        for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+            matrix->palette[plane][i] = plane_row[plane];
+        }
+    }
 
-        // Update the stack matrix with the shifted blocks
-        matrix_copy(matrix, &temp_matrix);
+    matrix_surface_recompute(matrix);
+    matrix_hash_recompute(matrix);
+    return MATRIX_OK;
+}
 
-        // Update the bitmap for the next iteration
-        bitmap = matrix_find_empty_row(matrix);
+/**
+ * @brief  Write the stack as text, one letter per block (TJZOSLI, G for garbage, '.' if empty)
+ * @param  matrix_t, buffer, buffer size (MATRIX_TEXT_MAX_SIZE always fits)
+ * @retval Length of the text, 0 if the buffer is too small
+ *
+ * Rows are written from the highest non-empty row down to row 0, leftmost column first, separated
+ * by '/', the layout of matrix_debug_print on one line. An empty stack is an empty string.
+ */
+uint16_t matrix_serialize_text(matrix_t *matrix, char *buffer, uint16_t size) {
+    uint8_t rows = matrix_stack_top(matrix);
+    uint16_t length = 0;
+    matrix_row_t column_bit;
 
-        // Check if there are no more cleared rows to be repositioned
-        occupied_bitmap = 0;
-        done = 1;
+    if (size < (rows ? rows * (PLAYING_FIELD_WIDTH + 1) : 1)) {
+        return 0;
+    }
 
-        for (int i = 0; i < PLAYING_FIELD_HEIGHT; i++) {
-            if (bitmap & (1 << i)) {
-                occupied_bitmap = 1;
+    for (int i = rows - 1; i >= 0; i--) {
+        for (int column = 0; column < PLAYING_FIELD_WIDTH; column++) {
+            column_bit = PLAYING_FIELD_COLUMN_BIT(column);
+            if (matrix->stack[i] & column_bit) {
+                buffer[length++] = matrix_text_letter[matrix_cell_color(matrix, i, column_bit)];
+            } else {
+                buffer[length++] = MATRIX_TEXT_EMPTY;
             }
-            if (occupied_bitmap && !(bitmap & (1 << i))) {
-                done = 0;
-                break;
+        }
+        if (i) {
+            buffer[length++] = MATRIX_TEXT_ROW_SEPARATOR;
+        }
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+/**
+ * @brief  Load the stack from its text form, see matrix_serialize_text
+ * @param  matrix_t, text (the last row is row 0, short rows are padded with empty cells)
+ * @retval MATRIX_OK, MATRIX_ERROR (stack left empty) if the text has too many rows or columns or an
+ *         unknown letter
+ *
+ * The playfield is reset, the surface and hash are rebuilt.
+ */
+matrix_status_t matrix_deserialize_text(matrix_t *matrix, const char *text) {
+    const char *letter;
+    int row = 0;
+    int column = 0;
+
+    // The bottom row is the last one, so count the rows first
+    for (const char *c = text; *c; c++) {
+        if (*c == MATRIX_TEXT_ROW_SEPARATOR) {
+            row++;
+        }
+    }
+    matrix_clear(matrix);
+    matrix_reset_playfield(matrix);
+
+    if (row >= PLAYING_FIELD_HEIGHT) {
+        return MATRIX_ERROR;
+    }
+
+    for (; *text; text++) {
+        if (*text == MATRIX_TEXT_ROW_SEPARATOR) {
+            row--;
+            column = 0;
+            continue;
+        }
+        if (column >= PLAYING_FIELD_WIDTH) {
+            matrix_clear(matrix);
+            return MATRIX_ERROR;
+        }
+        if (*text != MATRIX_TEXT_EMPTY) {
+            letter = strchr(matrix_text_letter, *text);
+            if (letter == NULL) {
+                matrix_clear(matrix);
+                return MATRIX_ERROR;
             }
+            matrix_set_cell(matrix, row, PLAYING_FIELD_COLUMN_BIT(column), letter - matrix_text_letter);
         }
+        column++;
     }
 
-    return MATRIX_REFRESH;
+    matrix_surface_recompute(matrix);
+    matrix_hash_recompute(matrix);
+    return MATRIX_OK;
 }
 
 /**
@@ -502,42 +961,73 @@ void matrix_copy(matrix_t *dest, matrix_t *src) {
     for (int i = 0; i < MATRIX_DATA_SIZE; i++) {
         dest->playfield[i] = src->playfield[i];
         dest->stack[i] = src->stack[i];
-        dest->palette1[i] = src->palette1[i];
-        dest->palette2[i] = src->palette2[i];
+        for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+            dest->palette[plane][i] = src->palette[plane][i];
+        }
+    }
+    memcpy(&dest->surface, &src->surface, sizeof(matrix_surface_t));
+    dest->stack_hash = src->stack_hash;
+}
+
+/**
+ * @brief  Get the height of a stack column
+ * @param  matrix_t, column (0 is the leftmost column)
+ * @retval Row above the highest block in the column, 0 if empty, full height outside the playfield
+ */
+uint8_t matrix_column_height(matrix_t *matrix, uint8_t column) {
+    if (column >= PLAYING_FIELD_WIDTH) {
+        return PLAYING_FIELD_HEIGHT;
     }
+    return matrix->surface.column_height[column];
+}
+
+/**
+ * @brief  Get the height of the tallest stack column
+ * @param  matrix_t
+ * @retval Height of the tallest column
+ */
+uint8_t matrix_max_height(matrix_t *matrix) {
+    return matrix->surface.max_height;
+}
+
+/**
+ * @brief  Get the number of holes in the stack
+ * @param  matrix_t
+ * @retval Number of empty cells below the top of their column
+ */
+uint16_t matrix_hole_count(matrix_t *matrix) {
+    return matrix->surface.hole_count;
+}
+
+/**
+ * @brief  Get the depth of the well in a column, walls count as full height
+ * @param  matrix_t, column (0 is the leftmost column)
+ * @retval Number of rows the column sits below its lowest neighbor, 0 if it is not a well
+ */
+uint8_t matrix_well_depth(matrix_t *matrix, uint8_t column) {
+    uint8_t height = matrix_column_height(matrix, column);
+    uint8_t left = column > 0 ? matrix_column_height(matrix, column - 1) : PLAYING_FIELD_HEIGHT;
+    uint8_t right = matrix_column_height(matrix, column + 1);
+    uint8_t neighbor = left < right ? left : right;
+
+    return neighbor > height ? neighbor - height : 0;
 }
 
 void matrix_debug_print(matrix_t *matrix) {
-    uint32_t two_rows_bitmap;
-    uint16_t row_bitmap;
-    uint8_t row;
+    matrix_row_t row_bitmap;
+    char stack_text[MATRIX_TEXT_MAX_SIZE];
     printf("===================\n");
     printf("Matrix height: %d\n", matrix->height);
     printf("Matrix width: %d\n", matrix->width);
     printf("Matrix playfield (hex):\n");
     for (int i = 0; i < MATRIX_DATA_SIZE; i++) {
-        printf("[%0d] 0x%08lX\n", i, matrix->playfield[i]);
+        printf("[%0d] 0x%04X\n", i, (unsigned int) matrix->playfield[i]);
     }
     printf("\n");
-    for (int i = PLAYING_FIELD_HEIGHT - 1; i >= 0; i -= 2) {
-        row = i >> 1; // divide by 2 to get row index
+    for (int i = PLAYING_FIELD_HEIGHT - 1; i >= 0; i--) {
         printf("Row %02d: |", i);
-        two_rows_bitmap = matrix->playfield[row];
-        // print odd row
-        row_bitmap = (two_rows_bitmap & PLAYING_FIELD_ODD_MASK) >> 16;
-        row_bitmap = row_bitmap >> 3; // shift to remove boundary
-        for (int j = PLAYING_FIELD_WIDTH - 1; j >= 0; j--) {
-            if (row_bitmap >> j & 1) {
-                printf("X");
-            } else {
-                printf(" ");
-            }
-        }
-        printf("|\n");
-        printf("Row %02d: |", i - 1);
-        // print even row
-        row_bitmap = (two_rows_bitmap & PLAYING_FIELD_EVEN_MASK);
-        row_bitmap = row_bitmap >> 3; // shift to remove boundary
+        row_bitmap = matrix->playfield[i] & PLAYING_FIELD_MASK;
+        row_bitmap = row_bitmap >> PLAYING_FIELD_BOUNDARY_WIDTH; // shift to remove boundary
         for (int j = PLAYING_FIELD_WIDTH - 1; j >= 0; j--) {
             if (row_bitmap >> j & 1) {
                 printf("X");
@@ -548,5 +1038,6 @@ void matrix_debug_print(matrix_t *matrix) {
         printf("|\n");
     }
     printf("        +==========+\n");
+    matrix_serialize_text(matrix, stack_text, sizeof(stack_text));
+    printf("Stack: \"%s\"\n", stack_text);
 }
-
@@ -0,0 +1,293 @@
+/**
+ ******************************************************************************
+ * @file           : placement.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Generator of every reachable final tetrimino placement
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <stdint.h>
+#include "placement.h"
+#include "matrix.h"
+#include "tetrimino.h"
+#include "tetrimino_shape.h"
+
+/*
+ * The search works on columns of states. For every rotation and x position one uint32_t holds a bit
+ * per y position: fit_mask marks where the tetrimino fits and reach_mask (the visited bitset) marks
+ * where it can be moved to from the spawn pose. A column is expanded as a whole, so falling is a
+ * shift within the column and a shift or rotation moves all of its y positions at once.
+ */
+
+// Lists and child matrices of placement_perft, static as one list per level does not fit the stack
+static placement_list_t placement_perft_list[PLACEMENT_PERFT_MAX_DEPTH];
+static matrix_t placement_perft_child[PLACEMENT_PERFT_MAX_DEPTH];
+
+/**
+ * @brief  Find every y position where a tetrimino shape fits in one column, like matrix_piece_fits
+ * @param  matrix object, shape offset, tetrimino x
+ * @retval Bitmask with bit y set if the tetrimino fits at y
+ */
+static uint32_t placement_fit_mask(matrix_t *matrix, uint8_t shape_offset, uint8_t x) {
+    const matrix_row_t *row_masks = &tetrimino_row_mask[x][shape_offset];
+    uint32_t fit_mask = (1UL << PLACEMENT_Y_COUNT) - 1;
+    uint32_t blocked = 0;
+
+    for (int i = 0; i < TETRIMINO_BLOCK_SIZE; i++) {
+        if (row_masks[i] & PLAYING_FIELD_BOUNDARY_BITMAP) {
+            return 0;
+        }
+        // Shape rows below the center row would be under the bottom of the matrix for small y
+        if (row_masks[i] && i > TETRIMINO_CENTER_Y) {
+            fit_mask &= ~((1UL << (i - TETRIMINO_CENTER_Y)) - 1);
+        }
+    }
+
+    // Shape row i is at row y + TETRIMINO_CENTER_Y - i, a block in that row rules out that y.
+    // Rows above the tallest column are empty and skipped.
+    for (int row = 0; row < matrix->surface.max_height; row++) {
+        for (int i = 0; i < TETRIMINO_BLOCK_SIZE; i++) {
+            if (matrix->stack[row] & row_masks[i]) {
+                blocked |= 1UL << (row + i);
+            }
+        }
+    }
+    fit_mask &= ~(blocked >> TETRIMINO_CENTER_Y);
+
+    // Above the visible rows the tetrimino must keep its center away from the walls
+    if (x < TETRIMINO_CENTER_X || x > PLAYING_FIELD_WIDTH - TETRIMINO_CENTER_X) {
+        fit_mask &= (1UL << PLAYING_FIELD_HEIGHT) - 1;
+    }
+
+    return fit_mask;
+}
+
+/**
+ * @brief  Generate every final resting placement reachable from a tetrimino pose
+ * @param  matrix object, tetrimino at its starting pose (e.g. from tetrimino_next), rotation system,
+ *         list to fill
+ * @retval PLACEMENT_OK, PLACEMENT_NO_SPAWN if the tetrimino does not fit at its starting pose
+ *
+ * Moves are the ones the player has: shifts, gravity and soft drop, and rotations with the wall kicks
+ * of the rotation system, so slides under overhangs and rotations into gaps are included. A
+ * placement is listed once per distinct set of cells, rotations sharing a shape are merged.
+ */
+placement_status_t placement_generate(matrix_t *matrix, tetrimino_t *tetrimino,
+        tetrimino_rotation_system_t rotation_system, placement_list_t *list) {
+    uint32_t fit_mask[TETRIMINO_ROTATION_COUNT][PLAYING_FIELD_WIDTH];
+    uint32_t reach_mask[TETRIMINO_ROTATION_COUNT][PLAYING_FIELD_WIDTH] = { 0 };
+    uint16_t pending[TETRIMINO_ROTATION_COUNT] = { 0 }; // bit x set if column x has unexpanded states
+    uint8_t canonical[TETRIMINO_ROTATION_COUNT]; // first rotation with the same shape
+    const uint8_t *shape_offset = tetrimino_shape_offset_lut[tetrimino->piece];
+    uint8_t kick_count = rotation_system == TETRIMINO_ROTATION_SYSTEM_SRS ? TETRIMINO_KICK_COUNT : 1;
+    const tetrimino_kick_t *kicks;
+    uint32_t reach, previous, remaining, moved, landed, next;
+    uint8_t more, rotation, x, kick_x;
+
+    if (tetrimino->x >= PLAYING_FIELD_WIDTH || tetrimino->rotation >= TETRIMINO_ROTATION_COUNT) {
+        return PLACEMENT_ERROR;
+    }
+
+    list->piece = tetrimino->piece;
+    list->count = 0;
+
+    for (int r = 0; r < TETRIMINO_ROTATION_COUNT; r++) {
+        canonical[r] = r;
+        for (int c = 0; c < r; c++) {
+            if (shape_offset[c] == shape_offset[r]) {
+                canonical[r] = c;
+                break;
+            }
+        }
+        for (x = 0; x < PLAYING_FIELD_WIDTH; x++) {
+            if (canonical[r] == r) {
+                fit_mask[r][x] = placement_fit_mask(matrix, shape_offset[r], x);
+            } else {
+                fit_mask[r][x] = fit_mask[canonical[r]][x];
+            }
+        }
+    }
+
+    if (tetrimino->y >= PLACEMENT_Y_COUNT
+            || !(fit_mask[tetrimino->rotation][tetrimino->x] >> tetrimino->y & 1)) {
+        return PLACEMENT_NO_SPAWN;
+    }
+    reach_mask[tetrimino->rotation][tetrimino->x] = 1UL << tetrimino->y;
+    pending[tetrimino->rotation] = 1 << tetrimino->x;
+
+    do {
+        more = 0;
+        for (int r = 0; r < TETRIMINO_ROTATION_COUNT; r++) {
+            while (pending[r]) {
+                x = __builtin_ctz(pending[r]);
+                pending[r] &= pending[r] - 1;
+
+                // Fall from every reached position for as long as the row below fits
+                reach = reach_mask[r][x];
+                do {
+                    previous = reach;
+                    reach |= (reach >> 1) & fit_mask[r][x];
+                } while (reach != previous);
+                reach_mask[r][x] = reach;
+
+                // Shift left and right
+                if (x > 0) {
+                    next = reach & fit_mask[r][x - 1] & ~reach_mask[r][x - 1];
+                    if (next) {
+                        reach_mask[r][x - 1] |= next;
+                        pending[r] |= 1 << (x - 1);
+                    }
+                }
+                if (x < PLAYING_FIELD_WIDTH - 1) {
+                    next = reach & fit_mask[r][x + 1] & ~reach_mask[r][x + 1];
+                    if (next) {
+                        reach_mask[r][x + 1] |= next;
+                        pending[r] |= 1 << (x + 1);
+                    }
+                }
+
+                // Rotate, a kick is only tried from the positions where all earlier kicks failed
+                for (int direction = 0; direction < ROTATE_DIRECTION_COUNT; direction++) {
+                    rotation = (r + (direction == ROTATE_CW ? 1 : TETRIMINO_ROTATION_COUNT - 1))
+                            % TETRIMINO_ROTATION_COUNT;
+                    kicks = tetrimino_srs_kick[tetrimino->piece][r][direction];
+                    remaining = reach;
+                    for (int i = 0; i < kick_count && remaining; i++) {
+                        kick_x = x + kicks[i].x;
+                        if (kick_x >= PLAYING_FIELD_WIDTH) {
+                            continue;
+                        }
+                        if (kicks[i].y >= 0) {
+                            moved = (remaining << kicks[i].y) & fit_mask[rotation][kick_x];
+                            remaining &= ~(moved >> kicks[i].y);
+                        } else {
+                            moved = (remaining >> -kicks[i].y) & fit_mask[rotation][kick_x];
+                            remaining &= ~(moved << -kicks[i].y);
+                        }
+                        next = moved & ~reach_mask[rotation][kick_x];
+                        if (next) {
+                            reach_mask[rotation][kick_x] |= next;
+                            pending[rotation] |= 1 << kick_x;
+                        }
+                    }
+                }
+            }
+        }
+        // Rotations already passed in this sweep may have gained states
+        for (int r = 0; r < TETRIMINO_ROTATION_COUNT; r++) {
+            more |= pending[r] != 0;
+        }
+    } while (more);
+
+    // A position is final when the tetrimino cannot fall any further from it. The final positions
+    // replace the reached ones in place, a canonical rotation is never after the rotations merged into it.
+    for (int r = 0; r < TETRIMINO_ROTATION_COUNT; r++) {
+        for (x = 0; x < PLAYING_FIELD_WIDTH; x++) {
+            landed = reach_mask[r][x] & ~(fit_mask[r][x] << 1);
+            if (canonical[r] == r) {
+                reach_mask[r][x] = landed;
+            } else {
+                reach_mask[canonical[r]][x] |= landed;
+                reach_mask[r][x] = 0;
+            }
+        }
+    }
+
+    for (int r = 0; r < TETRIMINO_ROTATION_COUNT; r++) {
+        for (x = 0; x < PLAYING_FIELD_WIDTH; x++) {
+            landed = reach_mask[r][x];
+            while (landed) {
+                list->placement[list->count].rotation = r;
+                list->placement[list->count].x = x;
+                list->placement[list->count].y = __builtin_ctz(landed);
+                list->count++;
+                landed &= landed - 1;
+            }
+        }
+    }
+
+    return PLACEMENT_OK;
+}
+
+/**
+ * @brief  Lock a placement into the stack and remove the lines it completes, without animation
+ * @param  matrix object, piece, placement
+ * @retval None
+ */
+void placement_lock(matrix_t *matrix, tetrimino_piece_t piece, placement_t *placement) {
+    tetrimino_t tetrimino = { 0 };
+    uint32_t line_clear;
+    uint8_t lines;
+
+    tetrimino.piece = piece;
+    tetrimino.rotation = placement->rotation;
+    tetrimino.x = placement->x;
+    tetrimino.y = placement->y;
+    tetrimino.shape_offset = tetrimino_shape_offset_lut[piece][placement->rotation];
+
+    matrix_add_tetrimino(matrix, &tetrimino);
+    merge_with_stack(matrix, &tetrimino);
+    matrix_reset_playfield(matrix);
+
+    line_clear = matrix_check_tetrimino_line_clear(matrix, &tetrimino, &lines);
+    if (line_clear) {
+        matrix_reposition_blocks(matrix, line_clear);
+    }
+}
+
+/**
+ * @brief  Count the placements of a piece sequence to a given depth, like perft in chess engines
+ * @param  matrix object, pieces spawned in turn (depth entries), depth, rotation system
+ * @retval Number of distinct placement sequences, each piece spawned with tetrimino_spawn_piece
+ *
+ * Every placement is locked and its lines are cleared before the next piece spawns. A piece that
+ * cannot spawn ends that sequence. The lists of each level are static, the depth is limited to
+ * PLACEMENT_PERFT_MAX_DEPTH and the function is not reentrant.
+ */
+uint64_t placement_perft(matrix_t *matrix, const tetrimino_piece_t *pieces, uint8_t depth,
+        tetrimino_rotation_system_t rotation_system) {
+    placement_list_t *list;
+    matrix_t *child;
+    tetrimino_t tetrimino = { 0 };
+    uint64_t count = 0;
+
+    if (depth == 0) {
+        return 1;
+    }
+    if (depth > PLACEMENT_PERFT_MAX_DEPTH) {
+        return 0;
+    }
+    list = &placement_perft_list[depth - 1];
+    child = &placement_perft_child[depth - 1];
+
+    tetrimino_spawn_piece(&tetrimino, pieces[0]);
+    if (placement_generate(matrix, &tetrimino, rotation_system, list) != PLACEMENT_OK) {
+        return 0;
+    }
+
+    // The last level only needs the number of placements
+    if (depth == 1) {
+        return list->count;
+    }
+
+    for (int i = 0; i < list->count; i++) {
+        matrix_copy(child, matrix);
+        placement_lock(child, list->piece, &list->placement[i]);
+        count += placement_perft(child, pieces + 1, depth - 1, rotation_system);
+    }
+
+    return count;
+}
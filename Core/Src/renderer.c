@@ -25,8 +25,11 @@
 #include "main.h"
 #include "itm_debug.h"
 #include "util.h"
+#include "timebase.h"
 #include "tetrimino_shape.h"
 
+static void renderer_top_out_step(void *context);
+
 uint8_t generate_lookup_table() {
     uint16_t led_id = 0;
 
@@ -62,10 +65,13 @@ WS2812_error_t led_error;
  * @retval None
  */
 renderer_status_t renderer_init(renderer_t *renderer, uint16_t lookup_table[MATRIX_HEIGHT][MATRIX_WIDTH],
-        matrix_t *matrix, led_t *led, TIM_HandleTypeDef *htim, const uint32_t channel, uint32_t delay_length) {
+        matrix_t *matrix, led_t *led, TIM_HandleTypeDef *htim, const uint32_t channel, uint32_t delay_length,
+        timer_wheel_t *timer_wheel) {
     // TODO: Initialize WS2812 LED matrix
 
     memset(led, 0, sizeof(led_t));
+    renderer->timer_wheel = timer_wheel;
+    timer_wheel_timer_init(&renderer->top_out_timer, renderer_top_out_step, renderer);
     renderer->matrix = matrix;
     renderer->led = led;
     renderer->num_leds = (matrix->height * matrix->width);
@@ -77,7 +83,7 @@ renderer_status_t renderer_init(renderer_t *renderer, uint16_t lookup_table[MATR
     }
 
     renderer->led->data_sent_flag = 1;
-    renderer->time_last_sent = TIM2->CNT;
+    renderer->time_last_sent = timebase_now();
     renderer->next_update_time = renderer->time_last_sent + renderer->delay_length;
 
     if (generate_lookup_table(lookup_table) != 0) {
@@ -100,7 +106,7 @@ renderer_status_t renderer_create_boundary(renderer_t *renderer) {
     // render the left and right boundary lines
     for (int i = 0; i <= MAX_PLAYFIELD_HEIGHT; i++) {
         uint16_t led_left_side_num = lookup_table[i][0];
-        uint16_t led_right_side_num = lookup_table[i][MATRIX_WIDTH - 5];
+        uint16_t led_right_side_num = lookup_table[i][MAX_PLAYFIELD_WIDTH];
         WS2812_set_LED(renderer->led, led_left_side_num, 0, 0, 64);
         WS2812_set_LED(renderer->led, led_right_side_num, 0, 0, 64);
     }
@@ -118,45 +124,60 @@ renderer_status_t renderer_create_boundary(renderer_t *renderer) {
 renderer_status_t renderer_render(renderer_t *renderer, matrix_t *matrix, tetrimino_t *tetrimino,
         game_t *game) {
 
-    uint32_t two_rows_bitmap = 0;
-    uint32_t two_rows_stack_bitmap = 0;
-    uint32_t working_playfield = 0;
-    uint32_t working_stack = 0;
-    uint32_t working_palette1 = 0;
-    uint32_t working_palette2 = 0;
+    matrix_row_t working_playfield = 0;
+    matrix_row_t working_stack = 0;
+    matrix_row_t working_palette[MATRIX_PALETTE_PLANES];
+    uint8_t color_index = 0;
     uint32_t render_start_time = 0;
     uint32_t render_end_time = 0;
     uint16_t led_num = 0;
-    uint8_t row_index = 0;
     uint8_t y = 0;
 
-    // Check if it's time to update the LED matrix
-    if (TIM2->CNT < renderer->next_update_time) {
-        return RENDERER_NOT_READY;
-    }
-
-    render_start_time = TIM2->CNT;
+    // No update time check, the game loop scheduler runs this once every delay_length
+    render_start_time = timebase_now32();
 
     color_t current_piece_color = get_color_palette(game->level, tetrimino->piece);
-    color_t palette0_color = get_color_palette(game->level, 0);
-    color_t palette1_color = get_color_palette(game->level, 1);
-    color_t palette2_color = get_color_palette(game->level, 2);
+    color_t palette_color[COLOR_GARBAGE_INDEX + 1];
+
+    for (int k = 0; k <= COLOR_GARBAGE_INDEX; k++) {
+        palette_color[k] = get_color_palette(game->level, k);
+    }
+
+#if RENDERER_GHOST_PIECE
+    matrix_row_t ghost[MATRIX_DATA_SIZE] = { 0 };
+    matrix_row_t working_ghost = 0;
+    const matrix_row_t *ghost_masks;
+    int ghost_row;
+    color_t ghost_color;
+
+    ghost_color.red = current_piece_color.red >> RENDERER_GHOST_DIM_SHIFT;
+    ghost_color.green = current_piece_color.green >> RENDERER_GHOST_DIM_SHIFT;
+    ghost_color.blue = current_piece_color.blue >> RENDERER_GHOST_DIM_SHIFT;
+
+    // Project the tetrimino to where it would land, only while it is still falling
+    if (game->play_state == PLAY_STATE_NORMAL || game->play_state == PLAY_STATE_HALF_SECOND_B4_LOCK) {
+        ghost_masks = &tetrimino_row_mask[tetrimino->x][tetrimino->shape_offset];
+        ghost_row = tetrimino->y - matrix_drop_distance(matrix, tetrimino) + TETRIMINO_CENTER_Y;
+        for (int i = 0; i < TETRIMINO_BLOCK_SIZE; i++, ghost_row--) {
+            if (ghost_row >= 0 && ghost_row < PLAYING_FIELD_HEIGHT) {
+                ghost[ghost_row] = ghost_masks[i];
+            }
+        }
+    }
+#endif
 
     // Render tetrimino in the playfield attribute
     for (int i = 0; i < MATRIX_DATA_SIZE; i++) {
-        two_rows_bitmap = matrix->playfield[i];
-        two_rows_stack_bitmap = matrix->stack[i];
-        // render even row
-        working_playfield = two_rows_bitmap & PLAYING_FIELD_EVEN_MASK;
-        working_stack = two_rows_stack_bitmap & PLAYING_FIELD_EVEN_MASK;
-        working_palette1 = matrix->palette1[i] & PLAYING_FIELD_EVEN_MASK;
-        working_palette2 = matrix->palette2[i] & PLAYING_FIELD_EVEN_MASK;
-        working_playfield = working_playfield >> 3; // shift to remove boundary
-        working_stack = working_stack >> 3; // shift to remove boundary
-        working_palette1 = working_palette1 >> 3; // shift to remove boundary
-        working_palette2 = working_palette2 >> 3; // shift to remove boundary
+        working_playfield = (matrix->playfield[i] & PLAYING_FIELD_MASK) >> PLAYING_FIELD_BOUNDARY_WIDTH;
+        working_stack = (matrix->stack[i] & PLAYING_FIELD_MASK) >> PLAYING_FIELD_BOUNDARY_WIDTH;
+        for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+            working_palette[plane] = (matrix->palette[plane][i] & PLAYING_FIELD_MASK) >> PLAYING_FIELD_BOUNDARY_WIDTH;
+        }
+#if RENDERER_GHOST_PIECE
+        working_ghost = (ghost[i] & PLAYING_FIELD_MASK) >> PLAYING_FIELD_BOUNDARY_WIDTH;
+#endif
+        y = i + RENDERER_OFFSET_Y;
         for (int j = 0, x = PLAYING_FIELD_WIDTH + RENDERER_OFFSET_X - 1; j < PLAYING_FIELD_WIDTH; j++, x--) {
-            y = (i * 2) + RENDERER_OFFSET_Y;
             led_num = lookup_table[y][x];
 
             // current playing field (current piece)
@@ -164,77 +185,39 @@ renderer_status_t renderer_render(renderer_t *renderer, matrix_t *matrix, tetrim
                 WS2812_set_LED(renderer->led, led_num, current_piece_color.red, current_piece_color.green,
                         current_piece_color.blue); // Set color based on palette lookup table
             } else if (working_stack >> j & 1) {
-                if (working_palette1 >> j & 1) {
-                    WS2812_set_LED(renderer->led, led_num, palette1_color.red, palette1_color.green,
-                            palette1_color.blue);
-                } else if (working_palette2 >> j & 1) {
-                    WS2812_set_LED(renderer->led, led_num, palette2_color.red, palette2_color.green,
-                            palette2_color.blue);
-                } else {
-                    WS2812_set_LED(renderer->led, led_num, palette0_color.red, palette0_color.green,
-                            palette0_color.blue);
-                }
+                // Gather the 3-bit piece index from the palette planes
+                color_index = (working_palette[0] >> j & 1) | (working_palette[1] >> j & 1) << 1
+                        | (working_palette[2] >> j & 1) << 2;
+                WS2812_set_LED(renderer->led, led_num, palette_color[color_index].red,
+                        palette_color[color_index].green, palette_color[color_index].blue);
+#if RENDERER_GHOST_PIECE
+            } else if (working_ghost >> j & 1) {
+                WS2812_set_LED(renderer->led, led_num, ghost_color.red, ghost_color.green, ghost_color.blue);
+#endif
             } else {
                 if (renderer->matrix->tetris_flag && renderer->matrix->flash_flag
-                        && !(renderer->matrix->line_clear_bitmap & (1 << row_index))) {
+                        && !(renderer->matrix->line_clear_bitmap & (1 << i))) {
                     WS2812_set_LED(renderer->led, led_num, 64, 64, 64);
                 } else {
                     WS2812_set_LED(renderer->led, led_num, 0, 0, 0);
                 }
             }
         }
-        row_index++;
-
-        // render odd row
-        working_playfield = two_rows_bitmap & PLAYING_FIELD_ODD_MASK;
-        working_stack = two_rows_stack_bitmap & PLAYING_FIELD_ODD_MASK;
-        working_palette1 = matrix->palette1[i] & PLAYING_FIELD_ODD_MASK;
-        working_palette2 = matrix->palette2[i] & PLAYING_FIELD_ODD_MASK;
-        working_playfield = working_playfield >> 19; // shift to LSB and to remove boundary
-        working_stack = working_stack >> 19; // shift to LSB and to remove boundary
-        working_palette1 = working_palette1 >> 19; // shift to LSB and to remove boundary
-        working_palette2 = working_palette2 >> 19; // shift to LSB and to remove boundary
-        for (int j = 0, x = PLAYING_FIELD_WIDTH + RENDERER_OFFSET_X - 1; j < PLAYING_FIELD_WIDTH; j++, x--) {
-            y = (i * 2) + RENDERER_OFFSET_Y;
-            led_num = lookup_table[y + 1][x];
-            if (working_playfield >> j & 1) {
-                WS2812_set_LED(renderer->led, led_num, current_piece_color.red, current_piece_color.green,
-                        current_piece_color.blue);
-            } else if (working_stack >> j & 1) {
-                if (working_palette1 >> j & 1) {
-                    WS2812_set_LED(renderer->led, led_num, palette1_color.red, palette1_color.green,
-                            palette1_color.blue);
-                } else if (working_palette2 >> j & 1) {
-                    WS2812_set_LED(renderer->led, led_num, palette2_color.red, palette2_color.green,
-                            palette2_color.blue);
-                } else {
-                    WS2812_set_LED(renderer->led, led_num, palette0_color.red, palette0_color.green,
-                            palette0_color.blue);
-                }
-            } else {
-                if (renderer->matrix->tetris_flag && renderer->matrix->flash_flag
-                        && !(renderer->matrix->line_clear_bitmap & (1 << row_index))) {
-                    WS2812_set_LED(renderer->led, led_num, 64, 64, 64);
-                } else {
-                    WS2812_set_LED(renderer->led, led_num, 0, 0, 0);
-                }
-            }
-        }
-        row_index++;
     }
 
+#if RENDERER_SHOW_PREVIEW
     tetrimino_piece_t next_piece = tetrimino->next_piece;
 
     color_t next_color = get_color_palette(game->level, next_piece);
 
     uint8_t shape_offset = tetrimino_shape_offset_lut[next_piece][tetrimino_preview[next_piece]];
     uint8_t bitmap = 0;
-    uint8_t preview_x = 12;
-    uint8_t preview_y = 14;
+    uint8_t preview_x = RENDERER_PREVIEW_X;
+    uint8_t preview_y = RENDERER_PREVIEW_Y;
 
     for (int i = 0; i < TETRIMINO_BLOCK_SIZE; i++) {
         bitmap = tetrimino_shape[shape_offset + i];
-        preview_x = 15;
+        preview_x = RENDERER_PREVIEW_X;
         for (int j = 0; j < TETRIMINO_BLOCK_SIZE - 1; j++) {
             if (bitmap & (1 << (j + 1))) {
                 WS2812_set_LED(renderer->led, lookup_table[preview_y][preview_x], next_color.red,
@@ -247,6 +230,7 @@ renderer_status_t renderer_render(renderer_t *renderer, matrix_t *matrix, tetrim
         preview_y--;
     }
     // Render next tetrimino
+#endif
 
     WS2812_send(renderer->led);
 
@@ -258,11 +242,11 @@ renderer_status_t renderer_render(renderer_t *renderer, matrix_t *matrix, tetrim
         }
     }
 
-    render_end_time = TIM2->CNT;
+    render_end_time = timebase_now32();
     renderer->rendering_time = util_time_diff_us(render_start_time, render_end_time);
     // Update the next update time
-    renderer->time_last_sent = TIM2->CNT;
-    renderer->next_update_time = TIM2->CNT + renderer->delay_length;
+    renderer->time_last_sent = timebase_now();
+    renderer->next_update_time = renderer->time_last_sent + renderer->delay_length;
 
     return RENDERER_UPDATED;
 
@@ -284,45 +268,58 @@ void renderer_clear(renderer_t *renderer) {
 renderer_status_t renderer_top_out_start(renderer_t *renderer) {
     renderer->top_out_flag = 1;
     renderer->top_out_frame = 0;
-    renderer->top_out_timer = TIM2->CNT;
+    timer_wheel_arm(renderer->timer_wheel, &renderer->top_out_timer, timebase_now32(), RENDERER_TOP_OUT_DELAY);
 
     return RENDERER_OK;
 }
 
 /**
- * @brief  Animate top out sequence
- * @param  rendere
+ * @brief  Top out timer expired, fill the next row
+ * @param  renderer
  * @retval None
  */
-renderer_status_t renderer_top_out_animate(renderer_t *renderer) {
-    uint32_t top_out_time = TIM2->CNT;
-    uint32_t top_out_diff = util_time_diff_us(renderer->top_out_timer, top_out_time);
+static void renderer_top_out_step(void *context) {
+    renderer_t *renderer = context;
     uint8_t row = renderer->top_out_frame + 1;
 
+    if (!renderer->top_out_flag || renderer->top_out_frame >= PLAYING_FIELD_HEIGHT) {
+        return;
+    }
+
+    renderer->top_out_frame++;
+    for (int i = 0; i < PLAYING_FIELD_WIDTH; i++) {
+        if (renderer->top_out_frame % 2 == 0) {
+            WS2812_set_LED(renderer->led, lookup_table[row][i + 1], 64, 0, 0);
+        } else {
+            WS2812_set_LED(renderer->led, lookup_table[row][i + 1], 0, 64, 0);
+        }
+    }
+    if (renderer->top_out_frame < PLAYING_FIELD_HEIGHT) {
+        timer_wheel_arm(renderer->timer_wheel, &renderer->top_out_timer, timebase_now32(), RENDERER_TOP_OUT_DELAY);
+    }
+}
+
+/**
+ * @brief  Animate top out sequence, the rows are filled by the top out timer
+ * @param  rendere
+ * @retval None
+ */
+renderer_status_t renderer_top_out_animate(renderer_t *renderer) {
     if (renderer->top_out_frame >= PLAYING_FIELD_HEIGHT) {
         renderer->top_out_flag = 0;
         return RENDERER_ANIMATION_DONE;
     }
 
-    if (top_out_diff >= 100000 && renderer->top_out_flag) {
-        renderer->top_out_frame++;
-        renderer->top_out_timer = TIM2->CNT;
-
-        for (int i = 0; i < PLAYING_FIELD_WIDTH; i++) {
-            if (renderer->top_out_frame % 2 == 0) {
-                WS2812_set_LED(renderer->led, lookup_table[row][i + 1], 64, 0, 0);
-            } else {
-                WS2812_set_LED(renderer->led, lookup_table[row][i + 1], 0, 64, 0);
-            }
-        }
-    }
     WS2812_send(renderer->led);
     return RENDERER_OK;
 }
 
 renderer_status_t renderer_test_render(renderer_t *renderer) {
 
-    if (TIM2->CNT < renderer->next_update_time) {
+    uint64_t now = timebase_now();
+
+    // 64-bit times do not wrap, a plain compare is safe
+    if (now < renderer->next_update_time) {
         return RENDERER_NOT_READY;
     }
 
@@ -335,7 +332,7 @@ renderer_status_t renderer_test_render(renderer_t *renderer) {
         renderer->led_position = 0;
     }
 
-    renderer->next_update_time = TIM2->CNT + renderer->delay_length;
+    renderer->next_update_time = now + renderer->delay_length;
 
     return RENDERER_UPDATED;
 
@@ -0,0 +1,170 @@
+/**
+ ******************************************************************************
+ * @file           : rewind.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Rewind buffer of recent stack snapshots for practice mode
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "rewind.h"
+#include "matrix.h"
+
+/*
+ * One snapshot is taken per locked piece. A snapshot only stores the rows that changed since the
+ * previous one, XOR-ed with their previous contents, so the same delta moves the stack in either
+ * direction. A lock without a line clear changes at most 4 rows. Entries and their delta rows are two
+ * rings, the oldest pieces are dropped when either ring is full.
+ */
+
+/**
+ * @brief  Start an empty rewind buffer at the current stack
+ * @param  rewind object, matrix
+ * @retval REWIND_OK
+ */
+rewind_status_t rewind_init(rewind_t *rewind, matrix_t *matrix) {
+    rewind->entry_head = 0;
+    rewind->entry_count = 0;
+    rewind->row_head = 0;
+    rewind->row_count = 0;
+    memcpy(rewind->stack, matrix->stack, sizeof(rewind->stack));
+    memcpy(rewind->palette, matrix->palette, sizeof(rewind->palette));
+
+    return REWIND_OK;
+}
+
+/**
+ * @brief  Drop the oldest stored piece
+ * @param  rewind object
+ * @retval None
+ */
+static void rewind_drop_oldest(rewind_t *rewind) {
+    uint16_t oldest = (rewind->entry_head + REWIND_MAX_PIECES - rewind->entry_count) % REWIND_MAX_PIECES;
+
+    rewind->row_count -= rewind->entry[oldest].row_count;
+    rewind->entry_count--;
+}
+
+/**
+ * @brief  Take a snapshot after a piece locked and its lines were cleared
+ * @param  rewind object, matrix, piece that locked
+ * @retval REWIND_OK
+ */
+rewind_status_t rewind_push(rewind_t *rewind, matrix_t *matrix, tetrimino_piece_t piece) {
+    rewind_entry_t *entry;
+    rewind_row_t *delta;
+    uint8_t changed = 0;
+    uint32_t changed_rows = 0;
+
+    for (int i = 0; i < MATRIX_DATA_SIZE; i++) {
+        if (matrix->stack[i] != rewind->stack[i]) {
+            changed_rows |= 1UL << i;
+            changed++;
+            continue;
+        }
+        for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+            if (matrix->palette[plane][i] != rewind->palette[plane][i]) {
+                changed_rows |= 1UL << i;
+                changed++;
+                break;
+            }
+        }
+    }
+
+    // Make room in both rings
+    while (rewind->entry_count == REWIND_MAX_PIECES || rewind->row_count + changed > REWIND_MAX_ROWS) {
+        rewind_drop_oldest(rewind);
+    }
+
+    entry = &rewind->entry[rewind->entry_head];
+    entry->first_row = rewind->row_head;
+    entry->row_count = changed;
+    entry->piece = piece;
+
+    while (changed_rows) {
+        int i = __builtin_ctz(changed_rows);
+        changed_rows &= changed_rows - 1;
+
+        delta = &rewind->row[rewind->row_head];
+        delta->row = i;
+        delta->stack = matrix->stack[i] ^ rewind->stack[i];
+        rewind->stack[i] = matrix->stack[i];
+        for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+            delta->palette[plane] = matrix->palette[plane][i] ^ rewind->palette[plane][i];
+            rewind->palette[plane][i] = matrix->palette[plane][i];
+        }
+        rewind->row_head = (rewind->row_head + 1) % REWIND_MAX_ROWS;
+    }
+
+    rewind->row_count += entry->row_count;
+    rewind->entry_head = (rewind->entry_head + 1) % REWIND_MAX_PIECES;
+    rewind->entry_count++;
+
+    return REWIND_OK;
+}
+
+/**
+ * @brief  Step the stack back by a number of locked pieces
+ * @param  rewind object, matrix, number of pieces, piece to play again (the oldest piece undone)
+ * @retval REWIND_OK, REWIND_EMPTY if fewer pieces are stored
+ *
+ * Only the deltas of the undone pieces are applied, then the stack is copied over whatever happened
+ * since the last snapshot. The surface and hash are rebuilt, the playfield is not touched.
+ */
+rewind_status_t rewind_restore(rewind_t *rewind, matrix_t *matrix, uint8_t pieces, tetrimino_piece_t *piece) {
+    rewind_entry_t *entry = NULL;
+    rewind_row_t *delta;
+    uint16_t index;
+
+    if (pieces == 0 || pieces > rewind->entry_count) {
+        return REWIND_EMPTY;
+    }
+
+    for (int n = 0; n < pieces; n++) {
+        rewind->entry_head = (rewind->entry_head + REWIND_MAX_PIECES - 1) % REWIND_MAX_PIECES;
+        entry = &rewind->entry[rewind->entry_head];
+        index = entry->first_row;
+        for (int i = 0; i < entry->row_count; i++) {
+            delta = &rewind->row[index];
+            rewind->stack[delta->row] ^= delta->stack;
+            for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+                rewind->palette[plane][delta->row] ^= delta->palette[plane];
+            }
+            index = (index + 1) % REWIND_MAX_ROWS;
+        }
+        rewind->row_head = entry->first_row;
+        rewind->row_count -= entry->row_count;
+        rewind->entry_count--;
+    }
+    *piece = entry->piece;
+
+    memcpy(matrix->stack, rewind->stack, sizeof(rewind->stack));
+    memcpy(matrix->palette, rewind->palette, sizeof(rewind->palette));
+    matrix_surface_recompute(matrix);
+    matrix_hash_recompute(matrix);
+
+    return REWIND_OK;
+}
+
+/**
+ * @brief  Get the number of pieces that can be stepped back
+ * @param  rewind object
+ * @retval Number of stored pieces
+ */
+uint16_t rewind_count(rewind_t *rewind) {
+    return rewind->entry_count;
+}
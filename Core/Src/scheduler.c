@@ -0,0 +1,272 @@
+/**
+ ******************************************************************************
+ * @file           : scheduler.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Cooperative task scheduler with per-task timing statistics
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "scheduler.h"
+
+/*
+ * Tasks run to completion, a task that takes too long delays the ones after it but is never
+ * preempted. Each task is released on a fixed grid of its period starting at its phase, so the
+ * release times do not drift with the run times. The scheduler reads time only through the clock
+ * given to scheduler_init and does not touch any peripheral, so it runs on a host with a fake clock.
+ *
+ * Between dispatches the caller can sleep until the next release (or an earlier deadline of its own)
+ * with scheduler_idle. The time slept and the time between sleeps are counted, their ratio is the
+ * duty cycle reported by scheduler_load and scheduler_debug_print. Interrupt handlers that run during
+ * a sleep (the 1 kHz HAL tick wakes the core every millisecond) are busy time, the sleep function
+ * measures them. A handler that runs in the few instructions between two sleeps still counts as idle.
+ */
+
+/**
+ * @brief  Check if a time has been reached, the signed difference is correct across a counter wrap
+ * @param  time to check, current time (microseconds)
+ * @retval 1 if reached, 0 if not
+ */
+static uint8_t scheduler_reached(uint32_t time, uint32_t now) {
+    return (int32_t) (now - time) >= 0;
+}
+
+/**
+ * @brief  Bind a task table to the scheduler and release every task at its phase
+ * @param  scheduler, task table (sorted by priority in place), number of tasks, microsecond clock
+ * @retval SCHEDULER_OK, SCHEDULER_ERROR if a task has no run function or there is no clock
+ */
+scheduler_status_t scheduler_init(scheduler_t *scheduler, scheduler_task_t *tasks, uint8_t task_count,
+        scheduler_clock_t clock) {
+    scheduler_task_t task;
+    uint32_t now;
+    int16_t j;
+
+    if (clock == NULL) {
+        return SCHEDULER_ERROR;
+    }
+    for (uint8_t i = 0; i < task_count; i++) {
+        if (tasks[i].run == NULL) {
+            return SCHEDULER_ERROR;
+        }
+    }
+
+    // Insertion sort, stable so tasks of the same priority keep their table order
+    for (uint8_t i = 1; i < task_count; i++) {
+        task = tasks[i];
+        for (j = i - 1; j >= 0 && tasks[j].priority > task.priority; j--) {
+            tasks[j + 1] = tasks[j];
+        }
+        tasks[j + 1] = task;
+    }
+
+    scheduler->tasks = tasks;
+    scheduler->task_count = task_count;
+    scheduler->clock = clock;
+
+    now = clock();
+    for (uint8_t i = 0; i < task_count; i++) {
+        tasks[i].release_time = now + tasks[i].phase;
+    }
+    scheduler_reset_stats(scheduler);
+
+    return SCHEDULER_OK;
+}
+
+/**
+ * @brief  Run every task that is due once, in priority order
+ * @param  scheduler
+ * @retval Number of tasks run
+ */
+uint8_t scheduler_dispatch(scheduler_t *scheduler) {
+    scheduler_task_t *task;
+    uint32_t start;
+    uint32_t end;
+    uint32_t run_time;
+    uint32_t deadline;
+    uint32_t skipped;
+    uint8_t run_count = 0;
+
+    for (uint8_t i = 0; i < scheduler->task_count; i++) {
+        task = &scheduler->tasks[i];
+
+        // The clock is read again for every task, the ones before may have taken a while
+        start = scheduler->clock();
+        if (!scheduler_reached(task->release_time, start)) {
+            continue;
+        }
+
+        task->run(task->context);
+
+        end = scheduler->clock();
+        run_time = end - start;
+        task->stats.runs++;
+        task->stats.run_time_total += run_time;
+        if (run_time > task->stats.run_time_worst) {
+            task->stats.run_time_worst = run_time;
+        }
+
+        deadline = task->deadline ? task->deadline : task->period;
+        if (deadline && end - task->release_time > deadline) {
+            task->stats.deadline_misses++;
+        }
+
+        if (task->period == 0) {
+            task->release_time = end;
+        } else {
+            task->release_time += task->period;
+            if (scheduler_reached(task->release_time, end)) {
+                // A whole period behind, drop the releases that passed instead of running back to back
+                skipped = (end - task->release_time) / task->period + 1;
+                task->release_time += skipped * task->period;
+                task->stats.releases_skipped += skipped;
+            }
+        }
+        run_count++;
+    }
+
+    return run_count;
+}
+
+/**
+ * @brief  Time the first task is released next
+ * @param  scheduler, time in microseconds (output), in the past if a task is already due
+ * @retval SCHEDULER_OK, SCHEDULER_ERROR if there are no tasks
+ */
+scheduler_status_t scheduler_next_release(scheduler_t *scheduler, uint32_t *time) {
+    uint32_t now;
+    uint32_t next;
+
+    if (scheduler->task_count == 0) {
+        return SCHEDULER_ERROR;
+    }
+
+    // Compared as distances from now so the order is right across a counter wrap
+    now = scheduler->clock();
+    next = scheduler->tasks[0].release_time;
+    for (uint8_t i = 1; i < scheduler->task_count; i++) {
+        if ((int32_t) (scheduler->tasks[i].release_time - now) < (int32_t) (next - now)) {
+            next = scheduler->tasks[i].release_time;
+        }
+    }
+    *time = next;
+
+    return SCHEDULER_OK;
+}
+
+/**
+ * @brief  Sleep until a wake time, waking early for an interrupt goes back to sleep
+ * @param  scheduler, wake time in microseconds (returns at once if reached), sleep function
+ * @retval None
+ */
+void scheduler_idle(scheduler_t *scheduler, uint32_t wake_time, scheduler_sleep_t sleep) {
+    scheduler_load_t *load = &scheduler->load;
+    uint32_t start;
+    uint32_t now;
+    uint32_t busy;
+    uint32_t handler_time = 0;
+
+    start = scheduler->clock();
+    for (now = start; !scheduler_reached(wake_time, now); now = scheduler->clock()) {
+        handler_time += sleep(wake_time);
+    }
+    if (handler_time > now - start) {
+        handler_time = now - start;
+    }
+
+    busy = start - load->wake_time + handler_time;
+    load->busy_time += busy;
+    load->window_busy_time += busy;
+    load->idle_time += now - start - handler_time;
+    load->window_idle_time += now - start - handler_time;
+    load->wake_time = now;
+}
+
+/**
+ * @brief  Duty cycle since the previous call, the time not spent in scheduler_idle
+ * @param  scheduler
+ * @retval Busy time in tenths of a percent (0 to 1000)
+ */
+uint16_t scheduler_load(scheduler_t *scheduler) {
+    scheduler_load_t *load = &scheduler->load;
+    uint64_t total;
+    uint32_t now;
+    uint16_t busy;
+
+    // Time since the last sleep is busy so far, counted now so the next window does not get it
+    now = scheduler->clock();
+    load->busy_time += now - load->wake_time;
+    load->window_busy_time += now - load->wake_time;
+    load->wake_time = now;
+    total = load->window_busy_time + load->window_idle_time;
+    busy = total ? (uint16_t) (load->window_busy_time * 1000 / total) : 0;
+    load->window_busy_time = 0;
+    load->window_idle_time = 0;
+
+    return busy;
+}
+
+/**
+ * @brief  Average run time of a task
+ * @param  task
+ * @retval Average run time in microseconds, 0 if it never ran
+ */
+uint32_t scheduler_task_average(scheduler_task_t *task) {
+    if (task->stats.runs == 0) {
+        return 0;
+    }
+    return (uint32_t) (task->stats.run_time_total / task->stats.runs);
+}
+
+/**
+ * @brief  Clear the statistics of every task and the duty cycle, the release times are kept
+ * @param  scheduler
+ * @retval None
+ */
+void scheduler_reset_stats(scheduler_t *scheduler) {
+    for (uint8_t i = 0; i < scheduler->task_count; i++) {
+        memset(&scheduler->tasks[i].stats, 0, sizeof(scheduler_task_stats_t));
+    }
+    memset(&scheduler->load, 0, sizeof(scheduler_load_t));
+    scheduler->load.wake_time = scheduler->clock();
+}
+
+/**
+ * @brief  Print the statistics of every task
+ * @param  scheduler
+ * @retval None
+ */
+void scheduler_debug_print(scheduler_t *scheduler) {
+    scheduler_task_t *task;
+    uint64_t total;
+    uint32_t busy;
+
+    printf("===================\n");
+    printf("Task      Period  Runs      Avg us  Worst us  Missed  Skipped\n");
+    for (uint8_t i = 0; i < scheduler->task_count; i++) {
+        task = &scheduler->tasks[i];
+        printf("%-8s  %6lu  %8lu  %6lu  %8lu  %6lu  %7lu\n", task->name, (unsigned long) task->period,
+                (unsigned long) task->stats.runs, (unsigned long) scheduler_task_average(task),
+                (unsigned long) task->stats.run_time_worst, (unsigned long) task->stats.deadline_misses,
+                (unsigned long) task->stats.releases_skipped);
+    }
+    total = scheduler->load.busy_time + scheduler->load.idle_time;
+    busy = total ? (uint32_t) (scheduler->load.busy_time * 1000 / total) : 0;
+    printf("Busy %lu.%lu%% of %lu ms\n", (unsigned long) (busy / 10), (unsigned long) (busy % 10),
+            (unsigned long) (total / 1000));
+}
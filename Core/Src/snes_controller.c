@@ -25,6 +25,7 @@
 
 #include "snes_controller.h"
 #include "util.h"
+#include "timebase.h"
 #include "main.h"
 #include "itm_debug.h"
 
@@ -47,7 +48,7 @@ snes_controller_status_t snes_controller_init(snes_controller_t *controller, GPI
     controller->previous_buttons_state = 0xFFFF;
     controller->read_rate = read_rate;
     controller->delay_length = 1000000 / read_rate;  // frequency to period in microseconds
-    controller->time_last_read = TIM2->CNT;
+    controller->time_last_read = timebase_now();
     controller->time_expire = controller->time_last_read + controller->delay_length;
     controller->led_state = 0;
 
@@ -65,9 +66,9 @@ snes_controller_das_status_t snes_controller_delayed_auto_shift_init(snes_contro
     memset(repeater, 0, sizeof(snes_controller_das_t));
     repeater->repeat_status = SNES_CONTROLLER_DAS_INACTIVE;
     repeater->target_button = target_button;
-    repeater->repeat_rate = 1000000 / SNES_DAS_DELAY; // 10Hz default repeat rate (Classic NES Tetris);
-    repeater->repeat_start_delay = 266228; // 266.228ms (16 frames at 60Hz)
-    repeater->repeat_delay = SNES_DAS_DELAY; // 10 Hz
+    repeater->repeat_rate = 60 / SNES_DAS_REPEAT_FRAMES; // 10Hz default repeat rate (Classic NES Tetris);
+    repeater->repeat_start_delay = SNES_DAS_START_FRAMES; // 266.228ms (16 frames at 60Hz)
+    repeater->repeat_delay = SNES_DAS_REPEAT_FRAMES; // 10 Hz
 
     return SNES_CONTROLLER_OK;
 }
@@ -100,21 +101,31 @@ snes_controller_status_t snes_controller_clock(snes_controller_t *controller, GP
 }
 
 /**
- * @brief  Read the SNES controller
+ * @brief  Read the SNES controller at its read rate
  * @param  snes_controller_t *controller
  * @retval status of the SNES controller
  */
 snes_controller_status_t snes_controller_read(snes_controller_t *controller) {
 
     // Read rate throttling, if the timer expires, it is ready to read the controller
-    if (!util_time_expired(controller->time_last_read, controller->time_expire)) {
+    if (timebase_now() < controller->time_expire) {
         return SNES_CONTROLLER_NOT_READY;
     }
 
+    return snes_controller_poll(controller);
+}
+
+/**
+ * @brief  Read the SNES controller now, for callers that pace the reads themselves
+ * @param  snes_controller_t *controller
+ * @retval status of the SNES controller
+ */
+snes_controller_status_t snes_controller_poll(snes_controller_t *controller) {
+
     snes_controller_latch(controller);
     controller->buttons_state = 0x0000;
 
-    controller->time_last_read = TIM2->CNT;
+    controller->time_last_read = timebase_now();
     controller->time_expire = controller->time_last_read + controller->delay_length;
     for (int i = 0; i < 16; i++) {
         snes_controller_clock(controller, GPIO_PIN_RESET);
@@ -140,23 +151,25 @@ snes_controller_status_t snes_controller_read(snes_controller_t *controller) {
 
 /**
  * @brief  Check the repeat status of the SNES controller
- * @param  snes_controller_repeat_t *repeater, snes_controller_t *controller
+ * @param  snes_controller_repeat_t *repeater, snes_controller_t *controller, game frames elapsed since the
+ *         previous call
  * @retval None
  */
-void snes_controller_delayed_auto_shift(snes_controller_das_t *repeater, snes_controller_t *controller) {
+void snes_controller_delayed_auto_shift(snes_controller_das_t *repeater, snes_controller_t *controller,
+        uint8_t frames) {
     repeater->buttons_state = controller->buttons_state;
 
     if (repeater->repeat_status == SNES_CONTROLLER_DAS_INACTIVE) {
         if (controller->buttons_state & repeater->target_button
                 && !(repeater->previous_buttons_state & repeater->target_button)) {
             repeater->repeat_status = SNES_CONTROLLER_DAS_START;
-            repeater->repeat_start_time = TIM2->CNT;
+            repeater->repeat_frame_count = 0;
         }
     } else if (repeater->repeat_status == SNES_CONTROLLER_DAS_START) {
-        if (util_time_expired_delay(repeater->repeat_start_time, repeater->repeat_start_delay)) {
+        repeater->repeat_frame_count += frames;
+        if (repeater->repeat_frame_count >= repeater->repeat_start_delay) {
             repeater->repeat_status = SNES_CONTROLLER_DAS_ACTIVE_IDLE;
-            repeater->repeat_start_time = TIM2->CNT;
-
+            repeater->repeat_frame_count = 0;
         }
     } else if (repeater->repeat_status == SNES_CONTROLLER_DAS_ACTIVE_IDLE) {
         // Check if the button is still pressed
@@ -164,7 +177,8 @@ void snes_controller_delayed_auto_shift(snes_controller_das_t *repeater, snes_co
             repeater->repeat_status = SNES_CONTROLLER_DAS_INACTIVE;
         } else {
             // Check if the repeat delay has expired
-            if (util_time_expired_delay(repeater->repeat_start_time, repeater->repeat_delay)) {
+            repeater->repeat_frame_count += frames;
+            if (repeater->repeat_frame_count >= repeater->repeat_delay) {
                 repeater->repeat_status = SNES_CONTROLLER_DAS_ACTIVE_ENQUEUE;
             }
         }
@@ -174,7 +188,7 @@ void snes_controller_delayed_auto_shift(snes_controller_das_t *repeater, snes_co
             repeater->repeat_status = SNES_CONTROLLER_DAS_INACTIVE;
         } else {
             repeater->repeat_status = SNES_CONTROLLER_DAS_ACTIVE_IDLE;
-            repeater->repeat_start_time = TIM2->CNT;
+            repeater->repeat_frame_count = 0;
         }
     } else {
         // This should never happen
@@ -58,6 +58,7 @@
 extern I2C_HandleTypeDef hi2c2;
 extern DMA_HandleTypeDef hdma_tim3_ch1_trig;
 extern DMA_HandleTypeDef hdma_tim3_ch3;
+extern TIM_HandleTypeDef htim2;
 extern TIM_HandleTypeDef htim13;
 extern UART_HandleTypeDef huart2;
 extern TIM_HandleTypeDef htim4;
@@ -232,6 +233,24 @@ void EXTI9_5_IRQHandler(void)
   /* USER CODE END EXTI9_5_IRQn 1 */
 }
 
+/**
+  * @brief This function handles TIM2 global interrupt.
+  */
+void TIM2_IRQHandler(void)
+{
+  /* USER CODE BEGIN TIM2_IRQn 0 */
+  // The channel 1 compare only wakes game_loop_sleep, cleared here so the HAL does not pass it to the
+  // output compare and PWM callbacks
+  if (__HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_CC1) && __HAL_TIM_GET_IT_SOURCE(&htim2, TIM_IT_CC1)) {
+    __HAL_TIM_CLEAR_IT(&htim2, TIM_IT_CC1);
+  }
+  /* USER CODE END TIM2_IRQn 0 */
+  HAL_TIM_IRQHandler(&htim2);
+  /* USER CODE BEGIN TIM2_IRQn 1 */
+
+  /* USER CODE END TIM2_IRQn 1 */
+}
+
 /**
   * @brief This function handles TIM4 global interrupt.
   */
@@ -30,30 +30,29 @@
 /*
  * Dropping tetriminos speed
  * The speed is based on the level of the game. The speed is determined by the
- * number of microseconds to wait before dropping the tetrimino by one row.
+ * number of frames to wait before dropping the tetrimino by one row.
  *
- * NES runs at 60.0988 frames per second. the period between drops and the speed
- * is computed. https://meatfighter.com/nintendotetrisai/
+ * NES runs at 60.0988 frames per second, the frame counts are the ones of NES Tetris.
+ * https://meatfighter.com/nintendotetrisai/
  */
 
 // @formatter:off
-uint32_t tetrimino_drop_period[] = {
-        799000, // 0.799 seconds (Level 0)
-        715000, // 0.715 seconds (Level 1)
-        632000, // 0.632 seconds (Level 2)
-        549000, // .549 seconds (Level 3)
-        466000, // .466 seconds (Level 4)
-        383000, // .383 seconds (Level 5)
-        300000, // .300 seconds (Level 6)
-        216000, // .216 seconds (Level 7)
-        133000, // .133 seconds (Level 8)
-        100000, // .100 seconds (Level 9)
-        83000,  // .083 seconds (Level 10-12)
-        67000,  // .067 seconds (Level 13-15)
-        50000,  // .050 seconds (Level 16-18)
-        33000,  // .033 seconds (Level 19-28)
-        17000,  // .017 seconds (Level 29-31)
-        10000   // .010 seconds (Level 32+)
+uint8_t tetrimino_drop_period[] = {
+        48, // 0.799 seconds (Level 0)
+        43, // 0.715 seconds (Level 1)
+        38, // 0.632 seconds (Level 2)
+        33, // .549 seconds (Level 3)
+        28, // .466 seconds (Level 4)
+        23, // .383 seconds (Level 5)
+        18, // .300 seconds (Level 6)
+        13, // .216 seconds (Level 7)
+        8,  // .133 seconds (Level 8)
+        6,  // .100 seconds (Level 9)
+        5,  // .083 seconds (Level 10-12)
+        4,  // .067 seconds (Level 13-15)
+        3,  // .050 seconds (Level 16-18)
+        2,  // .033 seconds (Level 19-28)
+        1   // .017 seconds (Level 29+)
 };
 // @formatter:on
 /**
@@ -64,7 +63,7 @@ uint32_t tetrimino_drop_period[] = {
 tetrimino_status_t tetrimino_init(tetrimino_t *tetrimino) {
     memset(tetrimino, 0, sizeof(tetrimino_t));
     rng_init(0);
-    tetrimino->x = 5;
+    tetrimino->x = PLAYING_FIELD_WIDTH / 2;
     tetrimino->y = PLAYING_FIELD_HEIGHT;
     tetrimino->piece = rng_next() % TETRIMINO_COUNT;
     tetrimino->rotation = tetrimino_spawn[tetrimino->piece];
@@ -115,23 +114,39 @@ tetrimino_status_t tetrimino_rotate(tetrimino_t *tetrimino, rotation_direction_t
  * @retval status
  */
 tetrimino_status_t tetrimino_next(tetrimino_t *tetrimino) {
-    tetrimino->x = 5;
-    tetrimino->y = PLAYING_FIELD_HEIGHT - 1;
-    tetrimino->piece = tetrimino->next_piece;
-    tetrimino->rotation = tetrimino_spawn[tetrimino->piece];
-    tetrimino->shape_offset = tetrimino_shape_offset_lut[tetrimino->piece][tetrimino->rotation];
+    tetrimino_spawn_piece(tetrimino, tetrimino->next_piece);
 //    tetrimino->piece = rng_next() % TETRIMINO_COUNT;
     tetrimino->next_piece = rng_next() % TETRIMINO_COUNT;
 
     return TETRIMINO_OK;
 }
 
+/**
+ * @brief  Put a piece at the spawn position without drawing a next piece
+ * @param  tetrimino object, piece
+ * @retval status
+ */
+tetrimino_status_t tetrimino_spawn_piece(tetrimino_t *tetrimino, tetrimino_piece_t piece) {
+    tetrimino->x = PLAYING_FIELD_WIDTH / 2;
+    tetrimino->y = PLAYING_FIELD_HEIGHT - 1;
+    tetrimino->piece = piece;
+    tetrimino->rotation = tetrimino_spawn[piece];
+    tetrimino->shape_offset = tetrimino_shape_offset_lut[piece][tetrimino->rotation];
+
+    return TETRIMINO_OK;
+}
+
 tetrimino_status_t tetrimino_copy(tetrimino_t *dst, tetrimino_t *src) {
     memcpy(dst, src, sizeof(tetrimino_t));
     return TETRIMINO_OK;
 }
 
-uint32_t tetrimino_drop_speed(uint8_t level) {
+/**
+ * @brief  Get the gravity of a level
+ * @param  level
+ * @retval Frames per row
+ */
+uint8_t tetrimino_drop_frames(uint8_t level) {
     if (level < 10) {
         return tetrimino_drop_period[level];
     } else if (level < 13) {
@@ -142,10 +157,8 @@ uint32_t tetrimino_drop_speed(uint8_t level) {
         return tetrimino_drop_period[12];
     } else if (level < 29) {
         return tetrimino_drop_period[13];
-    } else if (level < 39) {
-        return tetrimino_drop_period[14];
     } else {
-        return tetrimino_drop_period[15];
+        return tetrimino_drop_period[14];
     }
 }
 
@@ -20,6 +20,7 @@
  */
 
 #include "tetrimino_shape.h"
+#include "matrix.h"
 
 // @formatter:off
 
@@ -37,26 +38,91 @@
  *
  */
 
+#define TETRIMINO_SHAPES(ROWS, x) \
+    ROWS(x, 0x00, 0x04, 0x0e, 0x00, 0x00) /* T - up [offset 0]                  */ \
+    ROWS(x, 0x00, 0x04, 0x06, 0x04, 0x00) /* T - right [offset 5]               */ \
+    ROWS(x, 0x00, 0x00, 0x0e, 0x04, 0x00) /* T - down (spawn) [offset 10]       */ \
+    ROWS(x, 0x00, 0x04, 0x0c, 0x04, 0x00) /* T - left [offset 15]               */ \
+    ROWS(x, 0x00, 0x08, 0x0e, 0x00, 0x00) /* J - up [offset 20]                 */ \
+    ROWS(x, 0x00, 0x06, 0x04, 0x04, 0x00) /* J - right [offset 25]              */ \
+    ROWS(x, 0x00, 0x00, 0x0e, 0x02, 0x00) /* J - down (spawn) [offset 30]       */ \
+    ROWS(x, 0x00, 0x04, 0x04, 0x0c, 0x00) /* J - left [offset 35]               */ \
+    ROWS(x, 0x00, 0x00, 0x0c, 0x06, 0x00) /* Z - horizontal (spawn) [offset 40] */ \
+    ROWS(x, 0x00, 0x02, 0x06, 0x04, 0x00) /* Z - vertical [offset 45]           */ \
+    ROWS(x, 0x00, 0x00, 0x0c, 0x0c, 0x00) /* O - spawn [offset 50]              */ \
+    ROWS(x, 0x00, 0x00, 0x06, 0x0c, 0x00) /* S - horizontal (spawn) [offset 55] */ \
+    ROWS(x, 0x00, 0x04, 0x06, 0x02, 0x00) /* S - vertical [offset 60]           */ \
+    ROWS(x, 0x00, 0x02, 0x0e, 0x00, 0x00) /* L - up [offset 65]                 */ \
+    ROWS(x, 0x00, 0x04, 0x04, 0x06, 0x00) /* L - right [offset 70]              */ \
+    ROWS(x, 0x00, 0x00, 0x0e, 0x08, 0x00) /* L - down (spawn) [offset 75]       */ \
+    ROWS(x, 0x00, 0x0c, 0x04, 0x04, 0x00) /* L - left [offset 80]               */ \
+    ROWS(x, 0x04, 0x04, 0x04, 0x04, 0x00) /* I - vertical [offset 85]           */ \
+    ROWS(x, 0x00, 0x00, 0x1e, 0x00, 0x00) /* I - horizontal (spawn) [offset 90] */
+
+#define TETRIMINO_SHAPE_ROWS(x, r0, r1, r2, r3, r4) r0, r1, r2, r3, r4,
+
 const uint8_t tetrimino_shape[] = {
-    0x00, 0x04, 0x0e, 0x00, 0x00, // T - up [offset 0]
-    0x00, 0x04, 0x06, 0x04, 0x00, // T - right [offset 5]
-    0x00, 0x00, 0x0e, 0x04, 0x00, // T - down (spawn) [offset 10]
-    0x00, 0x04, 0x0c, 0x04, 0x00, // T - left [offset 15]
-    0x00, 0x08, 0x0e, 0x00, 0x00, // J - up [offset 20]
-    0x00, 0x06, 0x04, 0x04, 0x00, // J - right [offset 25]
-    0x00, 0x00, 0x0e, 0x02, 0x00, // J - down (spawn) [offset 30]
-    0x00, 0x04, 0x04, 0x0c, 0x00, // J - left [offset 35]
-    0x00, 0x00, 0x0c, 0x06, 0x00, // Z - horizontal (spawn) [offset 40]
-    0x00, 0x02, 0x06, 0x04, 0x00, // Z - vertical [offset 45]
-    0x00, 0x00, 0x0c, 0x0c, 0x00, // O - spawn [offset 50]
-    0x00, 0x00, 0x06, 0x0c, 0x00, // S - horizontal (spawn) [offset 55]
-    0x00, 0x04, 0x06, 0x02, 0x00, // S - vertical [offset 60]
-    0x00, 0x02, 0x0e, 0x00, 0x00, // L - up [offset 65]
-    0x00, 0x04, 0x04, 0x06, 0x00, // L - right [offset 70]
-    0x00, 0x00, 0x0e, 0x08, 0x00, // L - down (spawn) [offset 75]
-    0x00, 0x0c, 0x04, 0x04, 0x00, // L - left [offset 80]
-    0x04, 0x04, 0x04, 0x04, 0x00, // I - vertical [offset 85]
-    0x00, 0x00, 0x1e, 0x00, 0x00, // I - horizontal (spawn) [offset 90]
+    TETRIMINO_SHAPES(TETRIMINO_SHAPE_ROWS, 0)
+};
+
+_Static_assert(sizeof(tetrimino_shape) == TETRIMINO_SHAPE_COUNT * TETRIMINO_BLOCK_SIZE,
+        "TETRIMINO_SHAPE_COUNT does not match the tetrimino_shape table");
+
+/**
+ * Pre-shifted tetrimino row masks for every column
+ *
+ * tetrimino_row_mask[x] is the tetrimino_shape table with every row already shifted into its
+ * matrix row position (boundary included) for a tetrimino centered on column x, so a row is
+ * placed or collision checked with a single load and AND/OR. Indexing matches tetrimino_shape,
+ * i.e. &tetrimino_row_mask[x][shape_offset] points to the five rows of the shape.
+ *
+ * The table is expanded from the same TETRIMINO_SHAPES list at compile time, so it cannot go out
+ * of sync with the shapes. One line per playfield column, up to the widest board the LED panel
+ * can show; the array size is checked against PLAYING_FIELD_WIDTH by the extern declaration.
+ */
+
+#define TETRIMINO_ROW_SHIFT(x) (PLAYING_FIELD_BOUNDARY_WIDTH + PLAYING_FIELD_WIDTH - TETRIMINO_CENTER_X - 1 - (x))
+#define TETRIMINO_ROW_MASK(r, x) (matrix_row_t) ((matrix_row_t) (r) << TETRIMINO_ROW_SHIFT(x))
+#define TETRIMINO_MASK_ROWS(x, r0, r1, r2, r3, r4) \
+    TETRIMINO_ROW_MASK(r0, x), TETRIMINO_ROW_MASK(r1, x), TETRIMINO_ROW_MASK(r2, x), \
+    TETRIMINO_ROW_MASK(r3, x), TETRIMINO_ROW_MASK(r4, x),
+#define TETRIMINO_MASK_COLUMN(x) { TETRIMINO_SHAPES(TETRIMINO_MASK_ROWS, x) },
+
+const matrix_row_t tetrimino_row_mask[][TETRIMINO_SHAPE_COUNT * TETRIMINO_BLOCK_SIZE] = {
+    TETRIMINO_MASK_COLUMN(0)
+    TETRIMINO_MASK_COLUMN(1)
+    TETRIMINO_MASK_COLUMN(2)
+    TETRIMINO_MASK_COLUMN(3)
+#if PLAYING_FIELD_WIDTH > 4
+    TETRIMINO_MASK_COLUMN(4)
+#endif
+#if PLAYING_FIELD_WIDTH > 5
+    TETRIMINO_MASK_COLUMN(5)
+#endif
+#if PLAYING_FIELD_WIDTH > 6
+    TETRIMINO_MASK_COLUMN(6)
+#endif
+#if PLAYING_FIELD_WIDTH > 7
+    TETRIMINO_MASK_COLUMN(7)
+#endif
+#if PLAYING_FIELD_WIDTH > 8
+    TETRIMINO_MASK_COLUMN(8)
+#endif
+#if PLAYING_FIELD_WIDTH > 9
+    TETRIMINO_MASK_COLUMN(9)
+#endif
+#if PLAYING_FIELD_WIDTH > 10
+    TETRIMINO_MASK_COLUMN(10)
+#endif
+#if PLAYING_FIELD_WIDTH > 11
+    TETRIMINO_MASK_COLUMN(11)
+#endif
+#if PLAYING_FIELD_WIDTH > 12
+    TETRIMINO_MASK_COLUMN(12)
+#endif
+#if PLAYING_FIELD_WIDTH > 13
+    TETRIMINO_MASK_COLUMN(13)
+#endif
 };
 
 /**
@@ -79,6 +145,47 @@ const uint8_t tetrimino_shape_offset_lut[TETRIMINO_COUNT][TETRIMINO_ROTATION_COU
    { 85, 90, 85, 90}    // I
 };
 
+/**
+ * SRS wall kick lookup table for each tetrimino piece (T, J, Z, O, S, L, I).
+ *
+ * Indexed by piece, the rotation position before the rotation and the rotation direction (CCW, CW).
+ * The kicks are tried in order and the first offset where the rotated tetrimino fits is used.
+ * J, L, S, T and Z share one set of kicks, I has its own and O never kicks.
+ *
+ */
+
+#define SRS_KICKS_JLSTZ \
+    { { { 0, 0 }, {  1, 0 }, {  1,  1 }, { 0, -2 }, {  1, -2 } },    /* up -> left,    up -> right */ \
+      { { 0, 0 }, { -1, 0 }, { -1,  1 }, { 0, -2 }, { -1, -2 } } }, \
+    { { { 0, 0 }, {  1, 0 }, {  1, -1 }, { 0,  2 }, {  1,  2 } },    /* right -> up,   right -> down */ \
+      { { 0, 0 }, {  1, 0 }, {  1, -1 }, { 0,  2 }, {  1,  2 } } }, \
+    { { { 0, 0 }, { -1, 0 }, { -1,  1 }, { 0, -2 }, { -1, -2 } },    /* down -> right, down -> left */ \
+      { { 0, 0 }, {  1, 0 }, {  1,  1 }, { 0, -2 }, {  1, -2 } } }, \
+    { { { 0, 0 }, { -1, 0 }, { -1, -1 }, { 0,  2 }, { -1,  2 } },    /* left -> down,  left -> up */ \
+      { { 0, 0 }, { -1, 0 }, { -1, -1 }, { 0,  2 }, { -1,  2 } } }
+
+#define SRS_KICKS_I \
+    { { { 0, 0 }, { -1, 0 }, {  2, 0 }, { -1,  2 }, {  2, -1 } },    /* up -> left,    up -> right */ \
+      { { 0, 0 }, { -2, 0 }, {  1, 0 }, { -2, -1 }, {  1,  2 } } }, \
+    { { { 0, 0 }, {  2, 0 }, { -1, 0 }, {  2,  1 }, { -1, -2 } },    /* right -> up,   right -> down */ \
+      { { 0, 0 }, { -1, 0 }, {  2, 0 }, { -1,  2 }, {  2, -1 } } }, \
+    { { { 0, 0 }, {  1, 0 }, { -2, 0 }, {  1, -2 }, { -2,  1 } },    /* down -> right, down -> left */ \
+      { { 0, 0 }, {  2, 0 }, { -1, 0 }, {  2,  1 }, { -1, -2 } } }, \
+    { { { 0, 0 }, { -2, 0 }, {  1, 0 }, { -2, -1 }, {  1,  2 } },    /* left -> down,  left -> up */ \
+      { { 0, 0 }, {  1, 0 }, { -2, 0 }, {  1, -2 }, { -2,  1 } } }
+
+#define SRS_KICKS_O { { { 0, 0 } } }, { { { 0, 0 } } }, { { { 0, 0 } } }, { { { 0, 0 } } }
+
+const tetrimino_kick_t tetrimino_srs_kick[TETRIMINO_COUNT][TETRIMINO_ROTATION_COUNT][ROTATE_DIRECTION_COUNT][TETRIMINO_KICK_COUNT] = {
+    { SRS_KICKS_JLSTZ },    // T
+    { SRS_KICKS_JLSTZ },    // J
+    { SRS_KICKS_JLSTZ },    // Z
+    { SRS_KICKS_O },        // O
+    { SRS_KICKS_JLSTZ },    // S
+    { SRS_KICKS_JLSTZ },    // L
+    { SRS_KICKS_I }         // I
+};
+
 /**
  * Tetrimino spawn rotation position lookup table for each tetrimino piece (T, J, Z, O, S, L, I).
  *
@@ -0,0 +1,507 @@
+/**
+ ******************************************************************************
+ * @file           : tetris_engine.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Gameplay engine for Classic Tetris on LED Grid, free of HAL and peripheral calls
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "tetris_engine.h"
+#include "snes_buttons.h"
+#include "matrix.h"
+#include "tetrimino.h"
+#include "tetrimino_shape.h"
+#include "tetris.h"
+#include "itm_debug.h"
+#include "rng.h"
+#include "rewind.h"
+
+/*
+ * The engine is the GAME_IN_PROGRESS part of the game loop. It only sees the controller readings and
+ * the number of frames that passed, and reports what happened as events, so the renderer, OLED and
+ * statistics stay with the caller and the same gameplay code can run on a host.
+ *
+ * Gravity, lock delay and the line clear animation are frame counters like on the NES. The caller
+ * checks the microsecond clock once per loop with tetris_engine_frame_ticks and passes the frames on.
+ *
+ * Input is taken once per frame. tetris_engine_input_drain empties the controller queue at the start of
+ * the frame and merges the readings in order into held, pressed and released masks, so a reading never
+ * waits for the next frame behind another one and a quick tap is not lost. START in the input only sets
+ * TETRIS_ENGINE_EVENT_PAUSE, the frames and the moves of the same step still apply so a pause loses none.
+ */
+
+/**
+ * @brief  Count the whole frames passed since the last tick, the frame phase is kept
+ * @param  time of the last tick (updated), current time in microseconds
+ * @retval Frames passed, at most TETRIS_ENGINE_MAX_FRAME_TICKS
+ */
+uint8_t tetris_engine_frame_ticks(uint32_t *frame_time, uint32_t now) {
+    uint32_t elapsed = now - *frame_time; // unsigned difference, correct across a counter wrap
+    uint32_t frames;
+
+    if (elapsed < TETRIS_ENGINE_FRAME_PERIOD) {
+        return 0;
+    }
+
+    frames = elapsed / TETRIS_ENGINE_FRAME_PERIOD;
+    if (frames > TETRIS_ENGINE_MAX_FRAME_TICKS) {
+        // Stalled (e.g. halted in the debugger), do not fast forward the game
+        *frame_time = now;
+        return TETRIS_ENGINE_MAX_FRAME_TICKS;
+    }
+    *frame_time += frames * TETRIS_ENGINE_FRAME_PERIOD;
+
+    return frames;
+}
+
+/**
+ * @brief  Set the drop speeds of the current level
+ * @param  game state
+ * @retval None
+ */
+static void tetris_engine_set_gravity(game_t *game) {
+    game->drop_frames_normal = tetrimino_drop_frames(game->level);
+    game->drop_frames_soft_drop = game->drop_frames_normal < TETRIS_ENGINE_SOFT_DROP_FRAMES ?
+            game->drop_frames_normal : TETRIS_ENGINE_SOFT_DROP_FRAMES;
+}
+
+/**
+ * @brief  Attach the engine to the game state, matrix and tetrimino it plays on
+ * @param  engine, game state, matrix object, tetrimino
+ * @retval TETRIS_ENGINE_OK, TETRIS_ENGINE_ERROR if an object is missing
+ */
+tetris_engine_status_t tetris_engine_init(tetris_engine_t *engine, game_t *game, matrix_t *matrix,
+        tetrimino_t *tetrimino) {
+    if (engine == NULL || game == NULL || matrix == NULL || tetrimino == NULL) {
+        return TETRIS_ENGINE_ERROR;
+    }
+
+    memset(engine, 0, sizeof(tetris_engine_t));
+    engine->game = game;
+    engine->matrix = matrix;
+    engine->tetrimino = tetrimino;
+
+    return TETRIS_ENGINE_OK;
+}
+
+/**
+ * @brief  Start the input of a game, nothing pressed or released
+ * @param  input, buttons held at the start (a held button is not a press)
+ * @retval None
+ */
+void tetris_engine_input_reset(tetris_engine_input_t *input, uint16_t held) {
+    input->held = held;
+    input->pressed = 0;
+    input->released = 0;
+    input->shift = 0;
+}
+
+/**
+ * @brief  Merge every queued reading into the input of this frame, the held buttons carry over
+ * @param  input, controller queue (tetris_engine_reading_t), current time in microseconds, latency
+ *         statistics (NULL to skip)
+ * @retval Number of entries drained
+ */
+uint8_t tetris_engine_input_drain(tetris_engine_input_t *input, RingBuffer *queue, uint32_t now,
+        tetris_engine_input_stats_t *stats) {
+    tetris_engine_reading_t reading;
+    uint16_t down;
+    uint32_t latency;
+    uint8_t count = 0;
+    uint8_t readings = 0;
+
+    input->pressed = 0;
+    input->released = 0;
+    input->shift = 0;
+
+    while (ring_buffer_dequeue(queue, &reading)) {
+        count++;
+        if (reading.repeat) {
+            down = reading.buttons; // repeated as if pressed again
+        } else {
+            down = reading.buttons & ~input->held;
+            input->released |= input->held & ~reading.buttons;
+            input->held = reading.buttons;
+            readings++;
+            if (stats != NULL) {
+                latency = now - reading.time;
+                stats->readings++;
+                stats->latency_total += latency;
+                if (latency > stats->latency_worst) {
+                    stats->latency_worst = latency;
+                }
+                if (latency > TETRIS_ENGINE_FRAME_PERIOD) {
+                    stats->late++;
+                }
+                if (readings > 1) {
+                    stats->coalesced++;
+                }
+            }
+        }
+        input->pressed |= down;
+        if (down & SNES_BUTTON_LEFT && input->shift > INT8_MIN) {
+            input->shift--;
+        }
+        if (down & SNES_BUTTON_RIGHT && input->shift < INT8_MAX) {
+            input->shift++;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief  Start a new game at the level already selected in the game state
+ * @param  engine
+ * @retval TETRIS_ENGINE_OK
+ */
+tetris_engine_status_t tetris_engine_start(tetris_engine_t *engine) {
+    game_t *game = engine->game;
+
+    matrix_clear(engine->matrix);
+#if PRACTICE_REWIND
+    rewind_init(&engine->rewind, engine->matrix);
+#endif
+    game->score = 0;
+    game->lines = 0;
+    game->lines_to_next_level = 10 * (game->level + 1);
+    tetris_engine_set_gravity(game);
+    game->drop_frames = game->drop_frames_normal;
+    game->drop_frame_count = 0;
+    game->lock_frame_count = 0;
+    game->frame_count = 0;
+    game->play_state = PLAY_STATE_NORMAL;
+
+    memset(&game->stats, 0, sizeof(game_stats_t));
+
+    // Reinitialize tetrimino piece
+    tetrimino_init(engine->tetrimino);
+
+    engine->lines_to_be_cleared = 0;
+    engine->lines_cleared_count = 0;
+
+    return TETRIS_ENGINE_OK;
+}
+
+/**
+ * @brief  Advance the game by one pass of the game loop
+ * @param  engine, controller input, frames passed since the previous step (usually 0 or 1)
+ * @retval tetris_engine_event_t bits of what happened during the step
+ */
+uint16_t tetris_engine_step(tetris_engine_t *engine, tetris_engine_input_t *input, uint8_t frames) {
+    game_t *game = engine->game;
+    matrix_t *matrix = engine->matrix;
+    tetrimino_t *tetrimino = engine->tetrimino;
+    matrix_status_t matrix_status;
+    tetrimino_status_t tetrimino_status;
+    uint16_t pressed = input->pressed & ~SNES_BUTTON_START; // START pauses, it is not a move
+    int8_t shift;
+    uint16_t events = TETRIS_ENGINE_EVENT_NONE;
+#if TEST_TETRIMINO_CHANGE
+    tetrimino_t temp_tetrimino;
+#endif
+#if PRACTICE_REWIND
+    tetrimino_piece_t rewind_piece;
+#endif
+#if DEBUG_OUTPUT
+    char stack_text[MATRIX_TEXT_MAX_SIZE];
+#endif
+
+    game->frame_count += frames;
+    game->drop_frame_count += frames;
+    game->lock_frame_count += frames;
+
+    if (input->pressed & SNES_BUTTON_START) {
+        events |= TETRIS_ENGINE_EVENT_PAUSE;
+    }
+
+    if (pressed || input->released || input->shift) {
+        tetrimino_status = TETRIMINO_OK;
+#if YX_ROTATE_TETRIMINO
+        if (pressed & (SNES_BUTTON_A | SNES_BUTTON_X)) {
+#else
+        if (pressed & SNES_BUTTON_A) {
+#endif
+            matrix_rotate_tetrimino(matrix, tetrimino, ROTATE_CW, game->rotation_system);
+#if YX_ROTATE_TETRIMINO
+        } else if (pressed & (SNES_BUTTON_B | SNES_BUTTON_Y)) {
+#else
+        } else if (pressed & SNES_BUTTON_B) {
+#endif
+            matrix_rotate_tetrimino(matrix, tetrimino, ROTATE_CCW, game->rotation_system);
+        }
+
+#if TEST_TETRIMINO_CHANGE
+        else if (pressed & (SNES_BUTTON_R | SNES_BUTTON_L)) {
+            tetrimino_copy(&temp_tetrimino, tetrimino);
+            if (pressed & SNES_BUTTON_R) {
+                temp_tetrimino.piece++;
+                if (temp_tetrimino.piece >= TETRIMINO_COUNT) {
+                    temp_tetrimino.piece = 0;
+                }
+            } else {
+                temp_tetrimino.piece--;
+                if (temp_tetrimino.piece >= TETRIMINO_COUNT) {
+                    temp_tetrimino.piece = TETRIMINO_COUNT - 1;
+                }
+            }
+            if (matrix_piece_fits(matrix, temp_tetrimino.piece, temp_tetrimino.rotation, temp_tetrimino.x,
+                    temp_tetrimino.y) == MATRIX_OK) {
+                temp_tetrimino.shape_offset = tetrimino_shape_offset_lut[temp_tetrimino.piece][temp_tetrimino.rotation];
+                tetrimino_copy(tetrimino, &temp_tetrimino);
+                tetrimino_status = TETRIMINO_REFRESH;
+            }
+        }
+#endif
+        // Handle down button press only if in normal play state
+        if (game->play_state == PLAY_STATE_NORMAL) {
+            // If down button was previously pressed and is now released
+            if (input->released & SNES_BUTTON_DOWN && !(input->held & SNES_BUTTON_DOWN)) {
+                game->drop_frames = game->drop_frames_normal;
+                game->soft_drop_flag = 0;
+                game->soft_drop_lines = 0;
+                tetrimino_status = TETRIMINO_REFRESH;
+            } else if (input->held & SNES_BUTTON_DOWN) {
+                game->drop_frames = game->drop_frames_soft_drop;
+                game->soft_drop_flag = 1;
+                tetrimino_status = TETRIMINO_REFRESH;
+            }
+        }
+
+        // One column per press or repeat, a blocked shift ends the move
+        for (shift = input->shift; shift < 0; shift++) {
+            if (matrix_move_tetrimino(matrix, tetrimino, MOVE_LEFT) == MATRIX_NO_CHANGE) {
+                break;
+            }
+        }
+        for (shift = input->shift; shift > 0; shift--) {
+            if (matrix_move_tetrimino(matrix, tetrimino, MOVE_RIGHT) == MATRIX_NO_CHANGE) {
+                break;
+            }
+        }
+#if TEST_TETRIMINO_CHANGE && !YX_ROTATE_TETRIMINO
+        if (pressed & SNES_BUTTON_Y) {
+            game->level++;
+        } else if (pressed & SNES_BUTTON_X) {
+            if (game->level > 0) {
+                game->level--;
+            }
+
+#if DEBUG_OUTPUT
+            printf("Level: %ld\n", game->level);
+#endif
+        }
+#endif
+#if PRACTICE_REWIND
+        // Undo the last locked piece, it is played again and the current piece comes next
+        if (pressed & SNES_BUTTON_L
+                && (game->play_state == PLAY_STATE_NORMAL || game->play_state == PLAY_STATE_HALF_SECOND_B4_LOCK)
+                && rewind_restore(&engine->rewind, matrix, 1, &rewind_piece) == REWIND_OK) {
+            tetrimino->next_piece = tetrimino->piece;
+            tetrimino_spawn_piece(tetrimino, rewind_piece);
+            game->play_state = PLAY_STATE_NORMAL;
+            game->drop_frame_count = 0;
+            tetrimino_status = TETRIMINO_REFRESH;
+            events |= TETRIS_ENGINE_EVENT_REWIND;
+        }
+#endif
+#if TEST_GARBAGE_RISE
+        if (pressed & SNES_BUTTON_SELECT
+                && (game->play_state == PLAY_STATE_NORMAL || game->play_state == PLAY_STATE_HALF_SECOND_B4_LOCK)) {
+            matrix_status = matrix_add_garbage(matrix, tetrimino, 1, rng_next() % PLAYING_FIELD_WIDTH);
+            if (matrix_status == MATRIX_OUT_OF_BOUNDS || matrix_status == MATRIX_STACK_COLLISION) {
+                game->play_state = PLAY_STATE_TOP_OUT;
+            }
+        }
+#endif
+#if HARD_DROP_ON_UP
+        // Hard drop after any shift or rotation from the same event, then lock right away
+        if (pressed & SNES_BUTTON_UP
+                && (game->play_state == PLAY_STATE_NORMAL || game->play_state == PLAY_STATE_HALF_SECOND_B4_LOCK)) {
+            tetrimino->y -= matrix_drop_distance(matrix, tetrimino);
+            tetrimino_status = TETRIMINO_REFRESH;
+            game->play_state = PLAY_STATE_LOCKED;
+        }
+#endif
+        // Rebuild the playfield only if a rotation or piece change was accepted
+        if (tetrimino_status == TETRIMINO_REFRESH) {
+            matrix_add_tetrimino(matrix, tetrimino);
+        }
+    }
+
+    if (game->play_state == PLAY_STATE_NORMAL) {
+        // Check if tetrimino is clear to continue dropping down during half-second before lock period
+        if (game->drop_frame_count >= game->drop_frames) {
+            if (tetrimino->y > 0) {
+                matrix_status = matrix_piece_fits(matrix, tetrimino->piece, tetrimino->rotation, tetrimino->x,
+                        tetrimino->y - 1);
+            } else {
+                matrix_status = MATRIX_REACHED_BOTTOM;
+            }
+
+            if (matrix_status == MATRIX_REACHED_BOTTOM) {
+                game->play_state = PLAY_STATE_HALF_SECOND_B4_LOCK;
+                game->lock_frame_count = 0;
+            } else if (matrix_status == MATRIX_OK || matrix_status == MATRIX_STACK_COLLISION) {
+                if (matrix_status == MATRIX_OK) {
+                    tetrimino->y--;
+                    matrix_add_tetrimino(matrix, tetrimino);
+                } else {
+                    // Landed on the stack, tetrimino stays in place
+                    game->play_state = PLAY_STATE_HALF_SECOND_B4_LOCK;
+                    game->lock_frame_count = 0;
+                }
+                // Edge case handling: Long bar reached to bottom of matrix, transition to lock state
+                if (tetrimino->y == 0) {
+                    game->play_state = PLAY_STATE_HALF_SECOND_B4_LOCK;
+                    game->lock_frame_count = 0;
+                }
+                game->drop_frame_count = 0;
+                if (game->soft_drop_flag) {
+                    game->soft_drop_lines++;
+                }
+            }
+        }
+    } else if (game->play_state == PLAY_STATE_HALF_SECOND_B4_LOCK) {
+        // Check if tetrimino still can fall down unobstructed, if so, revert to normal play state
+        if (tetrimino->y > 1
+                && matrix_piece_fits(matrix, tetrimino->piece, tetrimino->rotation, tetrimino->x, tetrimino->y - 1)
+                        == MATRIX_OK) {
+            // No collision detected, revert to normal play state
+            game->play_state = PLAY_STATE_NORMAL;
+            game->drop_frame_count = 0;
+        } else if (game->lock_frame_count >= game->lock_frames) {
+            game->play_state = PLAY_STATE_LOCKED;
+        }
+    }
+
+    if (game->play_state == PLAY_STATE_LOCKED) {
+        // Merge playfield with stack & palette
+        merge_with_stack(matrix, tetrimino);
+        matrix_reset_playfield(matrix);
+        events |= TETRIS_ENGINE_EVENT_LOCK;
+        // Check for line clear
+        engine->lines_to_be_cleared = matrix_check_tetrimino_line_clear(matrix, tetrimino,
+                &engine->lines_cleared_count);
+#if DEBUG_OUTPUT
+        if (engine->lines_to_be_cleared) {
+            printf("Lines to be cleared: ");
+            for (int i = 0; i < PLAYING_FIELD_HEIGHT; i++) {
+                if (engine->lines_to_be_cleared & (1 << i)) {
+                    printf("%d ", i);
+                }
+            }
+            printf("\n");
+            matrix_serialize_text(matrix, stack_text, sizeof(stack_text));
+            printf("stack: \"%s\"\n", stack_text);
+        }
+#endif
+        if (engine->lines_to_be_cleared) {
+            game->play_state = PLAY_STATE_LINE_CLEAR;
+            matrix->line_clear_bitmap = engine->lines_to_be_cleared;
+            matrix_line_clear_start(matrix, CLEAR_LINE_DELAY_FRAMES);
+            if (engine->lines_cleared_count == 4) {
+                matrix->tetris_flag = 1;
+            }
+            events |= TETRIS_ENGINE_EVENT_LINE_CLEAR_START;
+        } else {
+            if (game->soft_drop_flag) {
+                game->score += game->soft_drop_lines;
+                game->soft_drop_lines = 0;
+                game->soft_drop_flag = 0;
+                game->drop_frames = game->drop_frames_normal;
+            }
+            game->play_state = PLAY_STATE_NEXT_TETRIMINO;
+        }
+    }
+
+    if (game->play_state == PLAY_STATE_LINE_CLEAR) {
+        // The frames of this step passed before the lines were found
+        if (matrix_line_clear_animate(matrix, engine->lines_to_be_cleared,
+                (events & TETRIS_ENGINE_EVENT_LINE_CLEAR_START) ? 0 : frames)) { // Is line clear complete?
+            if (game->soft_drop_flag) {
+                game->score += game->soft_drop_lines;
+                game->soft_drop_lines = 0;
+            }
+            // Update the score based on the number of lines cleared and game level
+            game->score += tetris_calculate_score(engine->lines_cleared_count, game->level);
+
+            // Update game statistics
+            if (engine->lines_cleared_count == 1) {
+                game->stats.singles++;
+            } else if (engine->lines_cleared_count == 2) {
+                game->stats.doubles++;
+            } else if (engine->lines_cleared_count == 3) {
+                game->stats.triples++;
+            } else if (engine->lines_cleared_count == 4) {
+                game->stats.tetrises++;
+            }
+
+            // Reposition blocks after clearing lines
+            matrix_reposition_blocks(matrix, engine->lines_to_be_cleared);
+            game->play_state = PLAY_STATE_NEXT_TETRIMINO;  // Move to next tetrimino
+            game->drop_frame_count = 0;
+            game->lines += engine->lines_cleared_count;
+            engine->lines_to_be_cleared = 0;
+            engine->lines_cleared_count = 0;
+            matrix->tetris_flag = 0;
+            game->soft_drop_flag = 0;
+            game->drop_frames = game->drop_frames_normal;
+            events |= TETRIS_ENGINE_EVENT_LINE_CLEAR;
+            if (game->lines >= game->lines_to_next_level) {
+                game->play_state = PLAY_STATE_TRANSITION_LEVEL;
+            }
+        }
+    }
+
+    // Transition to the next level if line clear count is met
+    if (game->play_state == PLAY_STATE_TRANSITION_LEVEL) {
+        game->level++;
+        game->lines_to_next_level = 10 * (game->level + 1);
+        tetris_engine_set_gravity(game);
+        game->drop_frames = game->drop_frames_normal;
+        game->play_state = PLAY_STATE_NEXT_TETRIMINO;
+        game->drop_frame_count = 0;
+        events |= TETRIS_ENGINE_EVENT_LEVEL_UP;
+    }
+
+    if (game->play_state == PLAY_STATE_NEXT_TETRIMINO) {
+#if PRACTICE_REWIND
+        rewind_push(&engine->rewind, matrix, tetrimino->piece);
+#endif
+        tetrimino_status = tetrimino_next(tetrimino);
+        if (tetrimino_status == TETRIMINO_OK) {
+            matrix_status = matrix_piece_fits(matrix, tetrimino->piece, tetrimino->rotation, tetrimino->x,
+                    tetrimino->y);
+            if (matrix_status != MATRIX_OK) { // Topped out
+                game->play_state = PLAY_STATE_TOP_OUT;
+            } else {
+                matrix_add_tetrimino(matrix, tetrimino);
+                game->play_state = PLAY_STATE_NORMAL;
+                game->drop_frame_count = 0;
+            }
+            events |= TETRIS_ENGINE_EVENT_SPAWN;
+        }
+    }
+
+    if (game->play_state == PLAY_STATE_TOP_OUT) {
+        events |= TETRIS_ENGINE_EVENT_TOP_OUT;
+    }
+
+    return events;
+}
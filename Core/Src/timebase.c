@@ -0,0 +1,99 @@
+/**
+ ******************************************************************************
+ * @file           : timebase.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : 64-bit microsecond timebase extended from a wrapping 32-bit counter
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+
+#include <stdint.h>
+#include <stddef.h>
+#include "timebase.h"
+
+/*
+ * TIM2 counts microseconds in 32 bits and wraps every 71.6 minutes. The overflow interrupt counts the
+ * wraps, so the count of wraps and the counter together give a 64-bit time that does not wrap while
+ * the board is on. Times from timebase_now can be compared and subtracted directly. The 32-bit view
+ * from timebase_now32 is for modules that use signed differences (scheduler, timer wheel) and is the
+ * same as reading the counter.
+ *
+ * The counter is read through the clock given to timebase_init and nothing here touches a peripheral,
+ * so a host can drive the counter and the overflow to test hours of wraps in a few seconds.
+ */
+
+static const timebase_clock_t *timebase_clock;
+static volatile uint32_t timebase_wraps; // counter wraps handled by timebase_overflow
+
+/**
+ * @brief  Set the counter the timebase is extended from, the count of wraps starts at 0
+ * @param  clock
+ * @retval None
+ */
+void timebase_init(const timebase_clock_t *clock) {
+    timebase_clock = clock;
+    timebase_wraps = 0;
+}
+
+/**
+ * @brief  Count a wrap of the counter, called from the overflow interrupt
+ * @param  None
+ * @retval None
+ */
+void timebase_overflow(void) {
+    timebase_wraps++;
+}
+
+/**
+ * @brief  Read the 64-bit time
+ * @param  None
+ * @retval Time in microseconds, the count plus 2^32 per wrap since timebase_init
+ */
+uint64_t timebase_now(void) {
+    uint32_t wraps;
+    uint32_t count;
+    uint8_t pending;
+
+    if (timebase_clock == NULL) {
+        return 0;
+    }
+
+    // Read again if the overflow interrupt ran in between
+    do {
+        wraps = timebase_wraps;
+        count = timebase_clock->counter();
+        pending = timebase_clock->overflow_pending();
+    } while (wraps != timebase_wraps);
+
+    // Wrapped but the interrupt has not run yet (interrupts masked), a small count is after the wrap
+    if (pending && count < 0x80000000UL) {
+        wraps++;
+    }
+
+    return ((uint64_t) wraps << 32) | count;
+}
+
+/**
+ * @brief  Read the low 32 bits of the time
+ * @param  None
+ * @retval Time in microseconds, wraps every 71.6 minutes
+ */
+uint32_t timebase_now32(void) {
+    if (timebase_clock == NULL) {
+        return 0;
+    }
+    return timebase_clock->counter();
+}
@@ -0,0 +1,288 @@
+/**
+ ******************************************************************************
+ * @file           : timer_wheel.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Hashed timer wheel for one-shot deadlines with callbacks
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "timer_wheel.h"
+
+/*
+ * Time is cut into ticks of 2^TIMER_WHEEL_TICK_SHIFT microseconds and a timer hangs in the slot of the
+ * tick it expires in, modulo the number of slots. Every slot is a doubly linked list of timers the
+ * callers own, so arming and cancelling are O(1) and nothing is allocated. A timer more than one turn
+ * away stays in its slot until its expiry is reached. A tick is walked once it has fully passed, so a
+ * timer never fires early.
+ *
+ * The wheel keeps the end of the first tick that has a timer, so the caller can skip the walk with one
+ * comparison. Expired timers are taken off the wheel first and their callbacks run afterwards, a
+ * callback can arm or cancel any timer, including the one that fired.
+ */
+
+#define TIMER_WHEEL_TICK_MASK (0xFFFFFFFF >> TIMER_WHEEL_TICK_SHIFT)
+
+/**
+ * @brief  Check if a time has been reached, the signed difference is correct across a counter wrap
+ * @param  time to check, current time (microseconds)
+ * @retval 1 if reached, 0 if not
+ */
+static uint8_t timer_wheel_reached(uint32_t time, uint32_t now) {
+    return (int32_t) (now - time) >= 0;
+}
+
+/**
+ * @brief  Tick of a time
+ * @param  time in microseconds
+ * @retval Tick number
+ */
+static uint32_t timer_wheel_tick(uint32_t time) {
+    return time >> TIMER_WHEEL_TICK_SHIFT;
+}
+
+/**
+ * @brief  Add a timer at the head of a list
+ * @param  list head, timer
+ * @retval None
+ */
+static void timer_wheel_link(timer_wheel_timer_t **head, timer_wheel_timer_t *timer) {
+    timer->prev = NULL;
+    timer->next = *head;
+    if (*head != NULL) {
+        (*head)->prev = timer;
+    }
+    *head = timer;
+}
+
+/**
+ * @brief  Remove a timer from a list
+ * @param  list head, timer
+ * @retval None
+ */
+static void timer_wheel_unlink(timer_wheel_timer_t **head, timer_wheel_timer_t *timer) {
+    if (timer->prev != NULL) {
+        timer->prev->next = timer->next;
+    } else {
+        *head = timer->next;
+    }
+    if (timer->next != NULL) {
+        timer->next->prev = timer->prev;
+    }
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+/**
+ * @brief  Ticks from the last walked tick until a slot is walked
+ * @param  wheel, slot
+ * @retval 1 to TIMER_WHEEL_SLOTS
+ */
+static uint32_t timer_wheel_slot_distance(timer_wheel_t *wheel, uint16_t slot) {
+    return ((slot - wheel->tick - 1) & TIMER_WHEEL_SLOT_MASK) + 1;
+}
+
+/**
+ * @brief  Find the end of the first tick after the last walked one that has a timer
+ * @param  wheel
+ * @retval None
+ */
+static void timer_wheel_update_next_expiry(timer_wheel_t *wheel) {
+    uint16_t slot;
+
+    for (uint32_t distance = 1; distance <= TIMER_WHEEL_SLOTS; distance++) {
+        slot = (wheel->tick + distance) & TIMER_WHEEL_SLOT_MASK;
+        if ((slot & 31) == 0 && wheel->occupied[slot >> 5] == 0 && distance + 31 <= TIMER_WHEEL_SLOTS) {
+            distance += 31; // skip an empty word of 32 slots
+            continue;
+        }
+        if (wheel->occupied[slot >> 5] & (1UL << (slot & 31))) {
+            wheel->next_expiry = (wheel->tick + distance + 1) << TIMER_WHEEL_TICK_SHIFT;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief  Initialize an empty timer wheel
+ * @param  wheel, current time in microseconds
+ * @retval TIMER_WHEEL_OK
+ */
+timer_wheel_status_t timer_wheel_init(timer_wheel_t *wheel, uint32_t now) {
+    memset(wheel, 0, sizeof(timer_wheel_t));
+    wheel->tick = (timer_wheel_tick(now) - 1) & TIMER_WHEEL_TICK_MASK;
+    wheel->next_expiry = now;
+
+    return TIMER_WHEEL_OK;
+}
+
+/**
+ * @brief  Initialize an idle timer
+ * @param  timer, function called when it expires, context passed to the function
+ * @retval None
+ */
+void timer_wheel_timer_init(timer_wheel_timer_t *timer, timer_wheel_callback_t callback, void *context) {
+    memset(timer, 0, sizeof(timer_wheel_timer_t));
+    timer->state = TIMER_WHEEL_TIMER_IDLE;
+    timer->callback = callback;
+    timer->context = context;
+}
+
+/**
+ * @brief  Arm a timer, a timer that is already armed is moved to the new expiry
+ * @param  wheel, timer, current time and delay in microseconds (delay below 2^31)
+ * @retval TIMER_WHEEL_OK, TIMER_WHEEL_ERROR if the delay is too long
+ */
+timer_wheel_status_t timer_wheel_arm(timer_wheel_t *wheel, timer_wheel_timer_t *timer, uint32_t now,
+        uint32_t delay) {
+    uint32_t tick;
+    uint32_t next_expiry;
+
+    if (delay > INT32_MAX) {
+        return TIMER_WHEEL_ERROR;
+    }
+    timer_wheel_cancel(wheel, timer);
+
+    if (wheel->count == 0) {
+        // Nothing was walked while the wheel was empty, catch up
+        wheel->tick = (timer_wheel_tick(now) - 1) & TIMER_WHEEL_TICK_MASK;
+    }
+
+    timer->expiry = now + delay;
+    tick = timer_wheel_tick(timer->expiry);
+    if (((tick - wheel->tick) & TIMER_WHEEL_TICK_MASK) > (TIMER_WHEEL_TICK_MASK >> 1)
+            || tick == wheel->tick) {
+        tick = wheel->tick + 1; // tick already walked, the next walk fires it
+    }
+    timer->slot = tick & TIMER_WHEEL_SLOT_MASK;
+    timer->state = TIMER_WHEEL_TIMER_ARMED;
+    timer_wheel_link(&wheel->slot[timer->slot], timer);
+    wheel->occupied[timer->slot >> 5] |= 1UL << (timer->slot & 31);
+    wheel->count++;
+
+    next_expiry = (wheel->tick + timer_wheel_slot_distance(wheel, timer->slot) + 1) << TIMER_WHEEL_TICK_SHIFT;
+    if (wheel->count == 1 || timer_wheel_reached(next_expiry, wheel->next_expiry)) {
+        wheel->next_expiry = next_expiry;
+    }
+
+    return TIMER_WHEEL_OK;
+}
+
+/**
+ * @brief  Cancel a timer, cancelling an idle timer does nothing
+ * @param  wheel, timer
+ * @retval TIMER_WHEEL_OK
+ */
+timer_wheel_status_t timer_wheel_cancel(timer_wheel_t *wheel, timer_wheel_timer_t *timer) {
+    if (timer->state == TIMER_WHEEL_TIMER_ARMED) {
+        timer_wheel_unlink(&wheel->slot[timer->slot], timer);
+        if (wheel->slot[timer->slot] == NULL) {
+            wheel->occupied[timer->slot >> 5] &= ~(1UL << (timer->slot & 31));
+        }
+        wheel->count--;
+    } else if (timer->state == TIMER_WHEEL_TIMER_EXPIRED) {
+        timer_wheel_unlink(&wheel->expired, timer);
+    }
+    timer->state = TIMER_WHEEL_TIMER_IDLE;
+
+    return TIMER_WHEEL_OK;
+}
+
+/**
+ * @brief  Check if a timer is waiting to fire
+ * @param  timer
+ * @retval 1 if armed, 0 if idle
+ */
+uint8_t timer_wheel_armed(timer_wheel_timer_t *timer) {
+    return timer->state != TIMER_WHEEL_TIMER_IDLE;
+}
+
+/**
+ * @brief  Time the next timer can fire, it may be earlier than the expiry of any timer
+ * @param  wheel, time in microseconds (output)
+ * @retval TIMER_WHEEL_OK, TIMER_WHEEL_EMPTY if no timer is armed
+ */
+timer_wheel_status_t timer_wheel_next_expiry(timer_wheel_t *wheel, uint32_t *time) {
+    if (wheel->count == 0) {
+        return TIMER_WHEEL_EMPTY;
+    }
+    *time = wheel->next_expiry;
+
+    return TIMER_WHEEL_OK;
+}
+
+/**
+ * @brief  Walk the ticks that passed and run the callbacks of the expired timers
+ * @param  wheel, current time in microseconds
+ * @retval Number of callbacks run
+ */
+uint16_t timer_wheel_advance(timer_wheel_t *wheel, uint32_t now) {
+    timer_wheel_timer_t *timer;
+    timer_wheel_timer_t *next;
+    uint32_t last_tick;
+    uint32_t ticks;
+    uint16_t slot;
+    uint16_t fired = 0;
+
+    // Nothing to do until the first tick with a timer has passed
+    if (wheel->count == 0 || !timer_wheel_reached(wheel->next_expiry, now)) {
+        return 0;
+    }
+
+    last_tick = (timer_wheel_tick(now) - 1) & TIMER_WHEEL_TICK_MASK;
+    ticks = (last_tick - wheel->tick) & TIMER_WHEEL_TICK_MASK;
+    if (ticks > TIMER_WHEEL_SLOTS) {
+        // More than a turn behind, every slot is walked once
+        wheel->tick = (last_tick - TIMER_WHEEL_SLOTS) & TIMER_WHEEL_TICK_MASK;
+        ticks = TIMER_WHEEL_SLOTS;
+    }
+
+    while (ticks--) {
+        wheel->tick = (wheel->tick + 1) & TIMER_WHEEL_TICK_MASK;
+        slot = wheel->tick & TIMER_WHEEL_SLOT_MASK;
+        if (!(wheel->occupied[slot >> 5] & (1UL << (slot & 31)))) {
+            continue;
+        }
+        for (timer = wheel->slot[slot]; timer != NULL; timer = next) {
+            next = timer->next;
+            if (timer_wheel_reached(timer->expiry, now)) {
+                timer_wheel_unlink(&wheel->slot[slot], timer);
+                timer_wheel_link(&wheel->expired, timer);
+                timer->state = TIMER_WHEEL_TIMER_EXPIRED;
+                wheel->count--;
+            }
+        }
+        if (wheel->slot[slot] == NULL) {
+            wheel->occupied[slot >> 5] &= ~(1UL << (slot & 31));
+        }
+    }
+
+    // Callbacks run off the wheel, they may arm or cancel timers
+    while (wheel->expired != NULL) {
+        timer = wheel->expired;
+        timer_wheel_unlink(&wheel->expired, timer);
+        timer->state = TIMER_WHEEL_TIMER_IDLE;
+        if (timer->callback != NULL) {
+            timer->callback(timer->context);
+        }
+        fired++;
+    }
+
+    timer_wheel_update_next_expiry(wheel);
+
+    return fired;
+}
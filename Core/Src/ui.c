@@ -30,6 +30,7 @@
 #include "ui.h"
 #include "splash_bitmap.h"
 #include "util.h"
+#include "timebase.h"
 #include "tetris.h"
 #include "eeprom.h"
 
@@ -56,23 +57,38 @@ uint8_t menu_list_size[] = {
 };
 
 uint8_t select_arrow_locations[3] = { 14, 30, 46 };
+
+// Timer wheel the statistics frames are timed on, set by ui_init
+static timer_wheel_t *ui_timer_wheel;
 //@formatter:on
 
 ui_stats_t ui_stats;
 ui_stats_t ui_high_score;
 
+/**
+ * @brief  Statistics frame timer expired, the next update draws the next frame
+ * @param  ui_stats_t of the animation
+ * @retval None
+ */
+static void ui_animate_expired(void *context) {
+    ((ui_stats_t*) context)->animate_due = 1;
+}
+
 /**
  * @brief  Initialize OLED display
- * @param  None
+ * @param  statistics to display, timer wheel for the frame timers
  * @retval None
  */
-void ui_init(tetris_statistics_t *stats) {
+void ui_init(tetris_statistics_t *stats, timer_wheel_t *timer_wheel) {
     ssd1306_Init();
+    ui_timer_wheel = timer_wheel;
     memset(&ui_stats, 0, sizeof(ui_stats_t));
     ui_stats.stats = stats;
+    timer_wheel_timer_init(&ui_stats.animate_timer, ui_animate_expired, &ui_stats);
 
     // High score
     memset(&ui_high_score, 0, sizeof(ui_stats_t));
+    timer_wheel_timer_init(&ui_high_score.animate_timer, ui_animate_expired, &ui_high_score);
 }
 
 /**
@@ -81,12 +97,12 @@ void ui_init(tetris_statistics_t *stats) {
  * @retval None
  */
 void ui_reset_ui_stats() {
-    ui_stats.animate_start_time = TIM2->CNT - UI_STATS_DELAY;  // Expires immediately;
-    ui_stats.animate_delay = UI_STATS_DELAY;
+    timer_wheel_cancel(ui_timer_wheel, &ui_stats.animate_timer);
+    ui_stats.animate_due = 1; // Expires immediately
     ui_stats.animate_frame = 0;
 
-    ui_high_score.animate_start_time = TIM2->CNT - UI_STATS_DELAY;  // Expires immediately
-    ui_high_score.animate_delay = UI_STATS_DELAY;
+    timer_wheel_cancel(ui_timer_wheel, &ui_high_score.animate_timer);
+    ui_high_score.animate_due = 1; // Expires immediately
     ui_high_score.animate_frame = 0;
 }
 
@@ -100,7 +116,6 @@ void ui_menu_init(ui_menu_t *menu) {
     menu->ui_status = UI_MENU_DRAW;
     menu->ui_menu_list_size = 0;
     menu->offset_num = 0;
-    menu->cursor_start_time = 0;
 }
 
 void ui_menu_id_set(ui_menu_t *menu, int menuID) {
@@ -375,9 +390,9 @@ void ui_display_game_progress(game_t *game) {
 
     ui_display_game_info(game);
     // Display lines cleared, game score, level, tetrimino count and time elapsed
-    if (util_time_expired_delay(ui_stats.animate_start_time, ui_stats.animate_delay)) {
-        ui_stats.animate_start_time = TIM2->CNT;
-        ui_stats.animate_delay = UI_STATS_DELAY;
+    if (ui_stats.animate_due) {
+        ui_stats.animate_due = 0;
+        timer_wheel_arm(ui_timer_wheel, &ui_stats.animate_timer, timebase_now32(), UI_STATS_DELAY);
         ui_stats.animate_frame++;
         if (ui_stats.animate_frame >= UI_STATS_NUM_FRAMES) {
             ui_stats.animate_frame = 0;
@@ -470,12 +485,12 @@ void ui_game_over_screen(game_t *game, ui_stats_t *ui_stats) {
  */
 void ui_display_high_scores(game_high_score_t *high_scores[], game_t *game) {
     // Only update screen if its time to switch
-    if (util_time_expired_delay(ui_high_score.animate_start_time, ui_high_score.animate_delay)) {
+    if (ui_high_score.animate_due) {
         char buffer[32];
         memset(buffer, 0, sizeof(buffer));
 
-        ui_high_score.animate_start_time = TIM2->CNT;
-        ui_high_score.animate_delay = UI_STATS_DELAY;
+        ui_high_score.animate_due = 0;
+        timer_wheel_arm(ui_timer_wheel, &ui_high_score.animate_timer, timebase_now32(), UI_STATS_DELAY);
 
         // Figure out which header to display
         if (ui_high_score.animate_frame == 0) {
@@ -548,6 +563,20 @@ void ui_display_fps(uint32_t start_count, uint32_t end_count, uint32_t time_us)
     ssd1306_UpdateScreen();
 }
 
+/**
+ * @brief  Show the duty cycle of the main loop next to the frame rate
+ * @param  load, busy time in tenths of a percent (scheduler_load)
+ * @retval None
+ */
+void ui_display_cpu_load(uint16_t load) {
+    char load_str[8];
+
+    ssd1306_SetCursor(66, 55);
+    snprintf(load_str, sizeof(load_str), "%3d%%", (int) ((load + 5) / 10));
+    ssd1306_WriteString(load_str, Font_6x8, White);
+    ssd1306_UpdateScreen();
+}
+
 void ui_display_game_info(game_t *game) {
     uint8_t x;
 
@@ -20,8 +20,8 @@
  */
 
 #include <stdint.h>
-#include "main.h"
 #include "util.h"
+#include "timebase.h"
 
 /**
  * @brief  Check if time has expired (rollover is handled)
@@ -30,19 +30,8 @@
  * @retval 1 if expired, 0 if not expired
  */
 uint8_t util_time_expired_delay(uint32_t start, uint32_t delay) {
-    uint32_t end = start + delay;
-    uint32_t rollover = 0xFFFFFFFF;
-
-    if (start > end)
-        end = rollover - start + end; // It will rollover, so we need to adjust the end time
-
-    if (TIM2->CNT >= end && start < end) { // Normal case
-        return 1;
-    } else if (TIM2->CNT < start && TIM2->CNT >= end) { // Rollover case
-        return 1;
-    }
-
-    return 0;
+    // Unsigned difference is correct across a rollover as long as delay is below 71 minutes
+    return (uint32_t) (timebase_now32() - start) >= delay;
 }
 
 /**
@@ -52,18 +41,7 @@ uint8_t util_time_expired_delay(uint32_t start, uint32_t delay) {
  * @retval 1 if expired, 0 if not expired
  */
 uint8_t util_time_expired(uint32_t start, uint32_t end) {
-    uint32_t rollover = 0xFFFFFFFF;
-
-    if (start > end)
-        end = rollover - start + end; // It will rollover, so we need to adjust the end time
-
-    if (TIM2->CNT >= end && start < end) { // Normal case
-        return 1;
-    } else if (TIM2->CNT < start && TIM2->CNT >= end) { // Rollover case
-        return 1;
-    }
-
-    return 0;
+    return (uint32_t) (timebase_now32() - start) >= (uint32_t) (end - start);
 }
 
 /**
@@ -73,18 +51,7 @@ uint8_t util_time_expired(uint32_t start, uint32_t end) {
  * @retval time difference in microseconds
  */
 uint32_t util_time_diff_us(uint32_t start, uint32_t end) {
-    uint32_t rollover = 0xFFFFFFFF;
-
-    if (start > end)
-        end = rollover - start + end; // It will rollover, so we need to adjust the end time
-
-    if (TIM2->CNT >= end && start < end) { // Normal case
-        return end - start;
-    } else if (TIM2->CNT < start && TIM2->CNT >= end) { // Rollover case
-        return (rollover - start) + end;
-    }
-
-    return 0;
+    return end - start;
 }
 
 /**
@@ -93,20 +60,9 @@ uint32_t util_time_diff_us(uint32_t start, uint32_t end) {
  * @retval None
  */
 void util_delay_us(uint32_t us) {
-    uint32_t start = TIM2->CNT;
-    uint32_t end = start + us;
-    uint32_t rollover = 0xFFFFFFFF;
-    uint8_t done = 0;
+    uint32_t start = timebase_now32();
 
-    if (start > end)
-        end = rollover - start + end; // It will rollover, so we need to adjust the end time
-
-    while (!done) {
-        if (TIM2->CNT >= end && start < end) { // Normal case
-            done = 1;
-        } else if (TIM2->CNT < start && TIM2->CNT >= end) { // Rollover case
-            done = 1;
-        }
+    while ((uint32_t) (timebase_now32() - start) < us) {
     }
 }
 
@@ -156,9 +112,24 @@ void util_to_binary8(uint8_t num, char *binary) {
  */
 uint8_t util_bit_count(uint32_t num) {
     uint8_t count = 0;
+    // Clear the lowest set bit each pass, one pass per set bit
     while (num) {
-        count += num & 1;
-        num >>= 1;
+        num &= num - 1;
+        count++;
     }
     return count;
 }
+
+/**
+ * @brief  Scramble a 32-bit number (MurmurHash3 finalizer)
+ * @param  num: number
+ * @retval hash of the number, every input bit affects every output bit
+ */
+uint32_t util_hash32(uint32_t num) {
+    num ^= num >> 16;
+    num *= 0x85EBCA6B;
+    num ^= num >> 13;
+    num *= 0xC2B2AE35;
+    num ^= num >> 16;
+    return num;
+}
@@ -0,0 +1,275 @@
+/**
+ ******************************************************************************
+ * @file           : engine_test.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Host test that pausing does not change the game played by tetris_engine.c
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+/*
+ * Plays a random controller script keyed by game frame twice with the same seed, the second time with
+ * START held on some of the presses. Each pass of the loop advances the game clock by more than a frame
+ * and steps the engine like GAME_STATE_GAME_IN_PROGRESS: drain the queue, step, and pause on
+ * TETRIS_ENGINE_EVENT_PAUSE. While paused the game clock and so the script stand still, resuming resets
+ * the input to the held buttons like game_loop_resume. The state after every step of the two games must
+ * be the same, so a pause loses no frame and no move merged with the START press.
+ *
+ * Exits with a failure on the first mismatch. Build and run with make check in this directory, or e.g.
+ * ./engine_test -n 100 -s 7
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "main.h"
+#include "matrix.h"
+#include "tetrimino.h"
+#include "tetris_engine.h"
+#include "snes_buttons.h"
+#include "ring_buffer.h"
+
+#define ENGINE_TEST_DEFAULT_GAMES (20)
+#define ENGINE_TEST_PASS_TIME (40000)   // microseconds of game clock per pass, 2 or 3 frames
+#define ENGINE_TEST_MAX_FRAMES (36000)  // frames played at most per game, 10 minutes
+#define ENGINE_TEST_SCRIPT_SIZE (ENGINE_TEST_MAX_FRAMES / 2)
+#define ENGINE_TEST_PAUSE_EVERY (25)    // presses between two START presses in the paused game
+#define ENGINE_TEST_QUEUE_SIZE (16)     // same depth as controller_buffer in game_loop
+
+typedef struct {
+    uint32_t frame; // game frame the reading arrives on
+    uint16_t buttons;
+} engine_test_reading_t;
+
+// State after one step, the two games are compared step by step
+typedef struct {
+    uint32_t frame_count;
+    uint32_t score;
+    uint32_t lines;
+    uint32_t stack_hash;
+    uint32_t drop_frame_count;
+    uint32_t lock_frame_count;
+    uint16_t events; // without TETRIS_ENGINE_EVENT_PAUSE
+    uint8_t play_state;
+    uint8_t piece;
+    uint8_t rotation;
+    uint8_t x;
+    uint8_t y;
+} engine_test_state_t;
+
+typedef struct {
+    engine_test_state_t state[ENGINE_TEST_MAX_FRAMES]; // a pass has at least one frame
+    uint32_t steps;
+    uint32_t pauses;
+    uint32_t pauses_with_frames; // pauses on a step that also passed frames
+    uint32_t pauses_with_moves; // pauses on a step that also had another press
+} engine_test_run_t;
+
+// Presses of the script, every press is followed by a release
+static const uint16_t engine_test_buttons[] = { SNES_BUTTON_LEFT, SNES_BUTTON_RIGHT, SNES_BUTTON_LEFT,
+        SNES_BUTTON_RIGHT, SNES_BUTTON_A, SNES_BUTTON_B, SNES_BUTTON_DOWN, SNES_BUTTON_UP,
+        SNES_BUTTON_LEFT | SNES_BUTTON_A, SNES_BUTTON_RIGHT | SNES_BUTTON_B };
+
+static engine_test_reading_t engine_test_script[ENGINE_TEST_SCRIPT_SIZE];
+static uint32_t engine_test_script_count;
+static engine_test_run_t engine_test_run[2];
+static RingBuffer engine_test_queue;
+
+/**
+ * @brief  Make a random script, a press and its release a few frames apart
+ * @param  None
+ * @retval None
+ */
+static void engine_test_make_script(void) {
+    uint32_t frame = 0;
+
+    for (engine_test_script_count = 0; engine_test_script_count + 1 < ENGINE_TEST_SCRIPT_SIZE;) {
+        frame += 1 + rand() % 6;
+        engine_test_script[engine_test_script_count].frame = frame;
+        engine_test_script[engine_test_script_count++].buttons =
+                engine_test_buttons[rand() % (sizeof(engine_test_buttons) / sizeof(engine_test_buttons[0]))];
+        frame += 1 + rand() % 3;
+        engine_test_script[engine_test_script_count].frame = frame;
+        engine_test_script[engine_test_script_count++].buttons = 0;
+    }
+}
+
+/**
+ * @brief  Play one game of the script
+ * @param  seed of the pieces, 1 to hold START on some presses, result
+ * @retval None
+ */
+static void engine_test_play(uint16_t seed, uint8_t with_pause, engine_test_run_t *run) {
+    static matrix_t matrix;
+    static tetrimino_t tetrimino;
+    static game_t game;
+    static tetris_engine_t engine;
+    tetris_engine_input_t input;
+    tetris_engine_reading_t reading;
+    engine_test_state_t *state;
+    uint32_t game_time = 0;
+    uint32_t frame_time = 0;
+    uint32_t frame = 0;
+    uint32_t next = 0;
+    uint16_t events;
+    uint8_t frames;
+
+    ring_buffer_flush(&engine_test_queue);
+    memset(run, 0, sizeof(engine_test_run_t));
+    memset(&game, 0, sizeof(game_t));
+    game.lock_frames = TETRIS_ENGINE_LOCK_FRAMES;
+    game.rotation_system = seed % 2 ? TETRIMINO_ROTATION_SYSTEM_SRS : TETRIMINO_ROTATION_SYSTEM_NES;
+    game.level = seed % 10;
+    tetris_engine_init(&engine, &game, &matrix, &tetrimino);
+    matrix_init(&matrix);
+    host_tim2.CNT = seed; // first piece drawn from the seed, as from TIM2 on the board
+    tetris_engine_start(&engine);
+    tetris_engine_input_reset(&input, 0);
+
+    while (frame < ENGINE_TEST_MAX_FRAMES && run->steps < ENGINE_TEST_MAX_FRAMES) {
+        game_time += ENGINE_TEST_PASS_TIME;
+        frames = tetris_engine_frame_ticks(&frame_time, game_time);
+        frame += frames;
+
+        for (; next < engine_test_script_count && engine_test_script[next].frame <= frame; next++) {
+            reading.buttons = engine_test_script[next].buttons;
+            if (with_pause && next % (2 * ENGINE_TEST_PAUSE_EVERY) == 0) {
+                reading.buttons |= SNES_BUTTON_START;
+            }
+            reading.repeat = 0;
+            reading.time = game_time;
+            ring_buffer_enqueue(&engine_test_queue, &reading);
+        }
+
+        tetris_engine_input_drain(&input, &engine_test_queue, game_time, NULL);
+        events = tetris_engine_step(&engine, &input, frames);
+
+        state = &run->state[run->steps++];
+        state->frame_count = game.frame_count;
+        state->score = game.score;
+        state->lines = game.lines;
+        state->stack_hash = matrix.stack_hash;
+        state->drop_frame_count = game.drop_frame_count;
+        state->lock_frame_count = game.lock_frame_count;
+        state->events = events & ~TETRIS_ENGINE_EVENT_PAUSE;
+        state->play_state = game.play_state;
+        state->piece = tetrimino.piece;
+        state->rotation = tetrimino.rotation;
+        state->x = tetrimino.x;
+        state->y = tetrimino.y;
+
+        if (events & TETRIS_ENGINE_EVENT_TOP_OUT) {
+            break;
+        }
+        if (events & TETRIS_ENGINE_EVENT_PAUSE) {
+            // The game clock stands still until the resume, which starts from the held buttons
+            run->pauses++;
+            run->pauses_with_frames += frames != 0;
+            run->pauses_with_moves += (input.pressed & ~SNES_BUTTON_START) != 0;
+            tetris_engine_input_reset(&input, input.held);
+        }
+    }
+}
+
+/**
+ * @brief  Compare the two games step by step
+ * @param  seed
+ * @retval None
+ */
+static void engine_test_compare(uint16_t seed) {
+    engine_test_run_t *plain = &engine_test_run[0];
+    engine_test_run_t *paused = &engine_test_run[1];
+    engine_test_state_t *a, *b;
+
+    for (uint32_t i = 0; i < plain->steps && i < paused->steps; i++) {
+        a = &plain->state[i];
+        b = &paused->state[i];
+        if (memcmp(a, b, sizeof(engine_test_state_t))) {
+            fprintf(stderr, "seed %u step %lu: frame %lu/%lu score %lu/%lu hash %08lx/%08lx events %x/%x "
+                    "piece %u/%u at %u,%u/%u,%u\n", seed, (unsigned long) i, (unsigned long) a->frame_count,
+                    (unsigned long) b->frame_count, (unsigned long) a->score, (unsigned long) b->score,
+                    (unsigned long) a->stack_hash, (unsigned long) b->stack_hash, a->events, b->events, a->piece,
+                    b->piece, a->x, a->y, b->x, b->y);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (plain->steps != paused->steps) {
+        fprintf(stderr, "seed %u: %lu steps without pauses, %lu with\n", seed, (unsigned long) plain->steps,
+                (unsigned long) paused->steps);
+        exit(EXIT_FAILURE);
+    }
+    if (plain->pauses != 0 || paused->pauses == 0) {
+        fprintf(stderr, "seed %u: %lu pauses without START, %lu with\n", seed, (unsigned long) plain->pauses,
+                (unsigned long) paused->pauses);
+        exit(EXIT_FAILURE);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long games = ENGINE_TEST_DEFAULT_GAMES;
+    unsigned int seed = 1;
+    uint64_t steps = 0;
+    uint64_t frames = 0;
+    uint64_t pauses = 0;
+    uint64_t pauses_with_frames = 0;
+    uint64_t pauses_with_moves = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+        case 'n':
+            games = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n games] [-s seed]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (ring_buffer_init(&engine_test_queue, ENGINE_TEST_QUEUE_SIZE, sizeof(tetris_engine_reading_t))
+            != RING_BUFFER_OK) {
+        Error_Handler();
+    }
+    srand(seed);
+    for (unsigned long g = 0; g < games; g++) {
+        engine_test_make_script();
+        engine_test_play((uint16_t) (seed + g), 0, &engine_test_run[0]);
+        engine_test_play((uint16_t) (seed + g), 1, &engine_test_run[1]);
+        engine_test_compare((uint16_t) (seed + g));
+
+        steps += engine_test_run[1].steps;
+        frames += engine_test_run[1].state[engine_test_run[1].steps - 1].frame_count;
+        pauses += engine_test_run[1].pauses;
+        pauses_with_frames += engine_test_run[1].pauses_with_frames;
+        pauses_with_moves += engine_test_run[1].pauses_with_moves;
+    }
+
+    // Without pauses on frame steps and on merged moves the test would not show anything
+    if (pauses_with_frames == 0 || pauses_with_moves == 0) {
+        fprintf(stderr, "%llu pauses, none on a frame step or with a move\n", (unsigned long long) pauses);
+        return EXIT_FAILURE;
+    }
+
+    printf("%lu games, %llu steps, %llu frames the same with and without pauses\n", games,
+            (unsigned long long) steps, (unsigned long long) frames);
+    printf("%llu pauses, %llu on a step with frames, %llu with a move\n", (unsigned long long) pauses,
+            (unsigned long long) pauses_with_frames, (unsigned long long) pauses_with_moves);
+    return EXIT_SUCCESS;
+}
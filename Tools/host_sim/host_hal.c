@@ -0,0 +1,36 @@
+/**
+ ******************************************************************************
+ * @file           : host_hal.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : HAL state shared by the host programs, see main.h
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "main.h"
+
+TIM_TypeDef host_tim2;
+
+/**
+ * @brief  Stop the host program on a fatal error, like the firmware Error_Handler
+ * @param  None
+ * @retval None
+ */
+void Error_Handler(void) {
+    fprintf(stderr, "Error_Handler called\n");
+    exit(EXIT_FAILURE);
+}
@@ -0,0 +1,662 @@
+/**
+ ******************************************************************************
+ * @file           : host_sim.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Headless host simulator of the gameplay engine with a throughput report
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+/*
+ * Plays games with the production engine (tetris_engine.c, matrix.c, tetrimino.c, tetris.c, rng.c and
+ * ring_buffer.c) against a simulated 1 MHz TIM2. Each pass of the simulated game loop advances the
+ * clock by the loop period, queues controller readings at the 60 Hz read rate of the firmware, drains
+ * every reading queued since the previous pass into one input and steps the engine once, like
+ * GAME_STATE_GAME_IN_PROGRESS does. A loop period longer than a reading merges several readings into
+ * one pass, the input latency and the merged readings are reported.
+ *
+ * Input is either random, a placement per piece picked with a bias toward low landing spots and sent
+ * as rotate, shift and hard drop presses, or a script replayed from the start of every game. A script
+ * line is "<delay_ms> <buttons>", the buttons held for the reading, '-' for none:
+ *   U D L R A B X Y (d-pad and face buttons), l r (shoulders), e (select), s (start)
+ * Lines starting with '#' are comments. The script repeats until the game tops out.
+ *
+ * With -t the loop also keeps that many one-shot timers armed on a timer wheel (timer_wheel.c), each
+ * re-armed with a random delay from its callback, and cancels and re-arms a random one every pass.
+ * The wheel is advanced once per pass like the firmware main loop and its cost is reported apart.
+ *
+ * The 64-bit timebase (timebase.c) is driven from the simulated TIM2 and checked against the simulated
+ * time on every pass, also between a wrap and its overflow interrupt. With -w the clock starts that
+ * many seconds before TIM2 wraps, and long runs go through a wrap every 71.6 simulated minutes.
+ *
+ * Every spawned piece also goes through the placement generator (placement.c). The list lengths and
+ * the generation cost are reported, and a listed placement that is not a resting pose is counted.
+ *
+ * Build with make in this directory, then e.g. ./host_sim -n 1000 -s 7
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "main.h"
+#include "matrix.h"
+#include "tetrimino.h"
+#include "tetrimino_shape.h"
+#include "tetris.h"
+#include "tetris_engine.h"
+#include "snes_buttons.h"
+#include "ring_buffer.h"
+#include "timer_wheel.h"
+#include "timebase.h"
+#include "placement.h"
+
+#define HOST_SIM_CONTROLLER_PERIOD (1000000 / 60) // microseconds between controller readings
+#define HOST_SIM_QUEUE_SIZE (16)                  // same depth as controller_buffer in game_loop
+#define HOST_SIM_SCRIPT_MAX (4096)
+#define HOST_SIM_TIMERS_MAX (4096)
+#define HOST_SIM_TIMER_DELAY_MAX (2000000) // microseconds, longer than one turn of the wheel
+
+typedef struct {
+    uint32_t delay; // microseconds until the next reading
+    uint16_t buttons;
+} host_sim_reading_t;
+
+typedef struct {
+    host_sim_reading_t reading[HOST_SIM_SCRIPT_MAX];
+    uint16_t count;
+    uint16_t index;
+} host_sim_input_t;
+
+typedef struct {
+    uint64_t count;
+    uint64_t ns;
+    uint64_t worst_ns;
+} host_sim_cost_t;
+
+typedef struct {
+    uint64_t lists;
+    uint64_t placements;
+    uint16_t most; // longest list
+    uint64_t invalid; // listed placements that are not resting poses
+} host_sim_placement_stats_t;
+
+typedef struct {
+    timer_wheel_timer_t timer;
+    uint32_t expiry; // expected expiry, to check the wheel
+} host_sim_timer_t;
+
+static timer_wheel_t host_sim_wheel;
+static host_sim_timer_t host_sim_timers[HOST_SIM_TIMERS_MAX];
+static uint32_t host_sim_timer_now; // time of the advance running the callbacks
+static uint64_t host_sim_timer_fired;
+static uint64_t host_sim_timer_early;
+static uint32_t host_sim_timer_late_worst;
+static uint8_t host_sim_overflow_flag; // TIM2 update flag, set on a wrap until the interrupt runs
+static uint64_t host_sim_timebase_errors;
+static uint32_t host_sim_wraps;
+
+static uint32_t host_sim_counter(void);
+static uint8_t host_sim_overflow_pending(void);
+static const timebase_clock_t host_sim_clock = { .counter = host_sim_counter, .overflow_pending =
+        host_sim_overflow_pending };
+
+/**
+ * @brief  Read the host monotonic clock
+ * @param  None
+ * @retval Time in nanoseconds
+ */
+static uint64_t host_sim_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief  Add one measured step to a cost bucket
+ * @param  cost bucket, step duration in nanoseconds
+ * @retval None
+ */
+static void host_sim_cost_add(host_sim_cost_t *cost, uint64_t ns) {
+    cost->count++;
+    cost->ns += ns;
+    if (ns > cost->worst_ns) {
+        cost->worst_ns = ns;
+    }
+}
+
+/**
+ * @brief  Print the average and worst cost of a bucket
+ * @param  label, cost bucket
+ * @retval None
+ */
+static void host_sim_cost_print(const char *label, host_sim_cost_t *cost) {
+    if (cost->count == 0) {
+        printf("%-22s none\n", label);
+        return;
+    }
+    printf("%-22s %8.0f ns avg  %8llu ns worst  (%llu steps)\n", label, (double) cost->ns / cost->count,
+            (unsigned long long) cost->worst_ns, (unsigned long long) cost->count);
+}
+
+/**
+ * @brief  Simulated TIM2 count for the timebase
+ * @param  None
+ * @retval Count in microseconds
+ */
+static uint32_t host_sim_counter(void) {
+    return host_tim2.CNT;
+}
+
+/**
+ * @brief  Simulated TIM2 update flag for the timebase
+ * @param  None
+ * @retval 1 if TIM2 wrapped and the overflow interrupt has not run yet
+ */
+static uint8_t host_sim_overflow_pending(void) {
+    return host_sim_overflow_flag;
+}
+
+/**
+ * @brief  Move the simulated TIM2 to a time and run its overflow interrupt if it wrapped, the
+ *         timebase is checked before and after the interrupt
+ * @param  simulated time in microseconds
+ * @retval None
+ */
+static void host_sim_set_time(uint64_t now) {
+    if ((uint32_t) now < host_tim2.CNT) {
+        host_sim_overflow_flag = 1;
+    }
+    host_tim2.CNT = (uint32_t) now;
+    if (timebase_now() != now) {
+        host_sim_timebase_errors++;
+    }
+    if (host_sim_overflow_flag) {
+        host_sim_overflow_flag = 0;
+        timebase_overflow();
+        host_sim_wraps++;
+        if (timebase_now() != now) {
+            host_sim_timebase_errors++;
+        }
+    }
+}
+
+/**
+ * @brief  Arm a benchmark timer with a random delay
+ * @param  benchmark timer, current time in microseconds
+ * @retval None
+ */
+static void host_sim_timer_arm(host_sim_timer_t *timer, uint32_t now) {
+    uint32_t delay = rand() % HOST_SIM_TIMER_DELAY_MAX;
+
+    timer->expiry = now + delay;
+    timer_wheel_arm(&host_sim_wheel, &timer->timer, now, delay);
+}
+
+/**
+ * @brief  Benchmark timer expired, check it is not early and arm it again
+ * @param  context, the benchmark timer
+ * @retval None
+ */
+static void host_sim_timer_expired(void *context) {
+    host_sim_timer_t *timer = context;
+    int32_t late = (int32_t) (host_sim_timer_now - timer->expiry);
+
+    host_sim_timer_fired++;
+    if (late < 0) {
+        host_sim_timer_early++;
+    } else if ((uint32_t) late > host_sim_timer_late_worst) {
+        host_sim_timer_late_worst = late;
+    }
+    host_sim_timer_arm(timer, host_sim_timer_now);
+}
+
+/**
+ * @brief  Convert script button letters to a SNES_BUTTON_* mask
+ * @param  text
+ * @retval Button mask
+ */
+static uint16_t host_sim_parse_buttons(const char *text) {
+    uint16_t buttons = 0;
+
+    for (; *text; text++) {
+        switch (*text) {
+        case 'U':
+            buttons |= SNES_BUTTON_UP;
+            break;
+        case 'D':
+            buttons |= SNES_BUTTON_DOWN;
+            break;
+        case 'L':
+            buttons |= SNES_BUTTON_LEFT;
+            break;
+        case 'R':
+            buttons |= SNES_BUTTON_RIGHT;
+            break;
+        case 'A':
+            buttons |= SNES_BUTTON_A;
+            break;
+        case 'B':
+            buttons |= SNES_BUTTON_B;
+            break;
+        case 'X':
+            buttons |= SNES_BUTTON_X;
+            break;
+        case 'Y':
+            buttons |= SNES_BUTTON_Y;
+            break;
+        case 'l':
+            buttons |= SNES_BUTTON_L;
+            break;
+        case 'r':
+            buttons |= SNES_BUTTON_R;
+            break;
+        case 'e':
+            buttons |= SNES_BUTTON_SELECT;
+            break;
+        case 's':
+            buttons |= SNES_BUTTON_START;
+            break;
+        default:
+            break;
+        }
+    }
+
+    return buttons;
+}
+
+/**
+ * @brief  Load an input script
+ * @param  file path, input to fill
+ * @retval 0 on success, -1 if the file cannot be read or holds no readings
+ */
+static int host_sim_load_script(const char *path, host_sim_input_t *input) {
+    char line[128];
+    char buttons[64];
+    unsigned int delay_ms;
+    FILE *file = fopen(path, "r");
+
+    if (file == NULL) {
+        return -1;
+    }
+
+    input->count = 0;
+    while (fgets(line, sizeof(line), file) != NULL && input->count < HOST_SIM_SCRIPT_MAX) {
+        if (line[0] == '#' || sscanf(line, "%u %63s", &delay_ms, buttons) != 2) {
+            continue;
+        }
+        input->reading[input->count].delay = delay_ms * 1000;
+        input->reading[input->count].buttons = host_sim_parse_buttons(buttons);
+        input->count++;
+    }
+    fclose(file);
+
+    return input->count ? 0 : -1;
+}
+
+/**
+ * @brief  Plan the presses that place the current tetrimino, three in four pieces go to the lowest
+ *         landing spot of a random rotation, the others to a random column
+ * @param  matrix object, tetrimino at its spawn pose, input to fill
+ * @retval None
+ */
+static void host_sim_plan_random(matrix_t *matrix, tetrimino_t *tetrimino, host_sim_input_t *input) {
+    tetrimino_t target;
+    uint8_t turns = rand() % TETRIMINO_ROTATION_COUNT;
+    int best_x = -1;
+    int best_y = 0;
+    int dx;
+
+    tetrimino_copy(&target, tetrimino);
+    target.rotation = (tetrimino->rotation + turns) % TETRIMINO_ROTATION_COUNT;
+    target.shape_offset = tetrimino_shape_offset_lut[target.piece][target.rotation];
+
+    if (rand() % 4) {
+        for (int x = 0, ties = 0; x < PLAYING_FIELD_WIDTH; x++) {
+            target.x = x;
+            if (matrix_piece_fits(matrix, target.piece, target.rotation, target.x, target.y) != MATRIX_OK) {
+                continue;
+            }
+            int y = target.y - matrix_drop_distance(matrix, &target);
+            if (best_x < 0 || y < best_y) {
+                best_x = x;
+                best_y = y;
+                ties = 1;
+            } else if (y == best_y && rand() % ++ties == 0) {
+                best_x = x;
+            }
+        }
+    }
+    if (best_x < 0) {
+        best_x = rand() % PLAYING_FIELD_WIDTH;
+    }
+
+    // Every press is followed by a release so the engine sees a new reading each time, the hard drop
+    // of the previous piece may still be held
+    input->count = 0;
+    input->reading[input->count++].buttons = 0;
+    for (int i = 0; i < turns; i++) {
+        input->reading[input->count++].buttons = SNES_BUTTON_A;
+        input->reading[input->count++].buttons = 0;
+    }
+    dx = best_x - tetrimino->x;
+    for (int i = 0; i < abs(dx); i++) {
+        input->reading[input->count++].buttons = dx < 0 ? SNES_BUTTON_LEFT : SNES_BUTTON_RIGHT;
+        input->reading[input->count++].buttons = 0;
+    }
+    input->reading[input->count++].buttons = SNES_BUTTON_UP;
+    input->reading[input->count++].buttons = 0;
+    for (int i = 0; i < input->count; i++) {
+        input->reading[i].delay = HOST_SIM_CONTROLLER_PERIOD;
+    }
+    input->index = 0;
+}
+
+/**
+ * @brief  Generate the placements of a spawned tetrimino and check that each one is a resting pose
+ * @param  matrix object, tetrimino at its spawn pose, rotation system, cost bucket, statistics
+ * @retval None
+ */
+static void host_sim_generate(matrix_t *matrix, tetrimino_t *tetrimino, tetrimino_rotation_system_t rotation_system,
+        host_sim_cost_t *cost, host_sim_placement_stats_t *stats) {
+    static placement_list_t list;
+    placement_t *placement;
+    uint64_t ns = host_sim_ns();
+
+    if (placement_generate(matrix, tetrimino, rotation_system, &list) != PLACEMENT_OK) {
+        return;
+    }
+    host_sim_cost_add(cost, host_sim_ns() - ns);
+
+    stats->lists++;
+    stats->placements += list.count;
+    if (list.count > stats->most) {
+        stats->most = list.count;
+    }
+    for (int i = 0; i < list.count; i++) {
+        placement = &list.placement[i];
+        if (matrix_piece_fits(matrix, list.piece, placement->rotation, placement->x, placement->y) != MATRIX_OK
+                || (placement->y > 0
+                        && matrix_piece_fits(matrix, list.piece, placement->rotation, placement->x,
+                                placement->y - 1) == MATRIX_OK)) {
+            stats->invalid++;
+        }
+    }
+}
+
+/**
+ * @brief  Print the command line options
+ * @param  program name
+ * @retval None
+ */
+static void host_sim_usage(const char *name) {
+    printf("usage: %s [-n games] [-s seed] [-l level] [-p loop_period_us] [-m max_pieces] [-k] [-f script]"
+            " [-t timers] [-w seconds]\n", name);
+    printf("  -n  games to play (100)\n");
+    printf("  -s  seed of the random input and of the simulated start time (1)\n");
+    printf("  -l  starting level (0)\n");
+    printf("  -p  simulated time of one pass of the game loop in microseconds (1000)\n");
+    printf("  -m  pieces after which a game is stopped if it has not topped out (10000)\n");
+    printf("  -k  use SRS wall kicks instead of the NES rotation system\n");
+    printf("  -f  replay an input script instead of random input\n");
+    printf("  -t  one-shot timers kept armed on the timer wheel, up to %d (0)\n", HOST_SIM_TIMERS_MAX);
+    printf("  -w  start the simulated clock this many seconds before TIM2 wraps, up to 4294 (0, start at seed)\n");
+}
+
+int main(int argc, char *argv[]) {
+    static host_sim_input_t input;
+    static matrix_t matrix;
+    static tetrimino_t tetrimino;
+    static game_t game;
+    static tetris_engine_t engine;
+    tetris_statistics_t tetris_statistics;
+    tetris_engine_input_t engine_input;
+    tetris_engine_input_stats_t input_stats = { 0 };
+    tetris_engine_reading_t reading;
+    RingBuffer controller_buffer;
+    host_sim_cost_t cost_step = { 0 };
+    host_sim_cost_t cost_lock = { 0 };
+    host_sim_cost_t cost_line_clear = { 0 };
+    host_sim_cost_t cost_advance = { 0 };
+    host_sim_cost_t cost_rearm = { 0 };
+    host_sim_cost_t cost_generate = { 0 };
+    host_sim_placement_stats_t placement_stats = { 0 };
+    host_sim_timer_t *timer;
+    struct rusage usage;
+    uint16_t engine_events;
+    uint32_t frame_time;
+    uint8_t frames;
+    uint8_t queued;
+    uint64_t now, start, next_reading, start_ns, step_ns, wall_ns, engine_ns = 0;
+    uint64_t total_pieces = 0, total_lines = 0, total_score = 0, line_clears = 0, total_frames = 0;
+    uint32_t max_level = 0;
+    unsigned long games = 100, seed = 1, level = 0, period = 1000, max_pieces = 10000, timers = 0;
+    unsigned long wrap = 0;
+    int scripted = 0;
+    int option;
+
+    tetrimino_rotation_system_t rotation_system = ROTATION_SYSTEM_DEFAULT;
+
+    while ((option = getopt(argc, argv, "n:s:l:p:m:kf:t:w:h")) != -1) {
+        switch (option) {
+        case 'n':
+            games = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            level = strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            period = strtoul(optarg, NULL, 0);
+            break;
+        case 'm':
+            max_pieces = strtoul(optarg, NULL, 0);
+            break;
+        case 'k':
+            rotation_system = TETRIMINO_ROTATION_SYSTEM_SRS;
+            break;
+        case 'f':
+            if (host_sim_load_script(optarg, &input) != 0) {
+                fprintf(stderr, "Cannot read input script %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            scripted = 1;
+            break;
+        case 't':
+            timers = strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            wrap = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            host_sim_usage(argv[0]);
+            return option == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (period == 0 || level > 255 || timers > HOST_SIM_TIMERS_MAX || wrap > 4294) {
+        host_sim_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (ring_buffer_init(&controller_buffer, HOST_SIM_QUEUE_SIZE, sizeof(tetris_engine_reading_t))
+            != RING_BUFFER_OK) {
+        Error_Handler();
+    }
+    srand(seed);
+    memset(&game, 0, sizeof(game_t));
+    game.lock_frames = TETRIS_ENGINE_LOCK_FRAMES; // 0.5 seconds, as in game_init
+    game.rotation_system = rotation_system;
+    tetris_engine_init(&engine, &game, &matrix, &tetrimino);
+    matrix_init(&matrix);
+
+    now = (uint32_t) (seed - wrap * 1000000);
+    host_tim2.CNT = (uint32_t) now;
+    timebase_init(&host_sim_clock);
+    timer_wheel_init(&host_sim_wheel, (uint32_t) now);
+    for (unsigned long i = 0; i < timers; i++) {
+        timer_wheel_timer_init(&host_sim_timers[i].timer, host_sim_timer_expired, &host_sim_timers[i]);
+        host_sim_timer_arm(&host_sim_timers[i], (uint32_t) now);
+    }
+    start = now;
+    start_ns = host_sim_ns();
+    for (unsigned long g = 0; g < games; g++) {
+        // The first piece is drawn from a seed taken from TIM2, as on the board
+        host_sim_set_time(now);
+        game.level = level;
+        tetris_engine_start(&engine);
+        frame_time = (uint32_t) now;
+        tetris_statistics_reset(&tetris_statistics);
+        tetris_statistics.tetriminos_frequency[tetrimino.piece]++;
+        ring_buffer_flush(&controller_buffer);
+        tetris_engine_input_reset(&engine_input, 0);
+        next_reading = now;
+        host_sim_generate(&matrix, &tetrimino, rotation_system, &cost_generate, &placement_stats);
+        if (scripted) {
+            input.index = 0;
+        } else {
+            host_sim_plan_random(&matrix, &tetrimino, &input);
+        }
+
+        for (;;) {
+            host_sim_set_time(now);
+            frames = tetris_engine_frame_ticks(&frame_time, (uint32_t) now);
+
+            // Controller readings arrive at the read rate, a full queue drops them like game_loop does, a
+            // script of zero delays queues at most a queue full per pass
+            if (input.index == input.count && next_reading < now) {
+                next_reading = now; // out of input, the next plan is read from now on
+            }
+            for (queued = 0; now >= next_reading && input.index < input.count && queued < HOST_SIM_QUEUE_SIZE;
+                    queued++) {
+                reading.buttons = input.reading[input.index].buttons;
+                reading.repeat = 0;
+                reading.time = (uint32_t) next_reading;
+                ring_buffer_enqueue(&controller_buffer, &reading);
+                next_reading += input.reading[input.index].delay;
+                input.index++;
+                if (scripted && input.index == input.count) {
+                    input.index = 0;
+                }
+            }
+
+            step_ns = host_sim_ns();
+            tetris_engine_input_drain(&engine_input, &controller_buffer, (uint32_t) now, &input_stats);
+            engine_events = tetris_engine_step(&engine, &engine_input, frames);
+            step_ns = host_sim_ns() - step_ns;
+
+            engine_ns += step_ns;
+            host_sim_cost_add(&cost_step, step_ns);
+            if (engine_events & TETRIS_ENGINE_EVENT_LOCK) {
+                host_sim_cost_add(&cost_lock, step_ns);
+            }
+            if (engine_events & TETRIS_ENGINE_EVENT_LINE_CLEAR) {
+                host_sim_cost_add(&cost_line_clear, step_ns);
+                line_clears++;
+            }
+            if (engine_events & TETRIS_ENGINE_EVENT_SPAWN) {
+                tetris_statistics.tetriminos_frequency[tetrimino.piece]++;
+                tetris_statistics.tetriminos_spawned++;
+                host_sim_generate(&matrix, &tetrimino, rotation_system, &cost_generate, &placement_stats);
+                if (!scripted) {
+                    host_sim_plan_random(&matrix, &tetrimino, &input);
+                }
+            }
+
+            if (timers) {
+                host_sim_timer_now = (uint32_t) now;
+                step_ns = host_sim_ns();
+                timer_wheel_advance(&host_sim_wheel, (uint32_t) now);
+                host_sim_cost_add(&cost_advance, host_sim_ns() - step_ns);
+
+                timer = &host_sim_timers[rand() % timers];
+                step_ns = host_sim_ns();
+                timer_wheel_cancel(&host_sim_wheel, &timer->timer);
+                host_sim_timer_arm(timer, (uint32_t) now);
+                host_sim_cost_add(&cost_rearm, host_sim_ns() - step_ns);
+            }
+
+            now += period;
+            if (engine_events & TETRIS_ENGINE_EVENT_TOP_OUT || tetris_statistics.tetriminos_spawned >= max_pieces) {
+                break;
+            }
+        }
+
+        total_pieces += tetris_statistics.tetriminos_spawned + 1;
+        total_lines += game.lines;
+        total_frames += game.frame_count;
+        total_score += game.score;
+        if (game.level > max_level) {
+            max_level = game.level;
+        }
+    }
+    wall_ns = host_sim_ns() - start_ns;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("games                  %lu (%s input, %s rotation)\n", games, scripted ? "scripted" : "random",
+            rotation_system == TETRIMINO_ROTATION_SYSTEM_SRS ? "SRS" : "NES");
+    printf("pieces                 %llu (%.1f per game)\n", (unsigned long long) total_pieces,
+            (double) total_pieces / games);
+    printf("lines                  %llu in %llu clears, average score %.0f, highest level %u\n",
+            (unsigned long long) total_lines, (unsigned long long) line_clears, (double) total_score / games,
+            (unsigned int) max_level);
+    printf("simulated time         %.1f s in %llu frames of %lu us\n", (now - start) / 1e6,
+            (unsigned long long) cost_step.count, period);
+    printf("game frames            %llu of %u us (%.4f Hz, rounded from the NES rate of 60.0988 Hz)\n",
+            (unsigned long long) total_frames, (unsigned int) TETRIS_ENGINE_FRAME_PERIOD,
+            1e6 / TETRIS_ENGINE_FRAME_PERIOD);
+    printf("host time              %.3f s (engine %.3f s)\n", wall_ns / 1e9, engine_ns / 1e9);
+    printf("frames per second      %.0f (engine only %.0f), %.0fx real time\n", cost_step.count / (wall_ns / 1e9),
+            cost_step.count / (engine_ns / 1e9), (now - start) * 1e3 / wall_ns);
+    printf("input                  %lu readings, latency avg %lu us worst %lu us, %lu coalesced, %lu late\n",
+            (unsigned long) input_stats.readings,
+            (unsigned long) (input_stats.readings ? input_stats.latency_total / input_stats.readings : 0),
+            (unsigned long) input_stats.latency_worst, (unsigned long) input_stats.coalesced,
+            (unsigned long) input_stats.late);
+    printf("timebase               %lu TIM2 wraps, %llu errors\n", (unsigned long) host_sim_wraps,
+            (unsigned long long) host_sim_timebase_errors);
+    host_sim_cost_print("cost per frame", &cost_step);
+    host_sim_cost_print("cost per lock", &cost_lock);
+    host_sim_cost_print("cost per line clear", &cost_line_clear);
+    printf("placements             %.1f per spawn, at most %u of %u, %llu not resting\n",
+            placement_stats.lists ? (double) placement_stats.placements / placement_stats.lists : 0.0,
+            (unsigned int) placement_stats.most, (unsigned int) PLACEMENT_MAX_COUNT,
+            (unsigned long long) placement_stats.invalid);
+    host_sim_cost_print("cost per generate", &cost_generate);
+    if (timers) {
+        printf("timers                 %lu armed, %llu fired, %llu early, latest %lu us after expiry\n", timers,
+                (unsigned long long) host_sim_timer_fired, (unsigned long long) host_sim_timer_early,
+                (unsigned long) host_sim_timer_late_worst);
+        host_sim_cost_print("cost per advance", &cost_advance);
+        host_sim_cost_print("cost per cancel+arm", &cost_rearm);
+        printf("timer wheel            %u bytes, %u per timer\n", (unsigned int) sizeof(timer_wheel_t),
+                (unsigned int) sizeof(timer_wheel_timer_t));
+    }
+    printf("game state             %u bytes (matrix %u, engine %u, game %u, tetrimino %u, controller queue %u)\n",
+            (unsigned int) (sizeof(matrix_t) + sizeof(tetris_engine_t) + sizeof(game_t) + sizeof(tetrimino_t)
+                    + HOST_SIM_QUEUE_SIZE * sizeof(tetris_engine_reading_t)), (unsigned int) sizeof(matrix_t),
+            (unsigned int) sizeof(tetris_engine_t), (unsigned int) sizeof(game_t), (unsigned int) sizeof(tetrimino_t),
+            (unsigned int) (HOST_SIM_QUEUE_SIZE * sizeof(tetris_engine_reading_t)));
+    printf("peak memory            %ld KB resident\n", usage.ru_maxrss);
+
+    ring_buffer_destroy(&controller_buffer);
+
+    return EXIT_SUCCESS;
+}
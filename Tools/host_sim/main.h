@@ -0,0 +1,77 @@
+/**
+ ******************************************************************************
+ * @file           : main.h
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Host stand-in for Core/Inc/main.h, simulated TIM2 and no-op HAL calls
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+/* Found before Core/Inc on the include path, so the Core sources include this file instead */
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// TIM2 counts microseconds like the board (1 MHz, 32 bits), the simulator sets CNT directly
+typedef struct {
+    volatile uint32_t CNT;
+} TIM_TypeDef;
+
+extern TIM_TypeDef host_tim2;
+#define TIM2 (&host_tim2)
+
+typedef enum {
+    HAL_OK = 0x00U, HAL_ERROR = 0x01U, HAL_BUSY = 0x02U, HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef struct {
+    volatile uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef enum {
+    GPIO_PIN_RESET = 0, GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+    uint32_t State;
+} DMA_HandleTypeDef;
+
+static inline void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+    (void) GPIOx;
+    (void) GPIO_Pin;
+    (void) PinState;
+}
+
+// SNES data lines idle high, no button pressed
+static inline GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin) {
+    (void) GPIOx;
+    (void) GPIO_Pin;
+    return GPIO_PIN_SET;
+}
+
+static inline HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress,
+        uint32_t DataLength) {
+    (void) hdma;
+    (void) SrcAddress;
+    (void) DstAddress;
+    (void) DataLength;
+    return HAL_OK;
+}
+
+void Error_Handler(void);
+
+#endif /* __MAIN_H */
@@ -0,0 +1,220 @@
+/**
+ ******************************************************************************
+ * @file           : matrix_bench.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Host microbenchmark of the row per matrix_row_t layout against the packed layout
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+
+/*
+ * Times the matrix operations of the game loop with the current layout (matrix.c, one matrix_row_t per
+ * row) and with the previous one (matrix_packed.c, two rows per uint32_t). Both run the same tetrimino
+ * positions and stacks, the per call time is the average over the iterations. merge_with_stack and the
+ * line clear animation of the current layout also keep the surface and the stack hash up to date, which
+ * the packed layout never had. The last table is the worst case of the line clear compaction, 1 to 4 rows
+ * cleared under a stack as tall as the playfield: one pass over the rows for matrix.c, one pass per
+ * dropped row for the packed layout.
+ *
+ * Build with make bench in this directory, then e.g. ./matrix_bench -n 1000000
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "main.h"
+#include "matrix.h"
+#include "matrix_packed.h"
+#include "tetrimino.h"
+#include "tetrimino_shape.h"
+
+#define MATRIX_BENCH_DEFAULT_ITERATIONS (2000000)
+
+volatile uint32_t matrix_bench_sink; // keeps the compiler from dropping the calls
+
+/**
+ * @brief  Read the host monotonic clock
+ * @param  None
+ * @retval Nanoseconds
+ */
+static uint64_t matrix_bench_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Time body over n iterations (loop index i) and return the nanoseconds per iteration
+#define MATRIX_BENCH_TIME(result, n, body) do { \
+        uint64_t matrix_bench_start = matrix_bench_now_ns(); \
+        for (long i = 0; i < (n); i++) { \
+            body; \
+        } \
+        (result) = (double) (matrix_bench_now_ns() - matrix_bench_start) / (n); \
+    } while (0)
+
+/**
+ * @brief  Print one operation of the report
+ * @param  operation name, time per call of each layout
+ * @retval None
+ */
+static void matrix_bench_report(const char *name, double row_ns, double packed_ns) {
+    printf("%-34s %9.1f %9.1f %7.2fx\n", name, row_ns, packed_ns, packed_ns / row_ns);
+}
+
+/**
+ * @brief  Fill rows first to last - 1 of a stack, each with one hole so none clears
+ * @param  matrix, first row, last row (excluded)
+ * @retval None
+ */
+static void matrix_bench_fill_stack(matrix_t *matrix, uint8_t first, uint8_t last) {
+    for (int row = first; row < last; row++) {
+        matrix->stack[row] = PLAYING_FIELD_MASK & ~PLAYING_FIELD_COLUMN_BIT(row % PLAYING_FIELD_WIDTH);
+        matrix->palette[0][row] = matrix->stack[row] & ~PLAYING_FIELD_COLUMN_BIT((row + 3) % PLAYING_FIELD_WIDTH);
+        matrix->palette[1][row] = matrix->stack[row] & ~PLAYING_FIELD_COLUMN_BIT((row + 6) % PLAYING_FIELD_WIDTH);
+    }
+    matrix_surface_recompute(matrix);
+    matrix_hash_recompute(matrix);
+}
+
+int main(int argc, char *argv[]) {
+    static matrix_t matrix, saved;
+    static matrix_packed_t packed, packed_saved;
+    tetrimino_t tetrimino;
+    long iterations = MATRIX_BENCH_DEFAULT_ITERATIONS;
+    double row_ns, packed_ns;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n':
+            iterations = strtol(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (iterations <= 0) {
+        fprintf(stderr, "iterations must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    // Half high stack, the T piece moves over it in the middle of the board
+    matrix_init(&matrix);
+    matrix_bench_fill_stack(&matrix, 0, PLAYING_FIELD_HEIGHT / 2);
+    matrix_packed_from_matrix(&packed, &matrix);
+    tetrimino_spawn_piece(&tetrimino, TETRIMINO_T);
+    tetrimino.y = PLAYING_FIELD_HEIGHT / 2 + 2;
+
+    printf("%ld iterations, ns per call\n", iterations);
+    printf("%-34s %9s %9s %8s\n", "operation", "row", "packed", "ratio");
+
+    MATRIX_BENCH_TIME(row_ns, iterations, {
+        tetrimino.x = 1 + i % (PLAYING_FIELD_WIDTH - 2);
+        matrix_bench_sink += matrix_add_tetrimino(&matrix, &tetrimino);
+    });
+    MATRIX_BENCH_TIME(packed_ns, iterations, {
+        tetrimino.x = 1 + i % (PLAYING_FIELD_WIDTH - 2);
+        matrix_bench_sink += matrix_packed_add_tetrimino(&packed, &tetrimino);
+    });
+    matrix_bench_report("add_tetrimino", row_ns, packed_ns);
+
+    // The packed layout compared the whole playfield drawn by add_tetrimino with the stack
+    tetrimino.x = PLAYING_FIELD_WIDTH / 2;
+    matrix_add_tetrimino(&matrix, &tetrimino);
+    matrix_packed_add_tetrimino(&packed, &tetrimino);
+    MATRIX_BENCH_TIME(row_ns, iterations, matrix_bench_sink += matrix_check_collision(&matrix, &tetrimino));
+    MATRIX_BENCH_TIME(packed_ns, iterations, matrix_bench_sink += matrix_packed_check_collision(&packed));
+    matrix_bench_report("check_collision", row_ns, packed_ns);
+
+    MATRIX_BENCH_TIME(row_ns, iterations, matrix_bench_sink += matrix_check_line_clear(&matrix));
+    MATRIX_BENCH_TIME(packed_ns, iterations, matrix_bench_sink += matrix_packed_check_line_clear(&packed));
+    matrix_bench_report("check_line_clear", row_ns, packed_ns);
+
+    MATRIX_BENCH_TIME(row_ns, iterations, matrix_bench_sink += merge_with_stack(&matrix, &tetrimino));
+    MATRIX_BENCH_TIME(packed_ns, iterations, matrix_bench_sink += matrix_packed_merge_with_stack(&packed, &tetrimino));
+    matrix_bench_report("merge_with_stack", row_ns, packed_ns);
+
+    // One animation frame on the 4 bottom rows, the frame number cycles through the whole animation
+    MATRIX_BENCH_TIME(row_ns, iterations, {
+        matrix_line_clear_start(&matrix, 0);
+        matrix.animation.frame_nbr = i % CLEAR_LINE_NUM_FRAMES;
+        matrix_bench_sink += matrix_line_clear_animate(&matrix, 0xF, 1);
+    });
+    MATRIX_BENCH_TIME(packed_ns, iterations, {
+        matrix_packed_line_clear_frame(&packed, 0xF, i % CLEAR_LINE_NUM_FRAMES);
+    });
+    matrix_bench_report("line_clear_frame (4 rows)", row_ns, packed_ns);
+
+    // Tetris under a tall stack, the cleared rows are already empty when reposition_blocks runs
+    matrix_init(&saved);
+    matrix_bench_fill_stack(&saved, 4, PLAYING_FIELD_HEIGHT - 2);
+    matrix_packed_from_matrix(&packed_saved, &saved);
+    MATRIX_BENCH_TIME(row_ns, iterations / 10 + 1, {
+        memcpy(&matrix, &saved, sizeof(matrix_t));
+        matrix_bench_sink += matrix_reposition_blocks(&matrix, 0xF);
+    });
+    MATRIX_BENCH_TIME(packed_ns, iterations / 10 + 1, {
+        memcpy(&packed, &packed_saved, sizeof(matrix_packed_t));
+        matrix_bench_sink += matrix_packed_reposition_blocks(&packed, 0xF);
+    });
+    matrix_bench_report("reposition_blocks (tetris)", row_ns, packed_ns);
+
+    // Worst case compaction: 1 to 4 cleared rows under a stack reaching the top row, contiguous at the
+    // bottom then every other row so each gap moves a different number of rows
+    printf("\nreposition_blocks under a full height stack\n");
+    for (int split = 0; split < 2; split++) {
+        for (int lines = 1; lines <= 4; lines++) {
+            uint32_t line_clear = 0;
+            char name[40];
+
+            for (int n = 0; n < lines; n++) {
+                line_clear |= 1UL << (n * (split + 1));
+            }
+            matrix_init(&saved);
+            matrix_bench_fill_stack(&saved, 0, PLAYING_FIELD_HEIGHT);
+            for (int row = 0; row < PLAYING_FIELD_HEIGHT; row++) {
+                if (line_clear & (1UL << row)) {
+                    saved.stack[row] = 0;
+                    for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+                        saved.palette[plane][row] = 0;
+                    }
+                }
+            }
+            matrix_surface_recompute(&saved);
+            matrix_hash_recompute(&saved);
+            matrix_packed_from_matrix(&packed_saved, &saved);
+
+            MATRIX_BENCH_TIME(row_ns, iterations / 10 + 1, {
+                memcpy(&matrix, &saved, sizeof(matrix_t));
+                matrix_bench_sink += matrix_reposition_blocks(&matrix, line_clear);
+            });
+            MATRIX_BENCH_TIME(packed_ns, iterations / 10 + 1, {
+                memcpy(&packed, &packed_saved, sizeof(matrix_packed_t));
+                matrix_bench_sink += matrix_packed_reposition_blocks(&packed, line_clear);
+            });
+            snprintf(name, sizeof(name), "%d line%s %s", lines, lines > 1 ? "s" : "",
+                    split ? "every other row" : "at the bottom");
+            matrix_bench_report(name, row_ns, packed_ns);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
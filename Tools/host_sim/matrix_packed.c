@@ -0,0 +1,354 @@
+/**
+ ******************************************************************************
+ * @file           : matrix_packed.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Previous matrix_t layout, two rows per uint32_t, kept as a benchmark reference
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+/*
+ * The matrix operations as they were before matrix_t stored one row per matrix_row_t: even rows in the
+ * low half of a uint32_t, odd rows in the high half. The bodies are the old ones with the copies into
+ * temporary matrices kept, so matrix_bench measures what the firmware used to run. Only the operations
+ * matrix_bench compares are here, the line clear animation without its timer.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "matrix_packed.h"
+#include "tetrimino_shape.h"
+
+//@formatter:off
+static const uint16_t line_clear_mask[] = {
+    0b0000000000000000,  // 0x0000
+    0b0001000000001000, // 0x1008
+    0b0001100000011000, // 0x1818
+    0b0001110000111000, // 0x1C38
+    0b0001111001111000 // 0x1E78
+};
+//@formatter:on
+
+/**
+ * @brief  Reset the playfield to the boundary bitmap
+ * @param  matrix
+ * @retval None
+ */
+static void matrix_packed_reset_playfield(matrix_packed_t *matrix) {
+    for (int i = 0; i < MATRIX_PACKED_DATA_SIZE; i++) {
+        matrix->playfield[i] = MATRIX_PACKED_BOUNDARY_BITMAP;
+    }
+}
+
+/**
+ * @brief  Initialize an empty packed matrix
+ * @param  matrix
+ * @retval None
+ */
+void matrix_packed_init(matrix_packed_t *matrix) {
+    memset(matrix, 0, sizeof(matrix_packed_t));
+    matrix_packed_reset_playfield(matrix);
+}
+
+/**
+ * @brief  Pack the stack of a matrix, palette planes 0 and 1 stand in for the two old palettes
+ * @param  packed matrix (output), matrix
+ * @retval None
+ */
+void matrix_packed_from_matrix(matrix_packed_t *packed, matrix_t *matrix) {
+    matrix_packed_init(packed);
+    for (int row = 0; row < PLAYING_FIELD_HEIGHT; row++) {
+        packed->stack[row / 2] |= (uint32_t) matrix->stack[row] << (16 * (row % 2));
+        packed->palette1[row / 2] |= (uint32_t) matrix->palette[0][row] << (16 * (row % 2));
+        packed->palette2[row / 2] |= (uint32_t) matrix->palette[1][row] << (16 * (row % 2));
+    }
+}
+
+/**
+ * @brief  Draw a tetrimino on the playfield
+ * @param  matrix, tetrimino
+ * @retval MATRIX_REFRESH, MATRIX_OUT_OF_BOUNDS, MATRIX_REACHED_BOTTOM or MATRIX_WALL_COLLISION
+ */
+matrix_status_t matrix_packed_add_tetrimino(matrix_packed_t *matrix, tetrimino_t *tetrimino) {
+    uint8_t shape_offset = 0;
+    uint16_t row_bitmap = 0;
+    uint32_t working_playfield = 0;
+    uint32_t temp_playfield[MATRIX_PACKED_DATA_SIZE];
+    uint8_t row_index = 0;
+
+    matrix_packed_reset_playfield(matrix);
+
+    memset(temp_playfield, 0, sizeof(temp_playfield));
+    for (int i = 0; i < MATRIX_PACKED_DATA_SIZE; i++) {
+        temp_playfield[i] = matrix->playfield[i];
+    }
+
+    if (tetrimino->y >= PLAYING_FIELD_HEIGHT + TETRIMINO_CENTER_Y) {
+        return MATRIX_OUT_OF_BOUNDS;
+    }
+    if (tetrimino->y >= PLAYING_FIELD_HEIGHT && tetrimino->x > PLAYING_FIELD_WIDTH - TETRIMINO_CENTER_X) {
+        return MATRIX_OUT_OF_BOUNDS;
+    }
+    if (tetrimino->y >= PLAYING_FIELD_HEIGHT && tetrimino->x < TETRIMINO_CENTER_X) {
+        return MATRIX_OUT_OF_BOUNDS;
+    }
+
+    shape_offset = tetrimino->shape_offset;
+    row_index = tetrimino->y + TETRIMINO_CENTER_Y;
+    for (int i = 0; i < TETRIMINO_BLOCK_SIZE; i++) {
+        if (tetrimino_shape[shape_offset + i] && row_index >= PLAYING_FIELD_HEIGHT + 10) {
+            return MATRIX_REACHED_BOTTOM;
+        }
+        row_index--;
+    }
+
+    row_index = tetrimino->y + TETRIMINO_CENTER_Y;
+    for (int i = 0; i < TETRIMINO_BLOCK_SIZE; i++) {
+        if (row_index >= PLAYING_FIELD_HEIGHT) {
+            row_index--;
+            continue;
+        }
+
+        working_playfield = temp_playfield[row_index >> 1];
+
+        row_bitmap = (uint16_t) tetrimino_shape[shape_offset + i];
+        row_bitmap = row_bitmap << 3;
+        if (tetrimino->x >= PLAYING_FIELD_WIDTH - TETRIMINO_CENTER_X) {
+            row_bitmap = row_bitmap >> (tetrimino->x - PLAYING_FIELD_WIDTH + TETRIMINO_CENTER_X + 1);
+        } else {
+            row_bitmap = row_bitmap << (PLAYING_FIELD_WIDTH - (tetrimino->x + TETRIMINO_CENTER_X) - 1);
+        }
+
+        if (row_index % 2) {
+            if (working_playfield & (row_bitmap << 16)) {
+                return MATRIX_WALL_COLLISION;
+            }
+            working_playfield |= row_bitmap << 16;
+        } else {
+            if (working_playfield & row_bitmap) {
+                return MATRIX_WALL_COLLISION;
+            }
+            working_playfield |= row_bitmap;
+        }
+        temp_playfield[row_index >> 1] = working_playfield;
+        row_index--;
+    }
+
+    for (int i = 0; i < MATRIX_PACKED_DATA_SIZE; i++) {
+        matrix->playfield[i] = temp_playfield[i];
+    }
+
+    return MATRIX_REFRESH;
+}
+
+/**
+ * @brief  Check the playfield against the stack
+ * @param  matrix
+ * @retval MATRIX_STACK_COLLISION or MATRIX_OK
+ */
+matrix_status_t matrix_packed_check_collision(matrix_packed_t *matrix) {
+    for (int row_index = 0; row_index < PLAYING_FIELD_HEIGHT / 2; row_index++) {
+        if (matrix->stack[row_index] & matrix->playfield[row_index]) {
+            return MATRIX_STACK_COLLISION;
+        }
+    }
+    return MATRIX_OK;
+}
+
+/**
+ * @brief  Find the full rows
+ * @param  matrix
+ * @retval Bitmap of the full rows
+ */
+uint32_t matrix_packed_check_line_clear(matrix_packed_t *matrix) {
+    uint32_t stack;
+    uint32_t line_clear = 0;
+
+    for (int row = 0; row < PLAYING_FIELD_HEIGHT; row++) {
+        stack = matrix->stack[row / 2];
+        if (row % 2 == 0) {
+            if ((stack & MATRIX_PACKED_FILLED_ROW_MASK) == MATRIX_PACKED_FILLED_ROW_MASK) {
+                line_clear |= (1 << row);
+            }
+        } else {
+            stack = stack >> 16;
+            if ((stack & MATRIX_PACKED_FILLED_ROW_MASK) == MATRIX_PACKED_FILLED_ROW_MASK) {
+                line_clear |= (1 << row);
+            }
+        }
+    }
+    return line_clear;
+}
+
+/**
+ * @brief  One frame of the line clear animation
+ * @param  matrix, line_clear bitmap, frame number (CLEAR_LINE_NUM_FRAMES - 1 down to 0)
+ * @retval None
+ */
+void matrix_packed_line_clear_frame(matrix_packed_t *matrix, uint32_t line_clear, uint8_t frame_nbr) {
+    uint32_t working_stack_row;
+    uint32_t working_stack_mask;
+    uint32_t working_palette1_row;
+    uint32_t working_palette2_row;
+
+    for (int i = 0; i < PLAYING_FIELD_HEIGHT; i++) {
+        working_stack_row = matrix->stack[i / 2];
+        working_palette1_row = matrix->palette1[i / 2];
+        working_palette2_row = matrix->palette2[i / 2];
+        if (line_clear & (1 << i)) {
+            if (i % 2 == 0) {
+                working_stack_mask = 0xFFFF0000 | line_clear_mask[frame_nbr];
+            } else {
+                working_stack_mask = line_clear_mask[frame_nbr] << 16 | 0xFFFF;
+            }
+            working_stack_row &= working_stack_mask;
+            working_palette1_row &= working_stack_mask;
+            working_palette2_row &= working_stack_mask;
+            matrix->stack[i / 2] = working_stack_row;
+            matrix->palette1[i / 2] = working_palette1_row;
+            matrix->palette2[i / 2] = working_palette2_row;
+        }
+    }
+}
+
+/**
+ * @brief  Merge the tetrimino on the playfield into the stack
+ * @param  matrix, tetrimino
+ * @retval MATRIX_OK
+ */
+matrix_status_t matrix_packed_merge_with_stack(matrix_packed_t *matrix, tetrimino_t *tetrimino) {
+    matrix_packed_t temp;
+    int shape_id_index = tetrimino->piece % 3;
+
+    memcpy(&temp, matrix, sizeof(matrix_packed_t));
+    for (int i = 0; i < PLAYING_FIELD_HEIGHT / 2; i++) {
+        temp.stack[i] = matrix->stack[i] | (matrix->playfield[i] & MATRIX_PACKED_MASK);
+        if (shape_id_index == 1) {
+            temp.palette1[i] = matrix->palette1[i] | (matrix->playfield[i] & MATRIX_PACKED_MASK);
+        }
+        if (shape_id_index == 2) {
+            temp.palette2[i] = matrix->palette2[i] | (matrix->playfield[i] & MATRIX_PACKED_MASK);
+        }
+    }
+    memcpy(matrix, &temp, sizeof(matrix_packed_t));
+    return MATRIX_OK;
+}
+
+/**
+ * @brief  Find the empty rows
+ * @param  matrix
+ * @retval Bitmap of the empty rows
+ */
+static uint32_t matrix_packed_find_empty_row(matrix_packed_t *matrix) {
+    uint32_t empty_bitmap = 0;
+    uint32_t stack_row;
+
+    for (int row = 0; row < PLAYING_FIELD_HEIGHT; row++) {
+        stack_row = matrix->stack[row / 2] & MATRIX_PACKED_MASK_BOUNDARY;
+        if (row % 2 == 0) {
+            if ((stack_row & 0x0000FFFF) == 0) {
+                empty_bitmap |= (1 << row);
+            }
+        } else {
+            if ((stack_row & 0xFFFF0000) == 0) {
+                empty_bitmap |= (1 << row);
+            }
+        }
+    }
+
+    return empty_bitmap;
+}
+
+/**
+ * @brief  Drop the rows above the cleared ones, one row per pass until no empty row is under a block
+ * @param  matrix, line_clear bitmap
+ * @retval MATRIX_REFRESH
+ */
+matrix_status_t matrix_packed_reposition_blocks(matrix_packed_t *matrix, uint32_t line_clear) {
+    matrix_packed_t temp_matrix;
+    uint32_t bitmap = line_clear;
+    uint32_t carry, lsb, msb;
+    uint8_t done = 0, occupied_bitmap = 0, skip_front_row = 0, row_index = 0;
+
+    memcpy(&temp_matrix, matrix, sizeof(matrix_packed_t));
+
+    while (!done) {
+        carry = 0;
+        for (int i = MATRIX_PACKED_DATA_SIZE - 1; i >= 0; i--) {
+            lsb = matrix->stack[i] & 0x0000FFFF;
+            msb = matrix->stack[i] & 0xFFFF0000;
+            temp_matrix.stack[i] = (msb >> 16) | carry;
+            carry = lsb << 16;
+        }
+        carry = 0;
+        for (int i = MATRIX_PACKED_DATA_SIZE - 1; i >= 0; i--) {
+            lsb = matrix->palette1[i] & 0x0000FFFF;
+            msb = matrix->palette1[i] & 0xFFFF0000;
+            temp_matrix.palette1[i] = (msb >> 16) | carry;
+            carry = lsb << 16;
+        }
+        carry = 0;
+        for (int i = MATRIX_PACKED_DATA_SIZE - 1; i >= 0; i--) {
+            lsb = matrix->palette2[i] & 0x0000FFFF;
+            msb = matrix->palette2[i] & 0xFFFF0000;
+            temp_matrix.palette2[i] = (msb >> 16) | carry;
+            carry = lsb << 16;
+        }
+
+        // Keep the rows below the first cleared row
+        skip_front_row = 1;
+        for (int i = 0; i < PLAYING_FIELD_HEIGHT; i++) {
+            row_index = i / 2;
+            if (!(bitmap & (1 << i))) {
+                skip_front_row = 0;
+                if (i % 2 == 0) {
+                    temp_matrix.stack[row_index] = (temp_matrix.stack[row_index] & 0xFFFF0000)
+                            | (matrix->stack[row_index] & 0x0000FFFF);
+                    temp_matrix.palette1[row_index] = (temp_matrix.palette1[row_index] & 0xFFFF0000)
+                            | (matrix->palette1[row_index] & 0x0000FFFF);
+                    temp_matrix.palette2[row_index] = (temp_matrix.palette2[row_index] & 0xFFFF0000)
+                            | (matrix->palette2[row_index] & 0x0000FFFF);
+                } else {
+                    temp_matrix.stack[row_index] = (temp_matrix.stack[row_index] & 0x0000FFFF)
+                            | (matrix->stack[row_index] & 0xFFFF0000);
+                    temp_matrix.palette1[row_index] = (temp_matrix.palette1[row_index] & 0x0000FFFF)
+                            | (matrix->palette1[row_index] & 0xFFFF0000);
+                    temp_matrix.palette2[row_index] = (temp_matrix.palette2[row_index] & 0x0000FFFF)
+                            | (matrix->palette2[row_index] & 0xFFFF0000);
+                }
+            } else if (skip_front_row || (!skip_front_row && (bitmap & (1 << i)))) {
+                break;
+            }
+        }
+
+        memcpy(matrix, &temp_matrix, sizeof(matrix_packed_t));
+
+        // Done when no empty row is left under an occupied one
+        bitmap = matrix_packed_find_empty_row(matrix);
+        occupied_bitmap = 0;
+        done = 1;
+        for (int i = 0; i < PLAYING_FIELD_HEIGHT; i++) {
+            if (bitmap & (1 << i)) {
+                occupied_bitmap = 1;
+            }
+            if (occupied_bitmap && !(bitmap & (1 << i))) {
+                done = 0;
+                break;
+            }
+        }
+    }
+
+    return MATRIX_REFRESH;
+}
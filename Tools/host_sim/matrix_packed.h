@@ -0,0 +1,55 @@
+/**
+ ******************************************************************************
+ * @file           : matrix_packed.h
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Previous matrix_t layout, two rows per uint32_t, kept as a benchmark reference
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef MATRIX_PACKED_H_
+#define MATRIX_PACKED_H_
+
+#include <stdint.h>
+#include "matrix.h"
+#include "tetrimino.h"
+
+// Masks of the packed layout, they hard-code a 10 wide playfield with the boundary at bit 3
+#define MATRIX_PACKED_BOUNDARY_BITMAP (0xE007E007)
+#define MATRIX_PACKED_MASK (0x1FF81FF8)
+#define MATRIX_PACKED_MASK_BOUNDARY (0x3FFC3FFC)
+#define MATRIX_PACKED_FILLED_ROW_MASK (0x1FF8)
+#define MATRIX_PACKED_DATA_SIZE (PLAYING_FIELD_HEIGHT >> 1)
+
+_Static_assert(PLAYING_FIELD_WIDTH == 10 && PLAYING_FIELD_BOUNDARY_WIDTH == 3 && PLAYING_FIELD_HEIGHT % 2 == 0,
+        "the packed layout only exists for the 10 wide board with an even number of rows");
+
+typedef struct {
+    uint32_t playfield[MATRIX_PACKED_DATA_SIZE];
+    uint32_t stack[MATRIX_PACKED_DATA_SIZE];
+    uint32_t palette1[MATRIX_PACKED_DATA_SIZE];
+    uint32_t palette2[MATRIX_PACKED_DATA_SIZE];
+} matrix_packed_t;
+
+void matrix_packed_init(matrix_packed_t *matrix);
+void matrix_packed_from_matrix(matrix_packed_t *packed, matrix_t *matrix);
+matrix_status_t matrix_packed_add_tetrimino(matrix_packed_t *matrix, tetrimino_t *tetrimino);
+matrix_status_t matrix_packed_check_collision(matrix_packed_t *matrix);
+uint32_t matrix_packed_check_line_clear(matrix_packed_t *matrix);
+void matrix_packed_line_clear_frame(matrix_packed_t *matrix, uint32_t line_clear, uint8_t frame_nbr);
+matrix_status_t matrix_packed_merge_with_stack(matrix_packed_t *matrix, tetrimino_t *tetrimino);
+matrix_status_t matrix_packed_reposition_blocks(matrix_packed_t *matrix, uint32_t line_clear);
+
+#endif /* MATRIX_PACKED_H_ */
@@ -0,0 +1,485 @@
+/**
+ ******************************************************************************
+ * @file           : matrix_test.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Host test of the incrementally maintained matrix state against a recompute
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+
+/*
+ * Plays random moves on matrix.c, shifts, rotations with both rotation systems, soft drops, hard drops,
+ * drops on the lowest landing spot so rows fill up, and the odd garbage rise, and locks, clears and
+ * compacts like tetris_engine.c. After every change of the stack the surface kept by the matrix functions
+ * is compared with matrix_surface_recompute and the stack hash with matrix_hash_recompute, also after each
+ * line clear animation frame. The drop distance from the surface is compared with stepping the piece down
+ * one row at a time. After every lock and line clear the stack goes through matrix_serialize and
+ * matrix_deserialize and must come back the same. Before the moves, stacks with runs of empty rows and a
+ * full-height stack also go through both, and every stack text or bit stream rejected by
+ * matrix_deserialize_text or matrix_deserialize must leave an empty stack.
+ *
+ * Exits with a failure on the first mismatch. Build and run with make check in this directory, or e.g.
+ * ./matrix_test -n 10000000 -s 7
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "main.h"
+#include "matrix.h"
+#include "tetrimino.h"
+#include "tetrimino_shape.h"
+
+#define MATRIX_TEST_DEFAULT_MOVES (2000000)
+
+typedef enum {
+    MATRIX_TEST_MOVE_LEFT = 0,
+    MATRIX_TEST_MOVE_RIGHT,
+    MATRIX_TEST_MOVE_CW,
+    MATRIX_TEST_MOVE_CCW,
+    MATRIX_TEST_MOVE_DOWN,
+    MATRIX_TEST_MOVE_HARD_DROP,
+    MATRIX_TEST_MOVE_PLACE_LOW,
+    MATRIX_TEST_MOVE_GARBAGE,
+    MATRIX_TEST_MOVE_COUNT
+} matrix_test_move_t;
+
+typedef struct {
+    uint64_t moves;
+    uint64_t locks;
+    uint64_t line_clears;
+    uint64_t garbage_rows;
+    uint64_t top_outs;
+    uint64_t surface_checks;
+    uint64_t hash_checks;
+    uint64_t drop_checks;
+    uint64_t serialize_checks;
+} matrix_test_stats_t;
+
+// Relative frequency of each move, most pieces are shifted and turned a few times before they lock
+static const uint8_t matrix_test_move_weight[MATRIX_TEST_MOVE_COUNT] = { 4, 4, 3, 3, 4, 1, 2, 0 };
+
+static matrix_test_stats_t matrix_test_stats;
+
+/**
+ * @brief  Print the stack and stop the test on a mismatch
+ * @param  matrix, what was checked, where in the game
+ * @retval None
+ */
+static void matrix_test_fail(matrix_t *matrix, const char *check, const char *where) {
+    char text[MATRIX_TEXT_MAX_SIZE];
+
+    matrix_serialize_text(matrix, text, sizeof(text));
+    fprintf(stderr, "%s mismatch after %s, move %llu\nstack: \"%s\"\n", check, where,
+            (unsigned long long) matrix_test_stats.moves, text);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief  Compare the surface kept by the matrix functions with a recompute from the stack
+ * @param  matrix, where in the game
+ * @retval None
+ */
+static void matrix_test_check_surface(matrix_t *matrix, const char *where) {
+    matrix_t recomputed;
+
+    memcpy(&recomputed, matrix, sizeof(matrix_t));
+    matrix_surface_recompute(&recomputed);
+    if (memcmp(&recomputed.surface, &matrix->surface, sizeof(matrix_surface_t))) {
+        fprintf(stderr, "kept: max %u blocks %u holes %u, recomputed: max %u blocks %u holes %u\n",
+                matrix->surface.max_height, matrix->surface.block_count, matrix->surface.hole_count,
+                recomputed.surface.max_height, recomputed.surface.block_count, recomputed.surface.hole_count);
+        matrix_test_fail(matrix, "surface", where);
+    }
+    matrix_test_stats.surface_checks++;
+}
+
+/**
+ * @brief  Compare the stack hash kept by the matrix functions with a recompute from the stack
+ * @param  matrix, where in the game
+ * @retval None
+ */
+static void matrix_test_check_hash(matrix_t *matrix, const char *where) {
+    matrix_t recomputed;
+
+    memcpy(&recomputed, matrix, sizeof(matrix_t));
+    matrix_hash_recompute(&recomputed);
+    if (recomputed.stack_hash != matrix->stack_hash) {
+        fprintf(stderr, "kept hash %08lx, recomputed %08lx\n", (unsigned long) matrix->stack_hash,
+                (unsigned long) recomputed.stack_hash);
+        matrix_test_fail(matrix, "stack hash", where);
+    }
+    matrix_test_stats.hash_checks++;
+}
+
+/**
+ * @brief  Serialize the stack, load it into another matrix and compare, a stream one byte short must fail
+ * @param  matrix, where in the game
+ * @retval None
+ */
+static void matrix_test_check_serialize(matrix_t *matrix, const char *where) {
+    static matrix_t loaded;
+    uint8_t buffer[MATRIX_SERIALIZED_MAX_SIZE];
+    uint16_t length;
+
+    length = matrix_serialize(matrix, buffer, sizeof(buffer));
+    if (length == 0 || matrix_serialize(matrix, buffer, length - 1) != 0) {
+        matrix_test_fail(matrix, "serialized length", where);
+    }
+    matrix_init(&loaded);
+    if (matrix_deserialize(&loaded, buffer, length) != MATRIX_OK) {
+        matrix_test_fail(matrix, "deserialize status", where);
+    }
+    for (int row = 0; row < PLAYING_FIELD_HEIGHT; row++) {
+        if (loaded.stack[row] != (matrix->stack[row] & PLAYING_FIELD_MASK)) {
+            matrix_test_fail(matrix, "deserialized stack", where);
+        }
+        for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+            if (loaded.palette[plane][row] != (matrix->palette[plane][row] & matrix->stack[row] & PLAYING_FIELD_MASK)) {
+                matrix_test_fail(matrix, "deserialized palette", where);
+            }
+        }
+    }
+    if (memcmp(&loaded.surface, &matrix->surface, sizeof(matrix_surface_t))) {
+        matrix_test_fail(matrix, "deserialized surface", where);
+    }
+    if (loaded.stack_hash != matrix->stack_hash) {
+        matrix_test_fail(matrix, "deserialized stack hash", where);
+    }
+
+    // The last byte always holds bits of the top row
+    if (length > 1 && matrix_deserialize(&loaded, buffer, length - 1) != MATRIX_ERROR) {
+        matrix_test_fail(matrix, "truncated stream status", where);
+    }
+    matrix_test_stats.serialize_checks++;
+}
+
+/**
+ * @brief  Compare the drop distance from the surface with stepping the piece down
+ * @param  matrix, tetrimino
+ * @retval None
+ */
+static void matrix_test_check_drop(matrix_t *matrix, tetrimino_t *tetrimino) {
+    uint8_t distance = 0;
+
+    while (matrix_piece_fits(matrix, tetrimino->piece, tetrimino->rotation, tetrimino->x,
+            tetrimino->y - distance - 1) == MATRIX_OK) {
+        distance++;
+    }
+    if (matrix_drop_distance(matrix, tetrimino) != distance) {
+        fprintf(stderr, "piece %d rotation %d at %d,%d: drop distance %u, stepping %u\n", tetrimino->piece,
+                tetrimino->rotation, tetrimino->x, tetrimino->y, matrix_drop_distance(matrix, tetrimino), distance);
+        matrix_test_fail(matrix, "drop distance", "a move");
+    }
+    matrix_test_stats.drop_checks++;
+}
+
+/**
+ * @brief  Pick a random move, a garbage rise once every 64 moves on average
+ * @param  None
+ * @retval Move
+ */
+static matrix_test_move_t matrix_test_random_move(void) {
+    int total = 0;
+    int pick;
+
+    if (rand() % 64 == 0) {
+        return MATRIX_TEST_MOVE_GARBAGE;
+    }
+    for (int move = 0; move < MATRIX_TEST_MOVE_COUNT; move++) {
+        total += matrix_test_move_weight[move];
+    }
+    pick = rand() % total;
+    for (int move = 0; move < MATRIX_TEST_MOVE_COUNT; move++) {
+        if (pick < matrix_test_move_weight[move]) {
+            return (matrix_test_move_t) move;
+        }
+        pick -= matrix_test_move_weight[move];
+    }
+    return MATRIX_TEST_MOVE_DOWN;
+}
+
+/**
+ * @brief  Spawn a random piece, start a new game if it does not fit
+ * @param  matrix, tetrimino
+ * @retval None
+ */
+static void matrix_test_spawn(matrix_t *matrix, tetrimino_t *tetrimino) {
+    tetrimino_spawn_piece(tetrimino, rand() % TETRIMINO_COUNT);
+    if (matrix_piece_fits(matrix, tetrimino->piece, tetrimino->rotation, tetrimino->x, tetrimino->y)
+            != MATRIX_OK) {
+        matrix_test_stats.top_outs++;
+        matrix_init(matrix);
+        matrix_test_check_surface(matrix, "a top out");
+        matrix_test_check_hash(matrix, "a top out");
+    }
+    matrix_add_tetrimino(matrix, tetrimino);
+}
+
+/**
+ * @brief  Lock the piece, then clear and compact the full rows like tetris_engine.c
+ * @param  matrix, tetrimino
+ * @retval None
+ */
+static void matrix_test_lock(matrix_t *matrix, tetrimino_t *tetrimino) {
+    uint32_t line_clear;
+    uint8_t lines;
+
+    matrix_add_tetrimino(matrix, tetrimino);
+    merge_with_stack(matrix, tetrimino);
+    matrix_reset_playfield(matrix);
+    matrix_test_stats.locks++;
+    matrix_test_check_surface(matrix, "a lock");
+    matrix_test_check_hash(matrix, "a lock");
+    matrix_test_check_serialize(matrix, "a lock");
+
+    line_clear = matrix_check_tetrimino_line_clear(matrix, tetrimino, &lines);
+    if (line_clear != matrix_check_line_clear(matrix)) {
+        matrix_test_fail(matrix, "line clear", "a lock");
+    }
+    if (line_clear) {
+        matrix_line_clear_start(matrix, CLEAR_LINE_DELAY_FRAMES);
+        while (!matrix_line_clear_animate(matrix, line_clear, 1 + rand() % CLEAR_LINE_DELAY_FRAMES)) {
+            matrix_test_check_hash(matrix, "a line clear frame");
+        }
+        matrix_test_check_hash(matrix, "the last line clear frame");
+        matrix_reposition_blocks(matrix, line_clear);
+        matrix_test_stats.line_clears++;
+        matrix_test_check_surface(matrix, "a line clear");
+        matrix_test_check_hash(matrix, "a line clear");
+        matrix_test_check_serialize(matrix, "a line clear");
+    }
+    matrix_test_spawn(matrix, tetrimino);
+}
+
+/**
+ * @brief  Move the piece over its lowest landing spot, stepping down from the spawn row
+ * @param  matrix, tetrimino
+ * @retval None
+ */
+static void matrix_test_place_low(matrix_t *matrix, tetrimino_t *tetrimino) {
+    tetrimino_t candidate = *tetrimino;
+    int best_y = PLAYING_FIELD_HEIGHT + TETRIMINO_CENTER_Y;
+
+    for (int rotation = 0; rotation < TETRIMINO_ROTATION_COUNT; rotation++) {
+        for (int x = 0; x < PLAYING_FIELD_WIDTH; x++) {
+            candidate.rotation = rotation;
+            candidate.x = x;
+            candidate.y = tetrimino->y;
+            if (matrix_piece_fits(matrix, candidate.piece, candidate.rotation, candidate.x, candidate.y)
+                    != MATRIX_OK) {
+                continue;
+            }
+            while (matrix_piece_fits(matrix, candidate.piece, candidate.rotation, candidate.x, candidate.y - 1)
+                    == MATRIX_OK) {
+                candidate.y--;
+            }
+            // Ties broken at random so the stack does not lean to one side
+            if (candidate.y < best_y || (candidate.y == best_y && rand() % 2)) {
+                best_y = candidate.y;
+                tetrimino->rotation = candidate.rotation;
+                tetrimino->x = candidate.x;
+            }
+        }
+    }
+    if (best_y < PLAYING_FIELD_HEIGHT + TETRIMINO_CENTER_Y) {
+        tetrimino->y = best_y;
+        tetrimino->shape_offset = tetrimino_shape_offset_lut[tetrimino->piece][tetrimino->rotation];
+    }
+}
+
+/**
+ * @brief  Check that a rejected stack text or bit stream left an empty stack
+ * @param  matrix, what was loaded
+ * @retval None
+ */
+static void matrix_test_check_empty(matrix_t *matrix, const char *where) {
+    if (matrix->surface.block_count || matrix->stack_hash || matrix_check_line_clear(matrix)) {
+        matrix_test_fail(matrix, "rejected load stack", where);
+    }
+    for (int row = 0; row < PLAYING_FIELD_HEIGHT; row++) {
+        if (matrix->stack[row]) {
+            matrix_test_fail(matrix, "rejected load stack", where);
+        }
+    }
+}
+
+/**
+ * @brief  Check that every rejected text leaves an empty stack, whatever the stack held before
+ * @param  matrix
+ * @retval None
+ */
+static void matrix_test_check_text_errors(matrix_t *matrix) {
+    char text[MATRIX_TEXT_MAX_SIZE + PLAYING_FIELD_WIDTH + 1];
+    const char *bad_text[] = { "T..........", "T.X", text };
+    int length = 0;
+
+    // One row more than the playfield
+    for (int row = 0; row <= PLAYING_FIELD_HEIGHT; row++) {
+        length += sprintf(text + length, row ? "/G........." : "G.........");
+    }
+
+    for (size_t i = 0; i < sizeof(bad_text) / sizeof(bad_text[0]); i++) {
+        matrix_deserialize_text(matrix, "TTT.IIII../GGGGGGGGG.");
+        if (matrix_deserialize_text(matrix, bad_text[i]) != MATRIX_ERROR) {
+            matrix_test_fail(matrix, "text error status", bad_text[i]);
+        }
+        matrix_test_check_empty(matrix, bad_text[i]);
+    }
+}
+
+/**
+ * @brief  Round trip stacks with runs of empty rows, a full-height stack and an empty one through the bit
+ *         stream, then check that every rejected stream leaves an empty stack
+ * @param  matrix
+ * @retval None
+ */
+static void matrix_test_check_stream(matrix_t *matrix) {
+    char text[MATRIX_TEXT_MAX_SIZE];
+    uint8_t buffer[MATRIX_SERIALIZED_MAX_SIZE + 1];
+    const char *stacks[] = { "", "T.........", "I........./........../........../..........",
+            "L........./........../OO......../........../........../ZZSS.JJ..G", text };
+    int length = 0;
+    uint16_t size;
+
+    // Every row full but one cell, each with all the colors
+    for (int row = 0; row < PLAYING_FIELD_HEIGHT; row++) {
+        if (row) {
+            text[length++] = MATRIX_TEXT_ROW_SEPARATOR;
+        }
+        for (int column = 0; column < PLAYING_FIELD_WIDTH; column++) {
+            text[length++] = column == row % PLAYING_FIELD_WIDTH ? '.' : "TJZOSLIG"[(row + column) % 8];
+        }
+    }
+    text[length] = '\0';
+
+    for (size_t i = 0; i < sizeof(stacks) / sizeof(stacks[0]); i++) {
+        if (matrix_deserialize_text(matrix, stacks[i]) != MATRIX_OK) {
+            matrix_test_fail(matrix, "stack text", stacks[i]);
+        }
+        matrix_test_check_serialize(matrix, stacks[i]);
+    }
+
+    // The full-height stack cut short, with no bytes, and with one row more than the playfield
+    size = matrix_serialize(matrix, buffer, sizeof(buffer));
+    for (uint16_t cut = 1; cut < size; cut += 7) {
+        matrix_deserialize_text(matrix, stacks[3]);
+        if (matrix_deserialize(matrix, buffer, cut) != MATRIX_ERROR) {
+            matrix_test_fail(matrix, "truncated stream status", "a full-height stack");
+        }
+        matrix_test_check_empty(matrix, "a truncated stream");
+    }
+    matrix_deserialize_text(matrix, stacks[3]);
+    if (matrix_deserialize(matrix, buffer, 0) != MATRIX_ERROR) {
+        matrix_test_fail(matrix, "empty stream status", "an empty buffer");
+    }
+    matrix_test_check_empty(matrix, "an empty buffer");
+    buffer[0] = PLAYING_FIELD_HEIGHT + 1;
+    buffer[size] = 0xFF; // empty row flags, enough bits for the extra row
+    matrix_deserialize_text(matrix, stacks[3]);
+    if (matrix_deserialize(matrix, buffer, size + 1) != MATRIX_ERROR) {
+        matrix_test_fail(matrix, "tall stream status", "a stream of too many rows");
+    }
+    matrix_test_check_empty(matrix, "a stream of too many rows");
+}
+
+int main(int argc, char *argv[]) {
+    static matrix_t matrix;
+    tetrimino_t tetrimino;
+    uint64_t moves = MATRIX_TEST_DEFAULT_MOVES;
+    unsigned int seed = 1;
+    tetrimino_rotation_system_t rotation_system;
+    matrix_status_t matrix_status;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+        case 'n':
+            moves = strtoull(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n moves] [-s seed]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    srand(seed);
+    matrix_init(&matrix);
+    matrix_test_check_text_errors(&matrix);
+    matrix_test_check_stream(&matrix);
+    matrix_init(&matrix);
+    matrix_test_spawn(&matrix, &tetrimino);
+
+    for (matrix_test_stats.moves = 0; matrix_test_stats.moves < moves; matrix_test_stats.moves++) {
+        rotation_system = rand() % 2 ? TETRIMINO_ROTATION_SYSTEM_SRS : TETRIMINO_ROTATION_SYSTEM_NES;
+        matrix_test_check_drop(&matrix, &tetrimino);
+
+        switch (matrix_test_random_move()) {
+        case MATRIX_TEST_MOVE_LEFT:
+            matrix_move_tetrimino(&matrix, &tetrimino, MOVE_LEFT);
+            break;
+        case MATRIX_TEST_MOVE_RIGHT:
+            matrix_move_tetrimino(&matrix, &tetrimino, MOVE_RIGHT);
+            break;
+        case MATRIX_TEST_MOVE_CW:
+            matrix_rotate_tetrimino(&matrix, &tetrimino, ROTATE_CW, rotation_system);
+            break;
+        case MATRIX_TEST_MOVE_CCW:
+            matrix_rotate_tetrimino(&matrix, &tetrimino, ROTATE_CCW, rotation_system);
+            break;
+        case MATRIX_TEST_MOVE_DOWN:
+            if (matrix_move_tetrimino(&matrix, &tetrimino, MOVE_DOWN) == MATRIX_NO_CHANGE) {
+                matrix_test_lock(&matrix, &tetrimino);
+            }
+            break;
+        case MATRIX_TEST_MOVE_HARD_DROP:
+            tetrimino.y -= matrix_drop_distance(&matrix, &tetrimino);
+            matrix_test_lock(&matrix, &tetrimino);
+            break;
+        case MATRIX_TEST_MOVE_PLACE_LOW:
+            matrix_test_place_low(&matrix, &tetrimino);
+            matrix_test_lock(&matrix, &tetrimino);
+            break;
+        case MATRIX_TEST_MOVE_GARBAGE:
+        default:
+            matrix_status = matrix_add_garbage(&matrix, &tetrimino, 1 + rand() % 2, rand() % PLAYING_FIELD_WIDTH);
+            matrix_test_stats.garbage_rows++;
+            matrix_test_check_surface(&matrix, "a garbage row");
+            matrix_test_check_hash(&matrix, "a garbage row");
+            if (matrix_status == MATRIX_OUT_OF_BOUNDS || matrix_status == MATRIX_STACK_COLLISION) {
+                matrix_test_stats.top_outs++;
+                matrix_init(&matrix);
+                matrix_test_spawn(&matrix, &tetrimino);
+            }
+            break;
+        }
+    }
+
+    printf("%llu moves, %llu locks, %llu line clears, %llu garbage rises, %llu top outs\n",
+            (unsigned long long) matrix_test_stats.moves, (unsigned long long) matrix_test_stats.locks,
+            (unsigned long long) matrix_test_stats.line_clears, (unsigned long long) matrix_test_stats.garbage_rows,
+            (unsigned long long) matrix_test_stats.top_outs);
+    printf("%llu surface checks, %llu hash checks, %llu drop distance checks, %llu serialize checks passed\n",
+            (unsigned long long) matrix_test_stats.surface_checks, (unsigned long long) matrix_test_stats.hash_checks,
+            (unsigned long long) matrix_test_stats.drop_checks,
+            (unsigned long long) matrix_test_stats.serialize_checks);
+    return EXIT_SUCCESS;
+}
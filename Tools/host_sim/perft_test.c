@@ -0,0 +1,180 @@
+/**
+ ******************************************************************************
+ * @file           : perft_test.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Placement perft of stored positions against a golden table
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+
+/*
+ * Reads positions and their expected placement_perft counts from a golden table (perft_golden.txt,
+ * the format is described at its top), counts every position to the depths listed and reports the
+ * placements per second. Exits with a failure on any count that differs from the table.
+ *
+ * Build and run with make perft in this directory, or e.g. ./perft_test -d 2 perft_golden.txt
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "main.h"
+#include "matrix.h"
+#include "placement.h"
+#include "tetrimino.h"
+
+#define PERFT_LINE_MAX (512)
+#define PERFT_EMPTY_STACK "-"
+
+static const char perft_piece_letter[] = "TJZOSLI"; // in tetrimino_piece_t order
+
+/**
+ * @brief  Read the host monotonic clock
+ * @param  None
+ * @retval Nanoseconds
+ */
+static uint64_t perft_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief  Parse the piece sequence of a table line
+ * @param  letters, pieces (output, PLACEMENT_PERFT_MAX_DEPTH entries)
+ * @retval Number of pieces kept, at most PLACEMENT_PERFT_MAX_DEPTH, 0 on an unknown letter
+ */
+static uint8_t perft_parse_pieces(const char *letters, tetrimino_piece_t *pieces) {
+    const char *letter;
+    uint8_t count = 0;
+
+    for (; *letters; letters++) {
+        letter = strchr(perft_piece_letter, *letters);
+        if (letter == NULL) {
+            return 0;
+        }
+        if (count < PLACEMENT_PERFT_MAX_DEPTH) {
+            pieces[count] = (tetrimino_piece_t) (letter - perft_piece_letter);
+        }
+        count++;
+    }
+    return count <= PLACEMENT_PERFT_MAX_DEPTH ? count : PLACEMENT_PERFT_MAX_DEPTH;
+}
+
+int main(int argc, char *argv[]) {
+    static matrix_t matrix;
+    tetrimino_piece_t pieces[PLACEMENT_PERFT_MAX_DEPTH];
+    tetrimino_rotation_system_t rotation_system;
+    char line[PERFT_LINE_MAX];
+    char name[64], system[8], letters[32], stack[PERFT_LINE_MAX];
+    const char *path = "perft_golden.txt";
+    int max_depth = PLACEMENT_PERFT_MAX_DEPTH;
+    unsigned long long expected;
+    uint64_t count, ns, total_count = 0, total_ns = 0;
+    uint8_t piece_count;
+    int offset, consumed, depth, line_number = 0, checked = 0, failed = 0;
+    FILE *file;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:")) != -1) {
+        switch (opt) {
+        case 'd':
+            max_depth = (int) strtol(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-d max_depth] [golden_table]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind < argc) {
+        path = argv[optind];
+    }
+
+    file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot read golden table %s\n", path);
+        return EXIT_FAILURE;
+    }
+
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        if (line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0') {
+            continue;
+        }
+        if (sscanf(line, "%63s %7s %31s %511s%n", name, system, letters, stack, &offset) != 4) {
+            fprintf(stderr, "%s:%d: expected name, rotation system, pieces and stack\n", path, line_number);
+            failed++;
+            continue;
+        }
+
+        if (strcmp(system, "NES") == 0) {
+            rotation_system = TETRIMINO_ROTATION_SYSTEM_NES;
+        } else if (strcmp(system, "SRS") == 0) {
+            rotation_system = TETRIMINO_ROTATION_SYSTEM_SRS;
+        } else {
+            fprintf(stderr, "%s:%d: unknown rotation system %s\n", path, line_number, system);
+            failed++;
+            continue;
+        }
+        piece_count = perft_parse_pieces(letters, pieces);
+        if (piece_count == 0) {
+            fprintf(stderr, "%s:%d: bad piece sequence %s\n", path, line_number, letters);
+            failed++;
+            continue;
+        }
+        if (strcmp(stack, PERFT_EMPTY_STACK) == 0) {
+            stack[0] = '\0';
+        }
+        if (matrix_deserialize_text(&matrix, stack) != MATRIX_OK) {
+            fprintf(stderr, "%s:%d: stack does not fit a %dx%d playfield\n", path, line_number, PLAYING_FIELD_WIDTH,
+                    PLAYING_FIELD_HEIGHT);
+            failed++;
+            continue;
+        }
+
+        // The counts follow, one per depth from 1
+        for (depth = 1; sscanf(line + offset, "%llu%n", &expected, &consumed) == 1; depth++) {
+            offset += consumed;
+            if (depth > piece_count || depth > max_depth) {
+                continue;
+            }
+            ns = perft_now_ns();
+            count = placement_perft(&matrix, pieces, depth, rotation_system);
+            ns = perft_now_ns() - ns;
+            total_count += count;
+            total_ns += ns;
+            checked++;
+
+            printf("%-12s %s depth %d %10llu %s %8.2f M placements/s\n", name, system, depth,
+                    (unsigned long long) count, count == expected ? "ok      " : "MISMATCH",
+                    ns ? count * 1e3 / ns : 0.0);
+            if (count != expected) {
+                fprintf(stderr, "%s:%d: %s %s depth %d counted %llu, expected %llu\n", path, line_number, name,
+                        system, depth, (unsigned long long) count, expected);
+                failed++;
+            }
+        }
+    }
+    fclose(file);
+
+    printf("%d counts checked, %d failed, %.2f M placements/s overall\n", checked, failed,
+            total_ns ? total_count * 1e3 / total_ns : 0.0);
+    return failed || checked == 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
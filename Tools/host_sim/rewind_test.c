@@ -0,0 +1,341 @@
+/**
+ ******************************************************************************
+ * @file           : rewind_test.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Host test of the practice rewind buffer against saved copies of the stack
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+/*
+ * Drops pieces on matrix.c, mostly on their lowest landing spot so lines clear, locks, clears and
+ * compacts like tetris_engine.c, and pushes a snapshot into rewind.c after every lock. A copy of the
+ * matrix is kept after each lock. Now and then 1 up to every stored piece is stepped back with
+ * rewind_restore, and the stack, the palette planes, the surface and the hash must match the copy of
+ * the matrix from before those locks, and the piece to play again must be the oldest one undone.
+ *
+ * Half of the games start on garbage rows, so rewind_init also starts from a stack that is not empty,
+ * and the bottom rows are dropped after each lock to keep the stack at that height. Every row moves, so
+ * their snapshots fill REWIND_MAX_ROWS before REWIND_MAX_PIECES are stored.
+ *
+ * The number of stored pieces is checked against a model of the two rings, which drops the oldest piece
+ * when REWIND_MAX_PIECES are stored or when the delta rows would not fit in REWIND_MAX_ROWS. Games are
+ * long enough that both rings wrap and both limits evict pieces, the test fails if one of them never does.
+ *
+ * Exits with a failure on the first mismatch. Build and run with make check in this directory, or e.g.
+ * ./rewind_test -n 1000000 -s 7
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "main.h"
+#include "matrix.h"
+#include "tetrimino.h"
+#include "tetrimino_shape.h"
+#include "rewind.h"
+
+#define REWIND_TEST_DEFAULT_LOCKS (200000)
+#define REWIND_TEST_GAME_LOCKS (1000) // a game that has not topped out ends after this many locks
+#define REWIND_TEST_SAVED (REWIND_MAX_PIECES + 1) // the stack before the oldest stored piece and after each
+
+typedef struct {
+    uint64_t locks;
+    uint64_t line_clears;
+    uint64_t top_outs;
+    uint64_t tall_games;
+    uint64_t restores;
+    uint64_t pieces_restored;
+    uint64_t piece_evictions; // oldest piece dropped as REWIND_MAX_PIECES were stored
+    uint64_t row_evictions; // oldest piece dropped as its delta rows were needed
+    uint64_t rows_pushed;
+} rewind_test_stats_t;
+
+// Copy of the matrix after each lock of the current game, by lock number modulo REWIND_TEST_SAVED
+static matrix_t rewind_test_saved[REWIND_TEST_SAVED];
+static tetrimino_piece_t rewind_test_piece[REWIND_TEST_SAVED]; // piece of that lock
+static uint8_t rewind_test_rows[REWIND_TEST_SAVED]; // delta rows of that lock
+
+// Model of the rings, the stored pieces are the locks after oldest up to locks
+static uint32_t rewind_test_lock_count;
+static uint32_t rewind_test_oldest;
+static uint16_t rewind_test_row_count;
+
+// Height of the stack of the games started on garbage rows
+#define REWIND_TEST_TALL_HEIGHT (PLAYING_FIELD_HEIGHT * 3 / 5)
+static uint8_t rewind_test_tall;
+
+static rewind_test_stats_t rewind_test_stats;
+
+/**
+ * @brief  Print the stack and stop the test on a mismatch
+ * @param  matrix, what was checked
+ * @retval None
+ */
+static void rewind_test_fail(matrix_t *matrix, const char *check) {
+    char text[MATRIX_TEXT_MAX_SIZE];
+
+    matrix_serialize_text(matrix, text, sizeof(text));
+    fprintf(stderr, "%s mismatch at lock %lu of the game, lock %llu of the test\nstack: \"%s\"\n", check,
+            (unsigned long) rewind_test_lock_count, (unsigned long long) rewind_test_stats.locks, text);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief  Start a game on an empty stack or on garbage rows, with an empty rewind buffer
+ * @param  matrix, rewind object
+ * @retval None
+ */
+static void rewind_test_new_game(matrix_t *matrix, rewind_t *rewind) {
+    matrix_init(matrix);
+    rewind_test_tall = rand() % 2;
+    if (rewind_test_tall) {
+        matrix_add_garbage(matrix, NULL, REWIND_TEST_TALL_HEIGHT, rand() % PLAYING_FIELD_WIDTH);
+        rewind_test_stats.tall_games++;
+    }
+    rewind_init(rewind, matrix);
+    rewind_test_lock_count = 0;
+    rewind_test_oldest = 0;
+    rewind_test_row_count = 0;
+    memcpy(&rewind_test_saved[0], matrix, sizeof(matrix_t));
+}
+
+/**
+ * @brief  Count the rows whose stack or palette changed between two matrices, the delta rows of a lock
+ * @param  matrix before, matrix after
+ * @retval Number of rows
+ */
+static uint8_t rewind_test_changed_rows(matrix_t *before, matrix_t *after) {
+    uint8_t changed = 0;
+
+    for (int i = 0; i < MATRIX_DATA_SIZE; i++) {
+        if (before->stack[i] != after->stack[i]) {
+            changed++;
+            continue;
+        }
+        for (int plane = 0; plane < MATRIX_PALETTE_PLANES; plane++) {
+            if (before->palette[plane][i] != after->palette[plane][i]) {
+                changed++;
+                break;
+            }
+        }
+    }
+    return changed;
+}
+
+/**
+ * @brief  Move the piece over its lowest landing spot, or a random one that fits, and drop it
+ * @param  matrix, tetrimino
+ * @retval None
+ */
+static void rewind_test_place(matrix_t *matrix, tetrimino_t *tetrimino) {
+    tetrimino_t candidate = *tetrimino;
+    int best_y = PLAYING_FIELD_HEIGHT + TETRIMINO_CENTER_Y;
+    uint8_t lowest = rand() % 16 != 0;
+
+    for (int rotation = 0; rotation < TETRIMINO_ROTATION_COUNT; rotation++) {
+        for (int x = 0; x < PLAYING_FIELD_WIDTH; x++) {
+            candidate.rotation = rotation;
+            candidate.shape_offset = tetrimino_shape_offset_lut[candidate.piece][rotation];
+            candidate.x = x;
+            candidate.y = tetrimino->y;
+            if (matrix_piece_fits(matrix, candidate.piece, candidate.rotation, candidate.x, candidate.y)
+                    != MATRIX_OK) {
+                continue;
+            }
+            candidate.y -= matrix_drop_distance(matrix, &candidate);
+            // Ties broken at random so the stack does not lean to one side
+            if (lowest ? candidate.y < best_y || (candidate.y == best_y && rand() % 2) :
+                    best_y == PLAYING_FIELD_HEIGHT + TETRIMINO_CENTER_Y || rand() % 8 == 0) {
+                best_y = candidate.y;
+                tetrimino->rotation = candidate.rotation;
+                tetrimino->x = candidate.x;
+            }
+        }
+    }
+    tetrimino->y = best_y;
+    tetrimino->shape_offset = tetrimino_shape_offset_lut[tetrimino->piece][tetrimino->rotation];
+}
+
+/**
+ * @brief  Lock the piece, clear and compact the full rows like tetris_engine.c, then take a snapshot
+ * @param  matrix, tetrimino, rewind object
+ * @retval None
+ */
+static void rewind_test_lock(matrix_t *matrix, tetrimino_t *tetrimino, rewind_t *rewind) {
+    matrix_t *before = &rewind_test_saved[rewind_test_lock_count % REWIND_TEST_SAVED];
+    uint32_t line_clear;
+    uint8_t changed;
+
+    matrix_add_tetrimino(matrix, tetrimino);
+    merge_with_stack(matrix, tetrimino);
+    matrix_reset_playfield(matrix);
+    line_clear = matrix_check_line_clear(matrix);
+    if (line_clear) {
+        matrix_line_clear_start(matrix, CLEAR_LINE_DELAY_FRAMES);
+        while (!matrix_line_clear_animate(matrix, line_clear, CLEAR_LINE_DELAY_FRAMES)) {
+        }
+        matrix_reposition_blocks(matrix, line_clear);
+        rewind_test_stats.line_clears++;
+    }
+    if (rewind_test_tall && matrix->surface.max_height > REWIND_TEST_TALL_HEIGHT) {
+        // The bottom rows go and every row above moves down, they are not full so the surface is rebuilt
+        matrix_reposition_blocks(matrix, (1UL << (matrix->surface.max_height - REWIND_TEST_TALL_HEIGHT)) - 1);
+        matrix_surface_recompute(matrix);
+    }
+
+    // The model makes room the same way, the piece limit first
+    changed = rewind_test_changed_rows(before, matrix);
+    while (rewind_test_lock_count - rewind_test_oldest == REWIND_MAX_PIECES
+            || rewind_test_row_count + changed > REWIND_MAX_ROWS) {
+        if (rewind_test_lock_count - rewind_test_oldest == REWIND_MAX_PIECES) {
+            rewind_test_stats.piece_evictions++;
+        } else {
+            rewind_test_stats.row_evictions++;
+        }
+        rewind_test_oldest++;
+        rewind_test_row_count -= rewind_test_rows[rewind_test_oldest % REWIND_TEST_SAVED];
+    }
+
+    rewind_push(rewind, matrix, tetrimino->piece);
+    rewind_test_lock_count++;
+    memcpy(&rewind_test_saved[rewind_test_lock_count % REWIND_TEST_SAVED], matrix, sizeof(matrix_t));
+    rewind_test_piece[rewind_test_lock_count % REWIND_TEST_SAVED] = tetrimino->piece;
+    rewind_test_rows[rewind_test_lock_count % REWIND_TEST_SAVED] = changed;
+    rewind_test_row_count += changed;
+    rewind_test_stats.rows_pushed += changed;
+    rewind_test_stats.locks++;
+
+    if (rewind_count(rewind) != rewind_test_lock_count - rewind_test_oldest) {
+        fprintf(stderr, "%u pieces stored, %lu expected\n", rewind_count(rewind),
+                (unsigned long) (rewind_test_lock_count - rewind_test_oldest));
+        rewind_test_fail(matrix, "stored pieces");
+    }
+}
+
+/**
+ * @brief  Step back a random number of the stored pieces and compare with the saved matrix
+ * @param  matrix, rewind object
+ * @retval Piece to play again
+ */
+static tetrimino_piece_t rewind_test_restore(matrix_t *matrix, rewind_t *rewind) {
+    uint16_t stored = rewind_count(rewind);
+    uint8_t pieces = rand() % 4 ? 1 + rand() % (stored < 4 ? stored : 4) : 1 + rand() % stored;
+    matrix_t *saved = &rewind_test_saved[(rewind_test_lock_count - pieces) % REWIND_TEST_SAVED];
+    tetrimino_piece_t piece;
+
+    if (rewind_restore(rewind, matrix, 0, &piece) != REWIND_EMPTY
+            || rewind_restore(rewind, matrix, stored + 1, &piece) != REWIND_EMPTY) {
+        rewind_test_fail(matrix, "restore past the stored pieces");
+    }
+    if (rewind_restore(rewind, matrix, pieces, &piece) != REWIND_OK) {
+        rewind_test_fail(matrix, "restore status");
+    }
+    if (piece != rewind_test_piece[(rewind_test_lock_count - pieces + 1) % REWIND_TEST_SAVED]) {
+        rewind_test_fail(matrix, "piece to play again");
+    }
+    if (memcmp(matrix->stack, saved->stack, sizeof(matrix->stack))) {
+        rewind_test_fail(matrix, "restored stack");
+    }
+    if (memcmp(matrix->palette, saved->palette, sizeof(matrix->palette))) {
+        rewind_test_fail(matrix, "restored palette");
+    }
+    if (memcmp(&matrix->surface, &saved->surface, sizeof(matrix_surface_t))) {
+        rewind_test_fail(matrix, "restored surface");
+    }
+    if (matrix->stack_hash != saved->stack_hash) {
+        rewind_test_fail(matrix, "restored stack hash");
+    }
+
+    for (uint8_t n = 0; n < pieces; n++) {
+        rewind_test_row_count -= rewind_test_rows[rewind_test_lock_count % REWIND_TEST_SAVED];
+        rewind_test_lock_count--;
+    }
+    if (rewind_count(rewind) != stored - pieces) {
+        rewind_test_fail(matrix, "stored pieces after a restore");
+    }
+    rewind_test_stats.restores++;
+    rewind_test_stats.pieces_restored += pieces;
+
+    return piece;
+}
+
+int main(int argc, char *argv[]) {
+    static matrix_t matrix;
+    static rewind_t rewind;
+    tetrimino_t tetrimino;
+    uint64_t locks = REWIND_TEST_DEFAULT_LOCKS;
+    unsigned int seed = 1;
+    tetrimino_piece_t piece;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+        case 'n':
+            locks = strtoull(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n locks] [-s seed]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    srand(seed);
+    rewind_test_new_game(&matrix, &rewind);
+    piece = rand() % TETRIMINO_COUNT;
+
+    while (rewind_test_stats.locks < locks) {
+        tetrimino_spawn_piece(&tetrimino, piece);
+        if (matrix_piece_fits(&matrix, tetrimino.piece, tetrimino.rotation, tetrimino.x, tetrimino.y) != MATRIX_OK) {
+            rewind_test_stats.top_outs++;
+            rewind_test_new_game(&matrix, &rewind);
+            continue;
+        }
+        if (rewind_test_lock_count == REWIND_TEST_GAME_LOCKS) {
+            rewind_test_new_game(&matrix, &rewind);
+        }
+        rewind_test_place(&matrix, &tetrimino);
+        rewind_test_lock(&matrix, &tetrimino, &rewind);
+
+        // Most steps back are short, like a player undoing a mistake, some go back as far as possible
+        if (rewind_count(&rewind) && rand() % 32 == 0) {
+            piece = rewind_test_restore(&matrix, &rewind);
+        } else {
+            piece = rand() % TETRIMINO_COUNT;
+        }
+    }
+
+    if (rewind_test_stats.piece_evictions == 0 || rewind_test_stats.row_evictions == 0) {
+        fprintf(stderr, "%llu evictions by pieces, %llu by rows, both limits must be reached\n",
+                (unsigned long long) rewind_test_stats.piece_evictions,
+                (unsigned long long) rewind_test_stats.row_evictions);
+        return EXIT_FAILURE;
+    }
+
+    printf("%llu locks, %llu line clears, %llu top outs, %llu tall games, %llu delta rows\n",
+            (unsigned long long) rewind_test_stats.locks, (unsigned long long) rewind_test_stats.line_clears,
+            (unsigned long long) rewind_test_stats.top_outs, (unsigned long long) rewind_test_stats.tall_games,
+            (unsigned long long) rewind_test_stats.rows_pushed);
+    printf("%llu restores of %llu pieces passed, %llu evictions by pieces, %llu by rows\n",
+            (unsigned long long) rewind_test_stats.restores, (unsigned long long) rewind_test_stats.pieces_restored,
+            (unsigned long long) rewind_test_stats.piece_evictions,
+            (unsigned long long) rewind_test_stats.row_evictions);
+    return EXIT_SUCCESS;
+}
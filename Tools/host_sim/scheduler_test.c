@@ -0,0 +1,231 @@
+/**
+ ******************************************************************************
+ * @file           : scheduler_test.c
+ * @author         : Dr. Joshua Butler
+ * @date           : Oct 16, 2026
+ * @brief          : Host test of the cooperative scheduler on a fake clock
+ ******************************************************************************
+ * @attention
+ *
+ * 2025 Imagine RIT Project: Classic Tetris on LED Grid
+ *
+ * Copyright (c) 2024-25 Rochester Institute of Technology.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+
+/*
+ * Drives scheduler.c with a fake microsecond clock that only moves when a task runs or the test
+ * advances it, starting just before the 32-bit wrap so every check also crosses it. Covers the
+ * priority order, the release grid, deadline misses, skipped releases, the next release time and the
+ * interrupt time taken out of the idle time.
+ *
+ * Exits with a failure on the first failed check. Build and run with make check in this directory.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "scheduler.h"
+
+#define SCHEDULER_TEST_START (0xFFFFFF00UL) // fake clock start, 256 us before the wrap
+#define SCHEDULER_TEST_TASKS (4)
+
+// Stop on a failed check with the line and the condition
+#define SCHEDULER_TEST_CHECK(condition) do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+        scheduler_test_checks++; \
+    } while (0)
+
+typedef struct {
+    char letter; // written to the run order
+    uint32_t cost; // microseconds added to the fake clock per run
+} scheduler_test_task_t;
+
+static uint32_t scheduler_test_now;
+static char scheduler_test_order[64];
+static uint8_t scheduler_test_order_length;
+static uint32_t scheduler_test_checks;
+
+/**
+ * @brief  Fake clock of the scheduler
+ * @param  None
+ * @retval Microseconds
+ */
+static uint32_t scheduler_test_clock(void) {
+    return scheduler_test_now;
+}
+
+/**
+ * @brief  Task body, records the run and takes its cost off the fake clock
+ * @param  scheduler_test_task_t
+ * @retval None
+ */
+static void scheduler_test_run(void *context) {
+    scheduler_test_task_t *test_task = context;
+
+    if (scheduler_test_order_length < sizeof(scheduler_test_order) - 1) {
+        scheduler_test_order[scheduler_test_order_length++] = test_task->letter;
+    }
+    scheduler_test_now += test_task->cost;
+}
+
+/**
+ * @brief  Fake sleep, woken by a 100 us tick whose handler takes 5 us
+ * @param  wake_time, unused as the tick always comes first in the test
+ * @retval Microseconds in the handler
+ */
+static uint32_t scheduler_test_sleep(uint32_t wake_time) {
+    (void) wake_time;
+    scheduler_test_now += 100;
+    return 5;
+}
+
+/**
+ * @brief  Find a task by name after scheduler_init sorted the table
+ * @param  scheduler, name
+ * @retval Task
+ */
+static scheduler_task_t* scheduler_test_find(scheduler_t *scheduler, const char *name) {
+    for (uint8_t i = 0; i < scheduler->task_count; i++) {
+        if (strcmp(scheduler->tasks[i].name, name) == 0) {
+            return &scheduler->tasks[i];
+        }
+    }
+    fprintf(stderr, "no task %s\n", name);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief  Bad tables and clocks are refused
+ * @param  None
+ * @retval None
+ */
+static void scheduler_test_init_errors(void) {
+    scheduler_test_task_t test_task = { 'a', 0 };
+    scheduler_task_t tasks[2] = {
+        { .name = "a", .run = scheduler_test_run, .context = &test_task },
+        { .name = "b", .run = NULL } };
+    scheduler_t scheduler;
+    uint32_t wake;
+
+    SCHEDULER_TEST_CHECK(scheduler_init(&scheduler, tasks, 1, NULL) == SCHEDULER_ERROR);
+    SCHEDULER_TEST_CHECK(scheduler_init(&scheduler, tasks, 2, scheduler_test_clock) == SCHEDULER_ERROR);
+    SCHEDULER_TEST_CHECK(scheduler_init(&scheduler, tasks, 0, scheduler_test_clock) == SCHEDULER_OK);
+    SCHEDULER_TEST_CHECK(scheduler_next_release(&scheduler, &wake) == SCHEDULER_ERROR);
+}
+
+/**
+ * @brief  Priority order, release grid, deadlines and skipped releases across the clock wrap
+ * @param  None
+ * @retval None
+ */
+static void scheduler_test_periodic(void) {
+    scheduler_test_task_t test_task[SCHEDULER_TEST_TASKS] = { { 'c', 30 }, { 'a', 10 }, { 'b', 20 }, { 'd', 1 } };
+    scheduler_task_t tasks[SCHEDULER_TEST_TASKS] = {
+        { .name = "c", .run = scheduler_test_run, .context = &test_task[0], .period = 1000, .priority = 2 },
+        { .name = "a", .run = scheduler_test_run, .context = &test_task[1], .period = 100, .priority = 0,
+                .deadline = 50 },
+        { .name = "b", .run = scheduler_test_run, .context = &test_task[2], .period = 300, .phase = 150,
+                .priority = 1 },
+        { .name = "d", .run = scheduler_test_run, .context = &test_task[3], .period = 0, .priority = 2 } };
+    scheduler_t scheduler;
+    scheduler_task_t *a, *b, *c, *d;
+    uint32_t start, wake;
+
+    scheduler_test_now = SCHEDULER_TEST_START;
+    start = scheduler_test_now;
+    SCHEDULER_TEST_CHECK(
+            scheduler_init(&scheduler, tasks, SCHEDULER_TEST_TASKS, scheduler_test_clock) == SCHEDULER_OK);
+
+    // Sorted by priority, c and d keep their table order
+    SCHEDULER_TEST_CHECK(strcmp(tasks[0].name, "a") == 0 && strcmp(tasks[1].name, "b") == 0);
+    SCHEDULER_TEST_CHECK(strcmp(tasks[2].name, "c") == 0 && strcmp(tasks[3].name, "d") == 0);
+    a = scheduler_test_find(&scheduler, "a");
+    b = scheduler_test_find(&scheduler, "b");
+    c = scheduler_test_find(&scheduler, "c");
+    d = scheduler_test_find(&scheduler, "d");
+
+    // a and c are due at once, b at its phase, d on every dispatch
+    SCHEDULER_TEST_CHECK(scheduler_dispatch(&scheduler) == 3);
+    SCHEDULER_TEST_CHECK(strcmp(scheduler_test_order, "acd") == 0);
+    SCHEDULER_TEST_CHECK(scheduler_next_release(&scheduler, &wake) == SCHEDULER_OK);
+    SCHEDULER_TEST_CHECK(wake == d->release_time);
+
+    // 3000 us past the wrap, one microsecond between dispatches
+    while (scheduler_test_now - start < 3000) {
+        scheduler_dispatch(&scheduler);
+        scheduler_test_now++;
+    }
+
+    // Releases stay on the grid of the period whatever the run times, so the counts are exact
+    SCHEDULER_TEST_CHECK(a->stats.runs == 30);
+    SCHEDULER_TEST_CHECK(b->stats.runs == 10);
+    SCHEDULER_TEST_CHECK(c->stats.runs == 3);
+    SCHEDULER_TEST_CHECK((a->release_time - start) % a->period == 0);
+    SCHEDULER_TEST_CHECK((b->release_time - start) % b->period == b->phase);
+    SCHEDULER_TEST_CHECK(a->stats.run_time_worst == 10 && scheduler_task_average(b) == 20);
+    SCHEDULER_TEST_CHECK(a->stats.deadline_misses == 0 && b->stats.releases_skipped == 0);
+    SCHEDULER_TEST_CHECK(d->stats.runs > a->stats.runs);
+
+    // The next release is the nearest one even when it is past the wrap and the others are not
+    d->period = 1000;
+    d->release_time = scheduler_test_now + 500;
+    scheduler_next_release(&scheduler, &wake);
+    SCHEDULER_TEST_CHECK(wake == a->release_time);
+
+    // a overruns to 355 us after its release: a deadline miss and the 3 passed releases dropped
+    scheduler_reset_stats(&scheduler);
+    SCHEDULER_TEST_CHECK(a->stats.runs == 0 && scheduler.load.busy_time == 0);
+    scheduler_test_now = a->release_time + 5;
+    start = a->release_time;
+    test_task[1].cost = 350;
+    scheduler_dispatch(&scheduler);
+    SCHEDULER_TEST_CHECK(a->stats.deadline_misses == 1);
+    SCHEDULER_TEST_CHECK(a->stats.releases_skipped == 3);
+    SCHEDULER_TEST_CHECK(a->release_time == start + 400);
+}
+
+/**
+ * @brief  Handler time during a sleep is busy, the rest of the sleep is idle
+ * @param  None
+ * @retval None
+ */
+static void scheduler_test_idle(void) {
+    scheduler_t scheduler;
+    uint32_t start;
+
+    scheduler_test_now = SCHEDULER_TEST_START;
+    start = scheduler_test_now;
+    SCHEDULER_TEST_CHECK(scheduler_init(&scheduler, NULL, 0, scheduler_test_clock) == SCHEDULER_OK);
+
+    // 100 us busy, then 10 ticks until the wake time past the wrap, each with 5 us in the handler
+    scheduler_test_now += 100;
+    scheduler_idle(&scheduler, start + 1100, scheduler_test_sleep);
+    SCHEDULER_TEST_CHECK(scheduler_test_now == start + 1100);
+    SCHEDULER_TEST_CHECK(scheduler.load.busy_time == 150 && scheduler.load.idle_time == 950);
+
+    // A wake time already reached does not sleep
+    scheduler_idle(&scheduler, start, scheduler_test_sleep);
+    SCHEDULER_TEST_CHECK(scheduler_test_now == start + 1100);
+    SCHEDULER_TEST_CHECK(scheduler_load(&scheduler) == 150 * 1000 / 1100);
+}
+
+int main(void) {
+    scheduler_test_init_errors();
+    scheduler_test_periodic();
+    scheduler_test_idle();
+
+    printf("%lu scheduler checks passed\n", (unsigned long) scheduler_test_checks);
+    return EXIT_SUCCESS;
+}